@@ -0,0 +1,112 @@
+#include <cstdint>
+#include <memory_resource>
+#include <random>
+
+#include "goya/alloc_tracker.hpp"
+#include "goya/b_spline.hpp"
+#include "goya/frame_arena.hpp"
+#include "goya/job_system.hpp"
+#include "goya/particles.hpp"
+#include "suites.hpp"
+
+namespace goya::bench {
+
+namespace detail {
+
+auto constexpr kArenaPushes = std::uint64_t(1000U);
+
+auto constexpr kSteadyParticles = std::size_t(100000U);
+auto constexpr kSteadyDelta = 1.f / 120.f;
+auto constexpr kWarmUpFrames = 600;
+auto constexpr kMeasuredFrames = 240;
+
+template <class Vector>
+auto PushInts(Vector& dst) -> void {
+  for (auto i = std::uint64_t(0U); i < kArenaPushes; ++i) {
+    dst.push_back(i);
+  }
+}
+
+}  // namespace detail
+
+// The steady state metrics count heap allocations per frame after a warm up,
+// anything but zero means a hot path started allocating again.
+auto RunAllocBenchmarks(Harness& harness, SuiteConfig const& config) -> void {
+  auto arena = FrameArena();
+  harness.Run("alloc/frame_arena/pmr_vector_1000", detail::kArenaPushes,
+              [&]() -> void {
+                arena.Reset();
+                auto ints = std::pmr::vector<std::uint64_t>(&arena);
+                detail::PushInts(ints);
+                DoNotOptimize(ints.data());
+              });
+
+  harness.Run("alloc/new_delete/pmr_vector_1000", detail::kArenaPushes,
+              [&]() -> void {
+                auto ints = std::pmr::vector<std::uint64_t>(
+                    std::pmr::new_delete_resource());
+                detail::PushInts(ints);
+                DoNotOptimize(ints.data());
+              });
+
+  auto spline = CubeBSpline(
+      LoadControloPoints(config.resources_dir + "/points.txt"), nullptr);
+  harness.Run("alloc/frame_arena/spline_points", 1U, [&]() -> void {
+    arena.Reset();
+    auto const points = spline.SplinePoints(&arena);
+    DoNotOptimize(points.data());
+  });
+
+  if (!AllocTracker::Enabled() ||
+      !harness.Enabled("alloc/steady_state/simulation")) {
+    return;
+  }
+
+  // mirrors the simulation tasks of the demo
+  auto jobs = JobSystem();
+  auto rng = std::minstd_rand(42);
+  auto dis = std::uniform_real_distribution<float>(-1.f, 1.f);
+  auto effect = ParticleEffect(
+      nullptr,
+      [&]() -> Particle {
+        auto dst = Particle();
+        dst.position = glm::vec3(0.f);
+        dst.velocity = glm::vec3(dis(rng), 4.f + dis(rng), dis(rng));
+        dst.color = glm::vec4(0.f, 0.22f, 0.33f, 1.f);
+        dst.life_len = 0.f;
+        return dst;
+      },
+      1.f, detail::kSteadyParticles);
+
+  auto snapshot = ParticleSnapshot();
+  auto const step = [&]() -> void {
+    effect.Update(detail::kSteadyDelta, jobs);
+    effect.Capture(snapshot);
+    spline.TimeUpdate(detail::kSteadyDelta);
+    DoNotOptimize(spline.ModelMatrix());
+  };
+
+  for (auto i = 0; i < detail::kWarmUpFrames; ++i) {
+    step();
+  }
+
+  auto const before = GlobalAllocTracker().Totals();
+  for (auto i = 0; i < detail::kMeasuredFrames; ++i) {
+    step();
+  }
+  auto const after = GlobalAllocTracker().Totals();
+
+  auto const allocs_per_frame =
+      static_cast<double>(after.allocations - before.allocations) /
+      detail::kMeasuredFrames;
+  harness.Metric("alloc/steady_state/simulation", allocs_per_frame,
+                 "allocations/frame");
+  harness.Metric("alloc/steady_state/simulation_bytes",
+                 static_cast<double>(after.bytes - before.bytes) /
+                     detail::kMeasuredFrames,
+                 "bytes/frame");
+  harness.Check("alloc/steady_state/simulation", allocs_per_frame <= 0.0,
+                "warmed up frames allocate");
+}
+
+}  // namespace goya::bench
@@ -0,0 +1,474 @@
+#include <chrono>
+#include <cmath>
+#include <filesystem>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include "GL/glew.h"
+#include "goya/alloc_tracker.hpp"
+#include "glm/gtc/matrix_transform.hpp"
+#include "goya/b_spline.hpp"
+#include "goya/camera.hpp"
+#include "goya/frame_capture.hpp"
+#include "goya/geometry_arena.hpp"
+#include "goya/instanced_model.hpp"
+#include "goya/mesh.hpp"
+#include "goya/mesh_loader.hpp"
+#include "goya/model.hpp"
+#include "goya/particles.hpp"
+#include "goya/render_queue.hpp"
+#include "goya/spline_renderer.hpp"
+#include "goya/window.hpp"
+#include "suites.hpp"
+
+namespace goya::bench {
+
+namespace detail {
+
+auto constexpr kWidth = 1280;
+auto constexpr kHeight = 720;
+auto constexpr kFarPlane = 200.f;
+
+auto constexpr kParticles = std::size_t(100000U);
+auto constexpr kInstances = std::size_t(10000U);
+auto constexpr kQueueModels = std::size_t(1000U);
+auto constexpr kCurves = std::size_t(1000U);
+auto constexpr kCurvePoints = std::size_t(12U);
+
+// static cubes drawn one by one or out of one arena, every second one is
+// freed before a defragmentation
+auto constexpr kArenaMeshes = std::size_t(1000U);
+auto constexpr kDefragRounds = 10;
+
+// a helix of control points edited in the middle
+auto constexpr kEditPoints = std::size_t(100000U);
+auto constexpr kEditAt = kEditPoints / 2U;
+
+auto constexpr kWarmUpFrames = 120;
+auto constexpr kMeasuredFrames = 120;
+
+// every captured frame is a file, so fewer of them
+auto constexpr kCaptureFrames = 60;
+
+}  // namespace detail
+
+// Every iteration ends with glFinish, so timings cover the gpu work and not
+// just command submission. Under llvmpipe the gpu is the cpu.
+auto RunGlBenchmarks(Harness& harness, SuiteConfig const& config) -> void {
+  if (!config.gl) {
+    return;
+  }
+
+  auto win = Window(detail::kWidth, detail::kHeight, "goya_bench",
+                    WindowMode::kHeadless);
+
+  auto model_shader =
+      std::make_shared<Shader>("shaders/model.vs", "shaders/model.fs");
+  auto particle_shader =
+      std::make_shared<Shader>("shaders/particle.vs", "shaders/particle.fs");
+  auto instanced_shader = std::make_shared<Shader>("shaders/instanced.vs",
+                                                   "shaders/instanced.fs");
+  auto spline_shader = std::make_shared<Shader>(
+      "shaders/spline.vs", "shaders/spline.tcs", "shaders/spline.tes",
+      "shaders/model.fs");
+
+  auto camera = Camera(
+      glm::vec3(0.f, 0.f, 4.f), glm::vec3(0.f, 0.f, -1.f),
+      glm::vec3(0.f, 1.f, 0.f),
+      glm::perspective(glm::radians(90.f), win.AspectRatio(), 0.1f,
+                       detail::kFarPlane));
+  camera.AddShader(model_shader);
+  camera.AddShader(particle_shader);
+  camera.AddShader(instanced_shader);
+  camera.AddShader(spline_shader);
+  camera.Refresh();
+
+  auto const teddy = std::make_shared<MeshTriangle>(
+      LoadMeshObjData(config.resources_dir + "/mesh/teddy.obj"));
+  auto const cube_obj =
+      LoadMeshObjData(config.resources_dir + "/mesh/cube.obj");
+  auto const cube = std::make_shared<MeshTriangle>(cube_obj);
+
+  auto model = Model(model_shader, teddy);
+  harness.Run("gl/model_draw/teddy", 1U, [&]() -> void {
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    model.Draw();
+    glFinish();
+  });
+
+  auto rng = std::minstd_rand(42);
+  auto dis = std::uniform_real_distribution<float>(-1.f, 1.f);
+
+  auto effect = ParticleEffect(
+      particle_shader,
+      [&]() -> Particle {
+        auto dst = Particle();
+        dst.position = glm::vec3(0.f);
+        dst.velocity = glm::vec3(dis(rng), dis(rng), dis(rng));
+        dst.color = glm::vec4(0.f, 0.22f, 0.33f, 1.f);
+        dst.life_len = 0.f;
+        return dst;
+      },
+      1.f, detail::kParticles);
+  effect.SetScale(glm::scale(glm::mat4(1.f), glm::vec3(0.02f)));
+  for (auto i = 0; i < 240; ++i) {
+    effect.Update(1.f / 120.f);
+  }
+
+  harness.Run("gl/particles_upload_draw/100000", detail::kParticles,
+              [&]() -> void {
+                glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+                effect.Upload();
+                effect.Draw();
+                glFinish();
+              });
+
+  auto instanced = InstancedModel(instanced_shader, cube);
+  for (auto i = std::size_t(0U); i < detail::kInstances; ++i) {
+    auto const pos = glm::vec3(dis(rng), dis(rng), dis(rng)) * 20.f;
+    instanced.AddInstance(
+        glm::scale(glm::translate(glm::mat4(1.f), pos), glm::vec3(0.05f)),
+        glm::vec3(0.5f));
+  }
+
+  harness.Run("gl/instanced_draw/10000", detail::kInstances, [&]() -> void {
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    instanced.Draw();
+    glFinish();
+  });
+
+  // the same curves as CubeBSpline line models tessellated on the cpu, which
+  // also draw their control polygon and normals, and on the gpu
+  auto cpu_curves = std::vector<std::unique_ptr<CubeBSpline>>();
+  auto gpu_curves = SplineRenderer(spline_shader);
+  for (auto i = std::size_t(0U); i < detail::kCurves; ++i) {
+    auto points = std::vector<Vertex3d>();
+    for (auto k = std::size_t(0U); k < detail::kCurvePoints; ++k) {
+      points.emplace_back(glm::vec3(dis(rng), dis(rng), dis(rng)) * 3.f);
+    }
+
+    gpu_curves.AddCurve(points);
+    cpu_curves.push_back(
+        std::make_unique<CubeBSpline>(std::move(points), model_shader));
+  }
+
+  harness.Run("gl/spline_draw/cube_b_spline_1000", detail::kCurves,
+              [&]() -> void {
+                glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+                for (auto& curve : cpu_curves) {
+                  curve->Draw();
+                }
+                glFinish();
+              });
+
+  harness.Run("gl/spline_draw/tessellated_1000", detail::kCurves,
+              [&]() -> void {
+                glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+                gpu_curves.Draw();
+                glFinish();
+              });
+
+  auto cpu_vertices = std::size_t(0U);
+  for (auto const& curve : cpu_curves) {
+    cpu_vertices += curve->VertexCount() + curve->ControlPoints().size();
+  }
+
+  harness.Metric("gl/spline_draw/cube_b_spline_bytes",
+                 static_cast<double>(cpu_vertices * sizeof(Vertex3d)),
+                 "bytes");
+  harness.Metric("gl/spline_draw/tessellated_bytes",
+                 static_cast<double>(detail::kCurves * detail::kCurvePoints *
+                                         sizeof(Vertex3d) +
+                                     gpu_curves.PatchCount() * 4U *
+                                         sizeof(std::uint32_t)),
+                 "bytes");
+
+  // an edit re-tessellates and uploads the slots of four segments plus the
+  // control point, the rest of the line models stays on the gpu as is. the
+  // draw alone is the baseline of the edits
+  if (harness.Enabled("gl/spline_edit/draw_100000") ||
+      harness.Enabled("gl/spline_edit/move_100000") ||
+      harness.Enabled("gl/spline_edit/insert_remove_100000")) {
+    auto points = std::vector<Vertex3d>();
+    points.reserve(detail::kEditPoints);
+    for (auto i = std::size_t(0U); i < detail::kEditPoints; ++i) {
+      auto const angle = 0.5f * static_cast<float>(i);
+      points.emplace_back(std::cos(angle), std::sin(angle),
+                          -0.01f * static_cast<float>(i));
+    }
+
+    auto long_curve = CubeBSpline(points, model_shader);
+    auto offset = 0.f;
+
+    harness.Run("gl/spline_edit/draw_100000", 1U, [&]() -> void {
+      glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+      long_curve.Draw();
+      glFinish();
+    });
+
+    harness.Run("gl/spline_edit/move_100000", 1U, [&]() -> void {
+      offset = offset > 0.f ? -0.1f : 0.1f;
+      long_curve.SetControlPoint(detail::kEditAt,
+                                 points[detail::kEditAt] + offset);
+      glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+      long_curve.Draw();
+      glFinish();
+    });
+
+    harness.Run("gl/spline_edit/insert_remove_100000", 1U, [&]() -> void {
+      long_curve.InsertControlPoint(detail::kEditAt,
+                                    points[detail::kEditAt] + 0.1f);
+      long_curve.RemoveControlPoint(detail::kEditAt);
+      glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+      long_curve.Draw();
+      glFinish();
+    });
+  }
+
+  auto models = std::vector<std::unique_ptr<Model>>();
+  for (auto i = std::size_t(0U); i < detail::kQueueModels; ++i) {
+    auto& queued = models.emplace_back(
+        std::make_unique<Model>(model_shader, i % 2U ? teddy : cube));
+    queued->Translate(glm::vec3(dis(rng), dis(rng), dis(rng)) * 20.f);
+    queued->Scale(glm::vec3(0.1f));
+  }
+
+  auto queue = RenderQueue();
+  harness.Run("gl/render_queue/1000_models", detail::kQueueModels,
+              [&]() -> void {
+                glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+                queue.SetView(camera.Position(), camera.Front(),
+                              detail::kFarPlane);
+                for (auto& queued : models) {
+                  queued->Submit(queue);
+                }
+
+                queue.Execute();
+                glFinish();
+              });
+
+  // the same static cubes baked into world space, each with a vertex array
+  // of its own or sub allocated from an arena and drawn per mesh or at once
+  auto cube_soups = std::vector<std::vector<Vertex3d>>();
+  auto separate = std::vector<std::unique_ptr<MeshTriangle>>();
+  for (auto i = std::size_t(0U); i < detail::kArenaMeshes; ++i) {
+    auto const transform = glm::scale(
+        glm::translate(glm::mat4(1.f),
+                       glm::vec3(dis(rng), dis(rng), dis(rng)) * 20.f),
+        glm::vec3(0.1f));
+    auto vertices = cube_obj.vertices;
+    for (auto& vertex : vertices) {
+      vertex = glm::vec3(transform * glm::vec4(vertex, 1.f));
+    }
+
+    auto baked = MeshObjData(std::move(vertices),
+                             std::vector<Face>(cube_obj.faces));
+    cube_soups.push_back(goya::detail::TransformObjToVertices(baked));
+    separate.push_back(std::make_unique<MeshTriangle>(std::move(baked)));
+  }
+
+  auto const n_cube_vertices = cube_soups.front().size();
+  auto arena = std::make_shared<GeometryArena>(n_cube_vertices *
+                                               detail::kArenaMeshes);
+  auto arena_meshes = std::vector<std::unique_ptr<ArenaMesh>>();
+  auto batch = ArenaBatch(model_shader, arena, ArenaPrimitive::kTriangles);
+  for (auto const& soup : cube_soups) {
+    batch.Add(*arena_meshes.emplace_back(std::make_unique<ArenaMesh>(
+        arena, soup, ArenaPrimitive::kTriangles)));
+  }
+
+  auto const use_model_shader = [&]() -> void {
+    model_shader->Use();
+    model_shader->SetVec3("color", glm::vec3(0.88f));
+    model_shader->SetMat4("model", glm::mat4(1.f));
+  };
+
+  harness.Run("gl/arena/separate_draws_1000", detail::kArenaMeshes,
+              [&]() -> void {
+                glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+                use_model_shader();
+                for (auto& mesh : separate) {
+                  mesh->Draw();
+                }
+                glFinish();
+              });
+
+  harness.Run("gl/arena/per_mesh_draws_1000", detail::kArenaMeshes,
+              [&]() -> void {
+                glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+                use_model_shader();
+                for (auto& mesh : arena_meshes) {
+                  mesh->Draw();
+                }
+                glFinish();
+              });
+
+  harness.Run("gl/arena/multi_draw_1000", detail::kArenaMeshes,
+              [&]() -> void {
+                glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+                queue.SetView(camera.Position(), camera.Front(),
+                              detail::kFarPlane);
+                batch.Submit(queue);
+                queue.Execute();
+                glFinish();
+              });
+
+  // filling a presized arena against one that starts at a single cube and
+  // doubles, each step copies the live meshes on the gpu
+  harness.Run("gl/arena/allocate_reserved_1000", detail::kArenaMeshes,
+              [&]() -> void {
+                auto filled =
+                    GeometryArena(n_cube_vertices * detail::kArenaMeshes);
+                for (auto const& soup : cube_soups) {
+                  filled.Allocate(soup);
+                }
+                glFinish();
+              });
+
+  harness.Run("gl/arena/allocate_growing_1000", detail::kArenaMeshes,
+              [&]() -> void {
+                auto growing = GeometryArena(n_cube_vertices);
+                for (auto const& soup : cube_soups) {
+                  growing.Allocate(soup);
+                }
+                glFinish();
+              });
+
+  // only the compaction is timed, the arena is refilled between rounds
+  if (harness.Enabled("gl/arena/defragment_500_of_1000")) {
+    auto defrag_ms = 0.0;
+    auto contiguity = 0.f;
+    for (auto round = 0; round < detail::kDefragRounds; ++round) {
+      auto fragmented = GeometryArena(n_cube_vertices * detail::kArenaMeshes);
+      auto ids = std::vector<GeometryArena::MeshId>();
+      for (auto const& soup : cube_soups) {
+        ids.push_back(fragmented.Allocate(soup));
+      }
+      for (auto i = std::size_t(0U); i < ids.size(); i += 2U) {
+        fragmented.Free(ids[i]);
+      }
+      contiguity = fragmented.Contiguity();
+      glFinish();
+
+      auto const start = std::chrono::steady_clock::now();
+      fragmented.Defragment();
+      glFinish();
+      defrag_ms += std::chrono::duration<double, std::milli>(
+                       std::chrono::steady_clock::now() - start)
+                       .count();
+    }
+
+    harness.Metric("gl/arena/defragment_500_of_1000",
+                   defrag_ms / detail::kDefragRounds, "ms");
+    harness.Metric("gl/arena/contiguity_before_defragment",
+                   static_cast<double>(contiguity));
+  }
+
+  // headless frames end with glFinish like Window::Present, captured through
+  // a blocking glReadPixels and through the pixel buffer ring
+  if (harness.Enabled("gl/capture/none_1000_models") ||
+      harness.Enabled("gl/capture/read_pixels_1000_models") ||
+      harness.Enabled("gl/capture/pbo_ring_png_1000_models") ||
+      harness.Enabled("gl/capture/encode_png_720p")) {
+    auto const draw = [&]() -> void {
+      glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+      queue.SetView(camera.Position(), camera.Front(), detail::kFarPlane);
+      for (auto& queued : models) {
+        queued->Submit(queue);
+      }
+
+      queue.Execute();
+    };
+
+    auto const frame_ms = [&](auto const& capture) -> double {
+      auto const start = std::chrono::steady_clock::now();
+      for (auto i = 0; i < detail::kCaptureFrames; ++i) {
+        draw();
+        capture();
+        glFinish();
+      }
+
+      return std::chrono::duration<double, std::milli>(
+                 std::chrono::steady_clock::now() - start)
+                 .count() /
+             detail::kCaptureFrames;
+    };
+
+    harness.Metric("gl/capture/none_1000_models",
+                   frame_ms([]() -> void {}), "ms/frame");
+
+    auto pixels = std::vector<std::uint8_t>(
+        static_cast<std::size_t>(detail::kWidth * detail::kHeight) * 4U);
+    harness.Metric("gl/capture/read_pixels_1000_models",
+                   frame_ms([&]() -> void {
+                     glReadPixels(0, 0, detail::kWidth, detail::kHeight,
+                                  GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+                   }),
+                   "ms/frame");
+
+    auto capture_config = CaptureConfig();
+    capture_config.directory =
+        (std::filesystem::temp_directory_path() / "goya_bench_capture")
+            .string();
+
+    auto capture_jobs = JobSystem(2U);
+    {
+      auto capture = FrameCapture(detail::kWidth, detail::kHeight,
+                                  capture_config, capture_jobs);
+      harness.Metric("gl/capture/pbo_ring_png_1000_models",
+                     frame_ms([&]() -> void { capture.Capture(); }),
+                     "ms/frame");
+      capture.Finish();
+      harness.Metric("gl/capture/pbo_ring_stalls",
+                     static_cast<double>(capture.Stalls()));
+    }
+    std::filesystem::remove_all(capture_config.directory);
+
+    auto png = std::vector<std::uint8_t>();
+    harness.Run("gl/capture/encode_png_720p", 1U, [&]() -> void {
+      EncodePng(detail::kWidth, detail::kHeight, pixels.data(), png);
+      DoNotOptimize(png.data());
+    });
+  }
+
+  if (!AllocTracker::Enabled() ||
+      !harness.Enabled("gl/steady_state/frame")) {
+    return;
+  }
+
+  // full frames through Window::Refresh, which polls events into frame memory
+  auto const frame = [&]() -> void {
+    win.Refresh();
+    effect.Update(1.f / 120.f);
+    effect.Upload();
+
+    queue.SetView(camera.Position(), camera.Front(), detail::kFarPlane);
+    for (auto& queued : models) {
+      queued->Submit(queue);
+    }
+
+    effect.Submit(queue);
+    queue.Execute();
+  };
+
+  for (auto i = 0; i < detail::kWarmUpFrames; ++i) {
+    frame();
+  }
+
+  auto const before = GlobalAllocTracker().Totals();
+  for (auto i = 0; i < detail::kMeasuredFrames; ++i) {
+    frame();
+  }
+  auto const after = GlobalAllocTracker().Totals();
+
+  auto const allocs_per_frame =
+      static_cast<double>(after.allocations - before.allocations) /
+      detail::kMeasuredFrames;
+  harness.Metric("gl/steady_state/frame", allocs_per_frame,
+                 "allocations/frame");
+  harness.Check("gl/steady_state/frame", allocs_per_frame <= 0.0,
+                "warmed up frames allocate");
+}
+
+}  // namespace goya::bench
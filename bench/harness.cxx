@@ -0,0 +1,228 @@
+#include "harness.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <ctime>
+#include <iomanip>
+#include <utility>
+
+namespace goya::bench {
+
+namespace detail {
+
+using BenchClock = std::chrono::steady_clock;
+
+auto TimeBatch(std::uint64_t const iterations,
+               std::function<void()> const& fn) -> double {
+  auto const start = BenchClock::now();
+  for (auto i = std::uint64_t(0U); i < iterations; ++i) {
+    fn();
+  }
+
+  return std::chrono::duration<double>(BenchClock::now() - start).count();
+}
+
+auto WriteJsonString(std::ostream& ostrm, std::string const& str) -> void {
+  ostrm << '"';
+  for (auto const chr : str) {
+    if (chr == '"' || chr == '\\') {
+      ostrm << '\\';
+    }
+
+    ostrm << chr;
+  }
+
+  ostrm << '"';
+}
+
+}  // namespace detail
+
+Harness::Harness(std::string filter, double const min_seconds,
+                 std::size_t const repetitions)
+    : min_seconds_(min_seconds),
+      repetitions_(std::max(repetitions, std::size_t(1U))) {
+  auto first = std::size_t(0U);
+  while (first <= filter.size()) {
+    auto const last = std::min(filter.find(',', first), filter.size());
+    if (last > first) {
+      filters_.push_back(filter.substr(first, last - first));
+    }
+    first = last + 1U;
+  }
+}
+
+auto Harness::Enabled(std::string const& name) const -> bool {
+  return filters_.empty() ||
+         std::any_of(filters_.begin(), filters_.end(),
+                     [&name](std::string const& filter) -> bool {
+                       return name.find(filter) != std::string::npos;
+                     });
+}
+
+auto Harness::Run(std::string name, std::uint64_t const ops_per_iter,
+                  std::function<void()> const& fn) -> void {
+  if (!Enabled(name)) {
+    return;
+  }
+
+  // warm up caches and lazily allocated state
+  fn();
+
+  auto const batch_seconds = min_seconds_ / static_cast<double>(repetitions_);
+  auto iterations = std::uint64_t(1U);
+  for (auto elapsed = detail::TimeBatch(iterations, fn);
+       elapsed < batch_seconds;
+       elapsed = detail::TimeBatch(iterations, fn)) {
+    auto const scale = elapsed > 0.0 ? 1.4 * batch_seconds / elapsed : 10.0;
+    iterations = std::max(
+        iterations + 1U,
+        static_cast<std::uint64_t>(static_cast<double>(iterations) *
+                                   std::min(scale, 10.0)));
+  }
+
+  auto samples = std::vector<double>();
+  for (auto i = std::size_t(0U); i < repetitions_; ++i) {
+    auto const elapsed = detail::TimeBatch(iterations, fn);
+    samples.push_back(elapsed * 1e9 /
+                      static_cast<double>(iterations * ops_per_iter));
+  }
+
+  std::sort(samples.begin(), samples.end());
+
+  auto& result = results_.emplace_back();
+  result.name = std::move(name);
+  result.ops_per_iter = ops_per_iter;
+  result.iterations = iterations;
+  result.ns_per_op_median = samples[samples.size() / 2U];
+  result.ns_per_op_min = samples.front();
+}
+
+auto Harness::Metric(std::string name, double const value, std::string unit)
+    -> void {
+  if (!Enabled(name)) {
+    return;
+  }
+
+  metrics_.push_back(BenchMetric{std::move(name), value, std::move(unit)});
+}
+
+auto Harness::Check(std::string name, bool const passed, std::string message)
+    -> void {
+  if (!Enabled(name)) {
+    return;
+  }
+
+  checks_.push_back(BenchCheck{std::move(name), passed, std::move(message)});
+}
+
+auto Harness::Results() const noexcept -> std::vector<BenchResult> const& {
+  return results_;
+}
+
+auto Harness::MedianNs(std::string const& name) const -> double {
+  auto const result = std::find_if(
+      results_.begin(), results_.end(),
+      [&name](BenchResult const& res) -> bool { return res.name == name; });
+
+  return result == results_.end() ? 0.0 : result->ns_per_op_median;
+}
+
+auto Harness::Metrics() const noexcept -> std::vector<BenchMetric> const& {
+  return metrics_;
+}
+
+auto Harness::Checks() const noexcept -> std::vector<BenchCheck> const& {
+  return checks_;
+}
+
+auto Harness::Failed() const noexcept -> bool {
+  return std::any_of(checks_.begin(), checks_.end(),
+                     [](BenchCheck const& check) -> bool {
+                       return !check.passed;
+                     });
+}
+
+auto Harness::Print(std::ostream& ostrm) const -> void {
+  ostrm << std::left << std::setw(48) << "benchmark" << std::right
+        << std::setw(14) << "median ns/op" << std::setw(14) << "min ns/op"
+        << std::setw(12) << "iterations" << '\n';
+
+  for (auto const& result : results_) {
+    ostrm << std::left << std::setw(48) << result.name << std::right
+          << std::fixed << std::setprecision(2) << std::setw(14)
+          << result.ns_per_op_median << std::setw(14) << result.ns_per_op_min
+          << std::setw(12) << result.iterations << '\n';
+  }
+
+  // metrics span counts to errors far below 0.01
+  for (auto const& metric : metrics_) {
+    ostrm << std::left << std::setw(48) << metric.name << std::right
+          << std::defaultfloat << std::setprecision(6) << std::setw(14)
+          << metric.value << ' ' << metric.unit << '\n';
+  }
+
+  for (auto const& check : checks_) {
+    ostrm << std::left << std::setw(48) << check.name << std::right
+          << std::setw(14) << (check.passed ? "pass" : "FAIL");
+    if (!check.passed) {
+      ostrm << ' ' << check.message;
+    }
+    ostrm << '\n';
+  }
+}
+
+auto Harness::WriteJson(std::ostream& ostrm) const -> void {
+  auto const separator = [&ostrm](std::size_t const idx) -> void {
+    ostrm << (idx == 0U ? "\n" : ",\n");
+  };
+
+#ifdef NDEBUG
+  auto constexpr kBuildType = "release";
+#else
+  auto constexpr kBuildType = "debug";
+#endif
+
+  ostrm << std::setprecision(17);
+  ostrm << "{\n\"context\": {\"compiler\": ";
+  detail::WriteJsonString(ostrm, __VERSION__);
+  ostrm << ", \"build_type\": \"" << kBuildType << "\", \"timestamp\": "
+        << std::time(nullptr) << "},\n\"benchmarks\": [";
+
+  for (auto i = std::size_t(0U); i < results_.size(); ++i) {
+    auto const& result = results_[i];
+    separator(i);
+    ostrm << "  {\"name\": ";
+    detail::WriteJsonString(ostrm, result.name);
+    ostrm << ", \"ops_per_iter\": " << result.ops_per_iter
+          << ", \"iterations\": " << result.iterations
+          << ", \"ns_per_op_median\": " << result.ns_per_op_median
+          << ", \"ns_per_op_min\": " << result.ns_per_op_min << '}';
+  }
+
+  ostrm << "\n],\n\"metrics\": [";
+  for (auto i = std::size_t(0U); i < metrics_.size(); ++i) {
+    auto const& metric = metrics_[i];
+    separator(i);
+    ostrm << "  {\"name\": ";
+    detail::WriteJsonString(ostrm, metric.name);
+    ostrm << ", \"value\": " << metric.value << ", \"unit\": ";
+    detail::WriteJsonString(ostrm, metric.unit);
+    ostrm << '}';
+  }
+
+  ostrm << "\n],\n\"checks\": [";
+  for (auto i = std::size_t(0U); i < checks_.size(); ++i) {
+    auto const& check = checks_[i];
+    separator(i);
+    ostrm << "  {\"name\": ";
+    detail::WriteJsonString(ostrm, check.name);
+    ostrm << ", \"passed\": " << (check.passed ? "true" : "false")
+          << ", \"message\": ";
+    detail::WriteJsonString(ostrm, check.message);
+    ostrm << '}';
+  }
+
+  ostrm << "\n]\n}\n";
+}
+
+}  // namespace goya::bench
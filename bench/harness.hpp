@@ -0,0 +1,84 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace goya::bench {
+
+struct BenchResult {
+  std::string name;
+
+  // operations done by a single call of the benchmarked function
+  std::uint64_t ops_per_iter = 1U;
+  std::uint64_t iterations = 0U;
+
+  double ns_per_op_median = 0.0;
+  double ns_per_op_min = 0.0;
+};
+
+// a measured quantity that is not a timing, e.g. a vertex count
+struct BenchMetric {
+  std::string name;
+  double value = 0.0;
+  std::string unit;
+};
+
+// an expectation on a measured value, any failed check makes goya_bench
+// exit non-zero
+struct BenchCheck {
+  std::string name;
+  bool passed = true;
+  std::string message;
+};
+
+// keeps the compiler from optimizing away a computed value, the address
+// escapes into an opaque asm block which may read any memory
+template <class T>
+auto DoNotOptimize(T const& val) -> void {
+  asm volatile("" : : "g"(&val) : "memory");
+}
+
+// Minimal timing loop. The iteration count is calibrated until a batch runs
+// for at least min_seconds / repetitions, then the batch is repeated and the
+// median and minimum time per operation are reported.
+class Harness {
+ public:
+  explicit Harness(std::string filter = "", double min_seconds = 0.5,
+                   std::size_t repetitions = 5U);
+
+  // filter is a comma separated list of substrings, benchmarks whose name
+  // contains none of them are skipped
+  auto Enabled(std::string const& name) const -> bool;
+
+  auto Run(std::string name, std::uint64_t ops_per_iter,
+           std::function<void()> const& fn) -> void;
+  auto Metric(std::string name, double value, std::string unit = "") -> void;
+  auto Check(std::string name, bool passed, std::string message) -> void;
+
+  auto Results() const noexcept -> std::vector<BenchResult> const&;
+
+  // median ns/op of an earlier Run(), 0 when it was filtered out
+  auto MedianNs(std::string const& name) const -> double;
+  auto Metrics() const noexcept -> std::vector<BenchMetric> const&;
+  auto Checks() const noexcept -> std::vector<BenchCheck> const&;
+
+  // true once any check failed
+  auto Failed() const noexcept -> bool;
+
+  auto Print(std::ostream& ostrm) const -> void;
+  auto WriteJson(std::ostream& ostrm) const -> void;
+
+ private:
+  std::vector<std::string> filters_;
+  double min_seconds_;
+  std::size_t repetitions_;
+
+  std::vector<BenchResult> results_;
+  std::vector<BenchMetric> metrics_;
+  std::vector<BenchCheck> checks_;
+};
+
+}  // namespace goya::bench
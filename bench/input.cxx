@@ -0,0 +1,124 @@
+#include <cstdint>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "GLFW/glfw3.h"
+#include "goya/events.hpp"
+#include "goya/input_state.hpp"
+#include "suites.hpp"
+
+namespace goya::bench {
+
+namespace detail {
+
+// a busy frame, mostly cursor motion and a few held keys repeating
+auto constexpr kFrameEvents = std::size_t(256U);
+auto constexpr kHandlers = std::size_t(8U);
+auto constexpr kRingEvents = std::uint64_t(1U) << 16U;
+
+auto FrameEvents() -> std::vector<InputEvent> {
+  auto events = std::vector<InputEvent>(kFrameEvents);
+  for (auto i = std::size_t(0U); i < events.size(); ++i) {
+    auto& event = events[i];
+    if (i % 4U == 0U) {
+      event.type = InputEventType::kKey;
+      event.key = i % 8U == 0U ? GLFW_KEY_W : GLFW_KEY_A;
+      event.action = i == 0U ? GLFW_PRESS : GLFW_REPEAT;
+    } else {
+      event.type = InputEventType::kCursor;
+      event.x_pos = static_cast<double>(i);
+      event.y_pos = static_cast<double>(i) * 0.5;
+    }
+  }
+
+  return events;
+}
+
+}  // namespace detail
+
+auto RunInputBenchmarks(Harness& harness) -> void {
+  auto const events = detail::FrameEvents();
+
+  // callback dispatch, every handler sees every event
+  auto moved = 0.f;
+  auto key_handlers = std::vector<KeyEventHandler>();
+  auto cursor_handlers = std::vector<CursorEventHandler>();
+  for (auto i = std::size_t(0U); i < detail::kHandlers; ++i) {
+    key_handlers.push_back([&moved](KeyEvent e, TimeType delta) -> void {
+      if (e.glfw_key_action && e.glfw_key_code == GLFW_KEY_W) {
+        moved += delta;
+      }
+    });
+    cursor_handlers.push_back([&moved](CursorEvent e, TimeType delta) -> void {
+      moved += static_cast<float>(e.x_pos) * delta;
+    });
+  }
+
+  harness.Run("input/dispatch/handlers_8", detail::kFrameEvents,
+              [&]() -> void {
+                for (auto const& event : events) {
+                  if (event.type == InputEventType::kKey) {
+                    for (auto const& handler : key_handlers) {
+                      handler(KeyEvent(event.key, event.action), 0.016f);
+                    }
+                  } else {
+                    for (auto const& handler : cursor_handlers) {
+                      handler(CursorEvent(event.x_pos, event.y_pos), 0.016f);
+                    }
+                  }
+                }
+                DoNotOptimize(moved);
+              });
+
+  // same frame folded into the key bitmap, then polled once
+  auto state = InputState();
+  harness.Run("input/state/apply_poll", detail::kFrameEvents, [&]() -> void {
+    state.BeginFrame();
+    for (auto const& event : events) {
+      state.Apply(event);
+    }
+
+    auto const held = state.IsDown(GLFW_KEY_W) + state.IsDown(GLFW_KEY_A) +
+                      state.IsDown(GLFW_KEY_S) + state.IsDown(GLFW_KEY_D);
+    DoNotOptimize(held);
+    DoNotOptimize(state.CursorDelta());
+  });
+
+  auto queue = std::make_unique<InputQueue>();
+  harness.Run("input/spsc_ring/push_pop", detail::kFrameEvents,
+              [&]() -> void {
+                for (auto const& event : events) {
+                  queue->TryPush(event);
+                }
+                state.Drain(*queue);
+              });
+
+  // window thread producing, simulation thread draining, through the ring
+  harness.Run("input/spsc_ring/two_threads", detail::kRingEvents,
+              [&]() -> void {
+                auto producer = std::thread([&]() -> void {
+                  for (auto i = std::uint64_t(0U); i < detail::kRingEvents;
+                       ++i) {
+                    while (!queue->TryPush(events[i % events.size()])) {
+                      std::this_thread::yield();
+                    }
+                  }
+                });
+
+                auto consumed = std::uint64_t(0U);
+                auto event = InputEvent();
+                while (consumed < detail::kRingEvents) {
+                  if (queue->TryPop(event)) {
+                    state.Apply(event);
+                    ++consumed;
+                  } else {
+                    std::this_thread::yield();
+                  }
+                }
+
+                producer.join();
+              });
+}
+
+}  // namespace goya::bench
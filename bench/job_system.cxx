@@ -0,0 +1,116 @@
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <string>
+#include <vector>
+
+#include "goya/job_system.hpp"
+#include "suites.hpp"
+
+namespace goya::bench {
+
+namespace detail {
+
+auto constexpr kBatchSize = std::uint64_t(1024U);
+auto constexpr kParallelForSize = std::size_t(1U) << 20U;
+
+auto ReportUtilization(Harness& harness, JobSystem const& jobs,
+                       double const wall_seconds) -> void {
+  auto const stats = jobs.Stats();
+  for (auto i = std::size_t(0U); i < stats.size(); ++i) {
+    auto const prefix = "job_system/utilization/worker_" + std::to_string(i);
+    harness.Metric(prefix + "/busy",
+                   100.0 * stats[i].busy_seconds / wall_seconds, "%");
+    harness.Metric(prefix + "/steals", static_cast<double>(stats[i].steals));
+  }
+}
+
+}  // namespace detail
+
+auto RunJobSystemBenchmarks(Harness& harness) -> void {
+  auto jobs = JobSystem();
+  auto counter = std::atomic<std::uint64_t>(0U);
+
+  // scheduling overhead of an empty job, submitted from outside the pool
+  harness.Run("job_system/spawn_wait_external", detail::kBatchSize,
+              [&]() -> void {
+                auto group = TaskGroup();
+                for (auto i = std::uint64_t(0U); i < detail::kBatchSize; ++i) {
+                  jobs.Spawn(group, [&counter]() -> void {
+                    counter.fetch_add(1U, std::memory_order_relaxed);
+                  });
+                }
+
+                jobs.Wait(group);
+              });
+
+  // same from inside a job, exercising the owner's deque and stealing
+  harness.Run("job_system/spawn_wait_worker", detail::kBatchSize,
+              [&]() -> void {
+                auto outer = TaskGroup();
+                jobs.Spawn(outer, [&]() -> void {
+                  auto group = TaskGroup();
+                  for (auto i = std::uint64_t(0U); i < detail::kBatchSize;
+                       ++i) {
+                    jobs.Spawn(group, [&counter]() -> void {
+                      counter.fetch_add(1U, std::memory_order_relaxed);
+                    });
+                  }
+
+                  jobs.Wait(group);
+                });
+
+                jobs.Wait(outer);
+              });
+
+  // four node diamond, the shape of a typical frame graph
+  auto graph = TaskGraph();
+  auto const bump = [&counter]() -> void {
+    counter.fetch_add(1U, std::memory_order_relaxed);
+  };
+  auto const root = graph.Add(bump);
+  auto const left = graph.Add(bump, {root});
+  auto const right = graph.Add(bump, {root});
+  graph.Add(bump, {left, right});
+
+  harness.Run("job_system/task_graph_diamond", 1U,
+              [&]() -> void { graph.Run(jobs); });
+
+  auto values = std::vector<float>(detail::kParallelForSize, 1.f);
+  auto const body = [&values](std::size_t first, std::size_t last) -> void {
+    for (auto i = first; i < last; ++i) {
+      values[i] = std::sqrt(values[i] * 1.0001f + 0.5f);
+    }
+  };
+
+  harness.Run("job_system/serial_for_1M", detail::kParallelForSize,
+              [&]() -> void {
+                body(0U, values.size());
+                DoNotOptimize(values.front());
+              });
+
+  for (auto const grain : {std::size_t(1024U), std::size_t(16384U)}) {
+    harness.Run("job_system/parallel_for_1M_grain_" + std::to_string(grain),
+                detail::kParallelForSize, [&]() -> void {
+                  jobs.ParallelFor(0U, values.size(), grain, body);
+                  DoNotOptimize(values.front());
+                });
+  }
+
+  if (!harness.Enabled("job_system/utilization")) {
+    return;
+  }
+
+  jobs.ResetStats();
+  auto const start = std::chrono::steady_clock::now();
+  for (auto i = 0; i < 64; ++i) {
+    jobs.ParallelFor(0U, values.size(), 16384U, body);
+  }
+
+  detail::ReportUtilization(
+      harness, jobs,
+      std::chrono::duration<double>(std::chrono::steady_clock::now() - start)
+          .count());
+}
+
+}  // namespace goya::bench
@@ -0,0 +1,99 @@
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+#include "harness.hpp"
+#include "suites.hpp"
+
+namespace detail {
+
+struct Options {
+  std::string filter;
+  std::string json_path;
+  double min_seconds = 0.5;
+
+  goya::bench::SuiteConfig suite;
+};
+
+auto constexpr kUsage =
+    "[goya_bench] usage: goya_bench [--filter substring,...] [--json path] "
+    "[--min-time seconds] [--resources dir] [--gl]";
+
+auto ParseOptions(int argc, char** argv) -> Options {
+  auto dst = Options();
+  for (auto i = 1; i < argc; ++i) {
+    auto const arg = std::string(argv[i]);
+    auto const value = [&]() -> std::string {
+      if (i + 1 >= argc) {
+        throw std::runtime_error(kUsage);
+      }
+
+      return argv[++i];
+    };
+
+    if (arg == "--filter") {
+      dst.filter = value();
+    } else if (arg == "--json") {
+      dst.json_path = value();
+    } else if (arg == "--min-time") {
+      dst.min_seconds = std::stod(value());
+    } else if (arg == "--resources") {
+      dst.suite.resources_dir = value();
+    } else if (arg == "--gl") {
+      dst.suite.gl = true;
+    } else {
+      throw std::runtime_error(kUsage);
+    }
+  }
+
+  return dst;
+}
+
+}  // namespace detail
+
+int main(int argc, char** argv) {
+  try {
+    auto const options = detail::ParseOptions(argc, argv);
+    auto harness = goya::bench::Harness(options.filter, options.min_seconds);
+
+    goya::bench::RunAllocBenchmarks(harness, options.suite);
+    goya::bench::RunInputBenchmarks(harness);
+    goya::bench::RunJobSystemBenchmarks(harness);
+    goya::bench::RunMeshBenchmarks(harness, options.suite);
+    goya::bench::RunSplineBenchmarks(harness, options.suite);
+    goya::bench::RunParticleBenchmarks(harness);
+    goya::bench::RunSceneBenchmarks(harness);
+    goya::bench::RunGlBenchmarks(harness, options.suite);
+
+    harness.Print(std::cout);
+
+    if (!options.json_path.empty()) {
+      auto ofstrm = std::ofstream(options.json_path);
+      if (!ofstrm.is_open()) {
+        throw std::runtime_error("[goya_bench] failed to open " +
+                                 options.json_path);
+      }
+
+      harness.WriteJson(ofstrm);
+    }
+
+    if (harness.Failed()) {
+      for (auto const& check : harness.Checks()) {
+        if (!check.passed) {
+          std::cerr << "[goya_bench] " << check.name << " failed: "
+                    << check.message << std::endl;
+        }
+      }
+
+      return EXIT_FAILURE;
+    }
+
+  } catch (std::exception const& e) {
+    std::cerr << e.what() << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,50 @@
+#include <algorithm>
+#include <filesystem>
+#include <vector>
+
+#include "goya/mesh.hpp"
+#include "goya/mesh_loader.hpp"
+#include "suites.hpp"
+
+namespace goya::bench {
+
+auto RunMeshBenchmarks(Harness& harness, SuiteConfig const& config) -> void {
+  auto paths = std::vector<std::filesystem::path>();
+  for (auto const& entry :
+       std::filesystem::directory_iterator(config.resources_dir + "/mesh")) {
+    if (entry.path().extension() == ".obj") {
+      paths.push_back(entry.path());
+    }
+  }
+
+  std::sort(paths.begin(), paths.end());
+
+  for (auto const& path : paths) {
+    auto const stem = path.stem().string();
+    auto const obj = LoadMeshObjData(path.string());
+
+    // per vertex, so meshes of different sizes compare
+    auto const n_vertices = std::max(obj.vertices.size(), std::size_t(1U));
+    harness.Run("mesh/load_obj/" + stem, n_vertices, [&]() -> void {
+      auto const loaded = LoadMeshObjData(path.string());
+      DoNotOptimize(loaded.vertices.data());
+    });
+
+    auto vertices = obj.vertices;
+    harness.Run("mesh/normalize_vertices/" + stem, n_vertices, [&]() -> void {
+      vertices = obj.vertices;
+      detail::NormalizeVertices(vertices);
+      DoNotOptimize(vertices.data());
+    });
+
+    auto const n_soup = std::max(
+        detail::TransformObjToVertices(obj).size(), std::size_t(1U));
+    harness.Run("mesh/transform_obj_to_vertices/" + stem, n_soup,
+                [&]() -> void {
+                  auto const soup = detail::TransformObjToVertices(obj);
+                  DoNotOptimize(soup.data());
+                });
+  }
+}
+
+}  // namespace goya::bench
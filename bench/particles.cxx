@@ -0,0 +1,80 @@
+#include <random>
+#include <string>
+
+#include "goya/job_system.hpp"
+#include "goya/particles.hpp"
+#include "suites.hpp"
+
+namespace goya::bench {
+
+namespace detail {
+
+auto constexpr kParticleDelta = 1.f / 120.f;
+auto constexpr kParticleLifeSpan = 1.f;
+
+// fountain like source, matches the shape of the demo effect
+auto MakeParticleSource() -> std::function<Particle(void)> {
+  return [rng = std::minstd_rand(42),
+          dis = std::uniform_real_distribution<float>(-1.f, 1.f)]() mutable
+         -> Particle {
+    auto dst = Particle();
+    dst.position = glm::vec3(0.f);
+    dst.velocity = glm::vec3(dis(rng), 4.f + dis(rng), dis(rng));
+    dst.color = glm::vec4(0.f, 0.22f, 0.33f, 1.f);
+    dst.life_len = 0.f;
+
+    return dst;
+  };
+}
+
+// runs until every particle spawned, so updates see a steady population
+auto WarmUp(ParticleEffect& effect) -> void {
+  auto const n_steps =
+      static_cast<int>(2.f * kParticleLifeSpan / kParticleDelta);
+  for (auto i = 0; i < n_steps; ++i) {
+    effect.Update(kParticleDelta);
+  }
+}
+
+}  // namespace detail
+
+auto RunParticleBenchmarks(Harness& harness) -> void {
+  auto jobs = JobSystem();
+
+  for (auto const size : {std::size_t(1000U), std::size_t(10000U),
+                          std::size_t(100000U), std::size_t(1000000U)}) {
+    auto const suffix = std::to_string(size);
+
+    if (harness.Enabled("particles/update/" + suffix)) {
+      auto effect = ParticleEffect(nullptr, detail::MakeParticleSource(),
+                                   detail::kParticleLifeSpan, size);
+      detail::WarmUp(effect);
+      harness.Run("particles/update/" + suffix, size, [&]() -> void {
+        effect.Update(detail::kParticleDelta);
+      });
+    }
+
+    if (harness.Enabled("particles/update_parallel/" + suffix)) {
+      auto effect = ParticleEffect(nullptr, detail::MakeParticleSource(),
+                                   detail::kParticleLifeSpan, size);
+      detail::WarmUp(effect);
+      harness.Run("particles/update_parallel/" + suffix, size, [&]() -> void {
+        effect.Update(detail::kParticleDelta, jobs);
+      });
+    }
+
+    if (harness.Enabled("particles/capture/" + suffix)) {
+      auto effect = ParticleEffect(nullptr, detail::MakeParticleSource(),
+                                   detail::kParticleLifeSpan, size);
+      detail::WarmUp(effect);
+
+      auto snapshot = ParticleSnapshot();
+      harness.Run("particles/capture/" + suffix, size, [&]() -> void {
+        effect.Capture(snapshot);
+        DoNotOptimize(snapshot.positions.data());
+      });
+    }
+  }
+}
+
+}  // namespace goya::bench
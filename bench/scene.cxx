@@ -0,0 +1,112 @@
+#include <cstdint>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include "glm/gtc/matrix_transform.hpp"
+#include "goya/bounds.hpp"
+#include "goya/camera.hpp"
+#include "goya/mesh.hpp"
+#include "goya/model.hpp"
+#include "goya/scene.hpp"
+#include "suites.hpp"
+
+namespace goya::bench {
+
+namespace detail {
+
+// unit boxes scattered through a cube of half size kSceneExtent, the camera
+// in its center sees a few percent of them
+auto constexpr kSceneObjects = std::size_t(100000U);
+auto constexpr kSceneExtent = 500.f;
+auto constexpr kSceneFarPlane = 200.f;
+
+// models moved per update, far enough to leave their fat boxes
+auto constexpr kMovedObjects = std::size_t(1000U);
+auto constexpr kMoveStep = 1.f;
+
+// culling 100k objects has to fit in a frame with room to spare
+auto constexpr kCullBudgetNs = 1e6;
+
+// bounds without gl objects, nothing is drawn
+class BoxMesh : public IMesh {
+ public:
+  auto Draw() -> void override {}
+  auto VertexArray() const noexcept -> std::uint32_t override { return 0U; }
+  auto Bounds() const noexcept -> Aabb override {
+    return Aabb{glm::vec3(-0.5f), glm::vec3(0.5f)};
+  }
+};
+
+}  // namespace detail
+
+auto RunSceneBenchmarks(Harness& harness) -> void {
+  if (!harness.Enabled("scene/cull_100000") &&
+      !harness.Enabled("scene/update_100000")) {
+    return;
+  }
+
+  auto const mesh = std::make_shared<detail::BoxMesh>();
+  auto rng = std::minstd_rand(42);
+  auto dis = std::uniform_real_distribution<float>(-detail::kSceneExtent,
+                                                   detail::kSceneExtent);
+
+  auto scene = Scene();
+  auto models = std::vector<std::shared_ptr<Model>>();
+  models.reserve(detail::kSceneObjects);
+  for (auto i = std::size_t(0U); i < detail::kSceneObjects; ++i) {
+    auto& model = models.emplace_back(std::make_shared<Model>(nullptr, mesh));
+    model->Translate(glm::vec3(dis(rng), dis(rng), dis(rng)));
+    scene.Add(model);
+  }
+  scene.Update();
+
+  auto const camera = Camera(
+      glm::vec3(0.f), glm::vec3(0.f, 0.f, -1.f), glm::vec3(0.f, 1.f, 0.f),
+      glm::perspective(glm::radians(90.f), 16.f / 9.f, 0.1f,
+                       detail::kSceneFarPlane));
+
+  auto visible = std::size_t(0U);
+  harness.Run("scene/cull_100000", 1U, [&]() -> void {
+    visible = scene.Cull(camera).size();
+    DoNotOptimize(visible);
+  });
+
+  harness.Metric("scene/cull_100000/visible", static_cast<double>(visible));
+  harness.Metric("scene/cull_100000/nodes_visited",
+                 static_cast<double>(scene.Stats().nodes_visited));
+
+  // timings of unoptimized builds say nothing about the budget
+#ifdef NDEBUG
+  auto const cull_ns = harness.MedianNs("scene/cull_100000");
+  harness.Check("scene/cull_100000", cull_ns < detail::kCullBudgetNs,
+                "culling takes a millisecond or more");
+#endif
+
+  // every call moves the next block of models, a full sweep later they go
+  // back the other way
+  auto constexpr kBlocks = detail::kSceneObjects / detail::kMovedObjects;
+  auto step = std::size_t(0U);
+  auto reinserted = std::size_t(0U);
+  harness.Run("scene/update_100000", detail::kMovedObjects, [&]() -> void {
+    auto const first = (step % kBlocks) * detail::kMovedObjects;
+    auto const dir = (step / kBlocks) % 2U == 0U ? 1.f : -1.f;
+    for (auto i = first; i < first + detail::kMovedObjects; ++i) {
+      models[i]->Translate(glm::vec3(dir * detail::kMoveStep, 0.f, 0.f));
+    }
+    ++step;
+
+    scene.Update();
+    reinserted = scene.Stats().reinserted;
+  });
+
+  harness.Metric("scene/update_100000/reinserted",
+                 static_cast<double>(reinserted));
+
+  // the tree after all the reinsertions
+  scene.Cull(camera);
+  harness.Metric("scene/update_100000/nodes_visited_after",
+                 static_cast<double>(scene.Stats().nodes_visited));
+}
+
+}  // namespace goya::bench
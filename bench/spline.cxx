@@ -0,0 +1,433 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <limits>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "glm/gtc/constants.hpp"
+#include "goya/b_spline.hpp"
+#include "goya/job_system.hpp"
+#include "goya/spline_followers.hpp"
+#include "goya/spline_stream.hpp"
+#include "goya/trajectory_source.hpp"
+#include "suites.hpp"
+
+namespace goya::bench {
+
+namespace detail {
+
+auto constexpr kCoordSamples = std::uint64_t(1000U);
+
+auto constexpr kFollowers = std::size_t(10000U);
+
+// copies of the demo points stacked along z, edits in the middle of it
+auto constexpr kEditPoints = std::size_t(100000U);
+auto constexpr kEditAt = kEditPoints / 2U;
+auto constexpr kFollowerDelta = 1.f / 120.f;
+
+// a captured trajectory, written as text and binary to the temp directory
+auto constexpr kTrajectoryPoints = std::size_t(100000U);
+
+// frame probes per segment, fine enough that a smooth frame turns by well
+// under a degree between two of them while a flip turns by up to 180
+auto constexpr kFrameProbes = 1000U;
+
+// copies of points stacked along z
+auto StackedPoints(std::vector<Vertex3d> const& points, std::size_t count)
+    -> std::vector<Vertex3d> {
+  auto dst = std::vector<Vertex3d>();
+  dst.reserve(count);
+  for (auto i = std::size_t(0U); i < count; ++i) {
+    auto const copy = i / points.size();
+    dst.push_back(points[i % points.size()] +
+                  Vertex3d(0.f, 0.f, 3.f * static_cast<float>(copy)));
+  }
+
+  return dst;
+}
+
+auto AngleDeg(glm::vec3 const a, glm::vec3 const b) -> double {
+  return glm::degrees(std::acos(std::clamp(glm::dot(a, b), -1.f, 1.f)));
+}
+
+// largest turn of the frame normal between neighbouring probes, a normal
+// that is undefined, e.g. the frenet one at zero curvature, is a flip too
+template <class Normal>
+auto MaxNormalStep(CubeBSpline const& spline, Normal const& normal)
+    -> double {
+  auto worst = 0.0;
+  auto prev = normal(0.f, 0U);
+  for (auto idx = 0U; idx < spline.SegmentCount(); ++idx) {
+    for (auto k = 1U; k <= kFrameProbes; ++k) {
+      auto const curr = normal(
+          static_cast<float>(k) / static_cast<float>(kFrameProbes), idx);
+      auto const step = AngleDeg(prev, curr);
+      worst = std::max(worst, std::isnan(step) ? 180.0 : step);
+      prev = curr;
+    }
+  }
+
+  return worst;
+}
+
+// a planar s curve, the frenet normal flips at every inflection
+auto constexpr kSCurvePoints = 16U;
+
+auto SCurvePoints() -> std::vector<Vertex3d> {
+  auto dst = std::vector<Vertex3d>();
+  for (auto i = 0U; i < kSCurvePoints; ++i) {
+    auto const angle = 2.f * glm::pi<float>() * static_cast<float>(i) /
+                       static_cast<float>(kSCurvePoints - 1U);
+    dst.emplace_back(static_cast<float>(i), 3.f * std::sin(angle), 0.f);
+  }
+
+  return dst;
+}
+
+// the rotation minimizing frame has to turn smoothly and keep its z axis on
+// the tangent, a few degrees per probe at most
+auto constexpr kMaxRmfStepDeg = 3.0;
+auto constexpr kMaxRmfTangentErrorDeg = 0.5;
+
+struct FrameErrors {
+  double frenet_step = 0.0;
+  double rmf_step = 0.0;
+  double rmf_tangent = 0.0;
+};
+
+auto FrenetNormal(CubeBSpline const& spline, float const t,
+                  std::uint32_t const idx) -> glm::vec3 {
+  auto const v = glm::normalize(spline.SplineDCoord(t, idx));
+  auto const dd = spline.SplineDdCoord(t, idx);
+  return glm::normalize(dd - glm::dot(dd, v) * v);
+}
+
+auto MeasureFrames(CubeBSpline const& spline) -> FrameErrors {
+  auto const frenet_normal = [&](float t, std::uint32_t idx) -> glm::vec3 {
+    return FrenetNormal(spline, t, idx);
+  };
+  auto const rmf_normal = [&](float t, std::uint32_t idx) -> glm::vec3 {
+    return glm::mat3_cast(spline.Orientation(t, idx))[1];
+  };
+
+  auto dst = FrameErrors();
+  dst.frenet_step = MaxNormalStep(spline, frenet_normal);
+  dst.rmf_step = MaxNormalStep(spline, rmf_normal);
+
+  for (auto idx = 0U; idx < spline.SegmentCount(); ++idx) {
+    for (auto k = 0U; k <= kFrameProbes; ++k) {
+      auto const t = static_cast<float>(k) / static_cast<float>(kFrameProbes);
+      dst.rmf_tangent = std::max(
+          dst.rmf_tangent,
+          AngleDeg(glm::mat3_cast(spline.Orientation(t, idx))[2],
+                   glm::normalize(spline.SplineDCoord(t, idx))));
+    }
+  }
+
+  return dst;
+}
+
+// curve probes per segment for the tessellation error
+auto constexpr kErrorProbes = 256U;
+
+auto PieceDistance(Vertex3d const p, Vertex3d const a, Vertex3d const b)
+    -> float {
+  auto const ab = b - a;
+  auto const len2 = glm::dot(ab, ab);
+  auto const t =
+      len2 > 0.f ? std::clamp(glm::dot(p - a, ab) / len2, 0.f, 1.f) : 0.f;
+  return glm::length(p - (a + t * ab));
+}
+
+// worst distance of the curve from the line strip, brute force
+auto ChordError(CubeBSpline const& spline, std::vector<Vertex3d> const& strip)
+    -> float {
+  auto worst = 0.f;
+  for (auto idx = 0U; idx < spline.SegmentCount(); ++idx) {
+    for (auto k = 0U; k <= kErrorProbes; ++k) {
+      auto const p = spline.SplineCoord(
+          static_cast<float>(k) / static_cast<float>(kErrorProbes), idx);
+
+      auto best = std::numeric_limits<float>::max();
+      for (auto i = std::size_t(1U); i < strip.size(); ++i) {
+        best = std::min(best, PieceDistance(p, strip[i - 1U], strip[i]));
+      }
+      worst = std::max(worst, best);
+    }
+  }
+
+  return worst;
+}
+
+}  // namespace detail
+
+auto RunSplineBenchmarks(Harness& harness, SuiteConfig const& config)
+    -> void {
+  // no shader, the spline stays math only
+  auto spline = CubeBSpline(
+      LoadControloPoints(config.resources_dir + "/points.txt"), nullptr);
+
+  auto const n_points = spline.SplinePoints().size();
+  auto const n_segments = spline.SegmentCount();
+  if (n_segments == 0U) {
+    return;
+  }
+
+  harness.Run("spline/spline_coord", detail::kCoordSamples, [&]() -> void {
+    for (auto i = std::uint64_t(0U); i < detail::kCoordSamples; ++i) {
+      auto const t = static_cast<float>(i) /
+                     static_cast<float>(detail::kCoordSamples);
+      DoNotOptimize(
+          spline.SplineCoord(t, static_cast<std::uint32_t>(i) % n_segments));
+    }
+  });
+
+  harness.Run("spline/spline_d_coord", detail::kCoordSamples, [&]() -> void {
+    for (auto i = std::uint64_t(0U); i < detail::kCoordSamples; ++i) {
+      auto const t = static_cast<float>(i) /
+                     static_cast<float>(detail::kCoordSamples);
+      DoNotOptimize(
+          spline.SplineDCoord(t, static_cast<std::uint32_t>(i) % n_segments));
+    }
+  });
+
+  auto ts = std::vector<float>(detail::kCoordSamples);
+  for (auto i = std::size_t(0U); i < ts.size(); ++i) {
+    ts[i] = static_cast<float>(i) / static_cast<float>(ts.size());
+  }
+
+  auto coords = std::vector<Vertex3d>(ts.size());
+  auto d_coords = std::vector<Vertex3d>(ts.size());
+  auto dd_coords = std::vector<Vertex3d>(ts.size());
+
+  harness.Run("spline/evaluate_batch/coord", detail::kCoordSamples,
+              [&]() -> void {
+                spline.EvaluateBatch(0U, ts.data(), ts.size(), coords.data());
+                DoNotOptimize(coords.data());
+              });
+
+  harness.Run("spline/evaluate_batch/coord_d_dd", detail::kCoordSamples,
+              [&]() -> void {
+                spline.EvaluateBatch(0U, ts.data(), ts.size(), coords.data(),
+                                     d_coords.data(), dd_coords.data());
+                DoNotOptimize(coords.data());
+              });
+
+  harness.Run("spline/sample_segment", detail::kCoordSamples, [&]() -> void {
+    spline.SampleSegment(0U, coords.size(), coords.data());
+    DoNotOptimize(coords.data());
+  });
+
+  // rebuilding on every control point edit has to stay cheap
+  auto control_points = spline.ControlPoints();
+  harness.Run("spline/arc_length/rebuild", n_segments, [&]() -> void {
+    spline.SetControlPoints(control_points);
+    DoNotOptimize(spline.Length());
+  });
+
+  harness.Run("spline/arc_length/edit_point", 4U, [&]() -> void {
+    spline.SetControlPoint(4U, control_points[4U]);
+    DoNotOptimize(spline.Length());
+  });
+
+  auto const length = spline.Length();
+  harness.Run("spline/arc_length/locate", detail::kCoordSamples,
+              [&]() -> void {
+                for (auto i = std::size_t(0U); i < ts.size(); ++i) {
+                  DoNotOptimize(spline.ArcParameter(ts[i] * length));
+                }
+              });
+
+  harness.Run("spline/spline_points", n_points, [&]() -> void {
+    auto const points = spline.SplinePoints();
+    DoNotOptimize(points.data());
+  });
+
+  harness.Run("spline/normal_points", n_segments * 10U, [&]() -> void {
+    auto const points = spline.NormalPoints();
+    DoNotOptimize(points.data());
+  });
+
+  harness.Run("spline/frames/frenet", detail::kCoordSamples, [&]() -> void {
+    for (auto i = std::size_t(0U); i < ts.size(); ++i) {
+      DoNotOptimize(detail::FrenetNormal(spline, ts[i], 0U));
+    }
+  });
+
+  harness.Run("spline/frames/orientation", detail::kCoordSamples,
+              [&]() -> void {
+                for (auto i = std::size_t(0U); i < ts.size(); ++i) {
+                  DoNotOptimize(spline.Orientation(ts[i], 0U));
+                }
+              });
+
+  // a flip of the frame shows up as a step of up to 180 degrees, on the
+  // demo points and on an s curve whose frenet frame flips
+  if (harness.Enabled("spline/frames/max_normal_step") ||
+      harness.Enabled("spline/frames/rmf_tangent_error")) {
+    auto const s_curve = CubeBSpline(detail::SCurvePoints(), nullptr);
+    using FrameCase = std::pair<char const*, CubeBSpline const*>;
+    auto const cases = {FrameCase("", &spline),
+                        FrameCase("/s_curve", &s_curve)};
+    for (auto const& [suffix, curve] : cases) {
+      auto const errors = detail::MeasureFrames(*curve);
+      auto const step = std::string("spline/frames/max_normal_step/rmf") +
+                        suffix;
+      auto const tangent =
+          std::string("spline/frames/rmf_tangent_error") + suffix;
+
+      harness.Metric(
+          std::string("spline/frames/max_normal_step/frenet") + suffix,
+          errors.frenet_step, "deg");
+      harness.Metric(step, errors.rmf_step, "deg");
+      harness.Metric(tangent, errors.rmf_tangent, "deg");
+
+      harness.Check(step, errors.rmf_step < detail::kMaxRmfStepDeg,
+                    "the frame turns too fast between probes");
+      harness.Check(tangent,
+                    errors.rmf_tangent < detail::kMaxRmfTangentErrorDeg,
+                    "the frame leaves the tangent");
+    }
+  }
+
+  // the same crowd once as a spline per object and once as followers
+  auto crowd = std::vector<CubeBSpline>();
+  crowd.reserve(detail::kFollowers);
+  for (auto i = std::size_t(0U); i < detail::kFollowers; ++i) {
+    auto& member = crowd.emplace_back(spline.ControlPoints(), nullptr);
+    member.SetSpeed(4.f);
+    member.TimeUpdate(static_cast<float>(i) * 0.01f);
+  }
+
+  auto transforms = std::vector<glm::mat4>(detail::kFollowers);
+
+  harness.Run("spline/followers/per_spline_10000", detail::kFollowers,
+              [&]() -> void {
+                for (auto i = std::size_t(0U); i < crowd.size(); ++i) {
+                  crowd[i].TimeUpdate(detail::kFollowerDelta);
+                  transforms[i] = crowd[i].ModelMatrix();
+                }
+                DoNotOptimize(transforms.data());
+              });
+
+  auto followers = SplineFollowers();
+  auto const path = followers.AddPath(spline);
+  for (auto i = std::size_t(0U); i < detail::kFollowers; ++i) {
+    followers.AddFollower(path, static_cast<float>(i) * 0.04f, 4.f);
+  }
+
+  auto jobs = JobSystem();
+  harness.Run("spline/followers/update_10000", detail::kFollowers,
+              [&]() -> void {
+                followers.Update(detail::kFollowerDelta, jobs,
+                                 transforms.data());
+                DoNotOptimize(transforms.data());
+              });
+
+  // per_spline runs on the calling thread, update on it and the workers
+  auto const per_spline_ns =
+      harness.MedianNs("spline/followers/per_spline_10000");
+  auto const update_ns = harness.MedianNs("spline/followers/update_10000");
+  if (per_spline_ns > 0.0 && update_ns > 0.0) {
+    harness.Metric("spline/followers/speedup_over_per_spline",
+                   per_spline_ns / update_ns, "x");
+    harness.Metric("spline/followers/update_workers",
+                   static_cast<double>(jobs.WorkerCount()));
+  }
+
+  if (harness.Enabled("spline/edit/move_100000") ||
+      harness.Enabled("spline/edit/insert_remove_100000")) {
+    auto const points =
+        detail::StackedPoints(control_points, detail::kEditPoints);
+    auto long_spline = CubeBSpline(points, nullptr);
+    auto offset = 0.f;
+    harness.Run("spline/edit/move_100000", 1U, [&]() -> void {
+      offset = offset > 0.f ? -0.1f : 0.1f;
+      long_spline.SetControlPoint(detail::kEditAt,
+                                  points[detail::kEditAt] + offset);
+      DoNotOptimize(long_spline.Length());
+    });
+
+    harness.Run("spline/edit/insert_remove_100000", 2U, [&]() -> void {
+      long_spline.InsertControlPoint(detail::kEditAt,
+                                     points[detail::kEditAt] + 0.1f);
+      long_spline.RemoveControlPoint(detail::kEditAt);
+      DoNotOptimize(long_spline.Length());
+    });
+  }
+
+  if (harness.Enabled("spline/trajectory/")) {
+    auto const points =
+        detail::StackedPoints(control_points, detail::kTrajectoryPoints);
+    auto const dir = std::filesystem::temp_directory_path();
+    auto const text_path = (dir / "goya_trajectory.txt").string();
+    auto const binary_path = (dir / "goya_trajectory.bin").string();
+
+    {
+      auto ofstrm = std::ofstream(text_path);
+      for (auto const& p : points) {
+        ofstrm << p.x << ' ' << p.y << ' ' << p.z << '\n';
+      }
+    }
+    TrajectorySource::WriteBinary(binary_path, points);
+
+    // the loop LoadControloPoints had before
+    harness.Run("spline/trajectory/ifstream_100000", points.size(),
+                [&]() -> void {
+                  auto dst = std::vector<Vertex3d>();
+                  auto ifstrm = std::ifstream(text_path);
+                  auto v = Vertex3d();
+                  while (ifstrm >> v.x >> v.y >> v.z) {
+                    dst.push_back(v);
+                  }
+                  DoNotOptimize(dst.data());
+                });
+
+    harness.Run("spline/trajectory/text_100000", points.size(),
+                [&]() -> void {
+                  auto const dst = LoadControloPoints(text_path);
+                  DoNotOptimize(dst.data());
+                });
+
+    harness.Run("spline/trajectory/binary_100000", points.size(),
+                [&]() -> void {
+                  auto const dst = LoadControloPoints(binary_path);
+                  DoNotOptimize(dst.data());
+                });
+
+    // steps past about a chunk of segments, per segment moved
+    auto stream = SplineStream(
+        std::make_shared<TrajectorySource const>(binary_path), nullptr);
+    stream.Spline().SetSpeed(1.f);
+    auto const step = stream.Spline().Length() *
+                      static_cast<float>(SplineStream::kDefaultChunk) /
+                      static_cast<float>(SplineStream::kDefaultWindow);
+    harness.Run("spline/trajectory/stream_segment",
+                SplineStream::kDefaultChunk, [&]() -> void {
+      stream.TimeUpdate(step, jobs);
+      DoNotOptimize(stream.FirstPoint());
+    });
+    harness.Metric("spline/trajectory/resident_points",
+                   static_cast<double>(stream.Spline().ControlPoints().size()),
+                   "points");
+
+    std::filesystem::remove(text_path);
+    std::filesystem::remove(binary_path);
+  }
+
+  harness.Metric("spline/segments", n_segments);
+  harness.Metric("spline/arc_length", static_cast<double>(length), "units");
+  harness.Metric("spline/spline_points", static_cast<double>(n_points),
+                 "vertices");
+  if (harness.Enabled("spline/spline_points/chord_error")) {
+    harness.Metric("spline/spline_points/chord_error",
+                   detail::ChordError(spline, spline.SplinePoints()), "units");
+  }
+}
+
+}  // namespace goya::bench
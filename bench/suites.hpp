@@ -0,0 +1,26 @@
+#pragma once
+
+#include <string>
+
+#include "harness.hpp"
+
+namespace goya::bench {
+
+struct SuiteConfig {
+  // directory with the bundled meshes and control points
+  std::string resources_dir = "resources";
+
+  // gl suites need a context, they run under a headless window
+  bool gl = false;
+};
+
+auto RunAllocBenchmarks(Harness& harness, SuiteConfig const& config) -> void;
+auto RunInputBenchmarks(Harness& harness) -> void;
+auto RunJobSystemBenchmarks(Harness& harness) -> void;
+auto RunMeshBenchmarks(Harness& harness, SuiteConfig const& config) -> void;
+auto RunSplineBenchmarks(Harness& harness, SuiteConfig const& config) -> void;
+auto RunParticleBenchmarks(Harness& harness) -> void;
+auto RunSceneBenchmarks(Harness& harness) -> void;
+auto RunGlBenchmarks(Harness& harness, SuiteConfig const& config) -> void;
+
+}  // namespace goya::bench
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+namespace goya {
+
+// coarse owners allocations are charged to, see AllocScope
+enum class AllocSubsystem : std::uint8_t {
+  kUntagged,
+  kWindow,
+  kMesh,
+  kSpline,
+  kParticles,
+  kScene,
+  kRender,
+  kJobs,
+  kCount
+};
+
+struct AllocStats {
+  std::uint64_t allocations = 0U;
+  std::uint64_t deallocations = 0U;
+
+  // requested bytes of the allocations, frees are not sized reliably
+  std::uint64_t bytes = 0U;
+};
+
+auto AllocSubsystemName(AllocSubsystem subsystem) noexcept -> char const*;
+
+// Counts every global operator new and delete. An allocation is charged to
+// the innermost AllocScope of the allocating thread, a free to the scope of
+// the freeing thread. The replacement operators are only compiled in with
+// GOYA_ALLOC_TRACKER_ENABLED, otherwise every stat reads zero.
+class AllocTracker {
+ public:
+  static constexpr auto kSubsystems =
+      static_cast<std::size_t>(AllocSubsystem::kCount);
+
+  static auto Enabled() noexcept -> bool;
+
+  // since program start
+  auto Totals(AllocSubsystem subsystem) const noexcept -> AllocStats;
+  auto Totals() const noexcept -> AllocStats;
+
+  // render thread, once per frame
+  auto BeginFrame() noexcept -> void;
+
+  // the frame that ended with the last BeginFrame()
+  auto FrameStats(AllocSubsystem subsystem) const noexcept -> AllocStats;
+  auto FrameStats() const noexcept -> AllocStats;
+
+ private:
+  std::array<AllocStats, kSubsystems> frame_start_{};
+  std::array<AllocStats, kSubsystems> frame_{};
+};
+
+auto GlobalAllocTracker() -> AllocTracker&;
+
+// tags allocations of the calling thread until it goes out of scope
+class AllocScope {
+ public:
+  explicit AllocScope(AllocSubsystem subsystem) noexcept;
+  ~AllocScope();
+
+  AllocScope(AllocScope const&) = delete;
+  AllocScope& operator=(AllocScope const&) = delete;
+
+ private:
+  AllocSubsystem prev_;
+};
+
+}  // namespace goya
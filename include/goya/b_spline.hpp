@@ -1,8 +1,14 @@
 #pragma once
 
+#include <cstdint>
+#include <memory>
+#include <memory_resource>
 #include <string>
+#include <vector>
 
 #include "glm/glm.hpp"
+#include "glm/gtc/quaternion.hpp"
+#include "goya/camera.hpp"
 #include "goya/model.hpp"
 #include "goya/primitives.hpp"
 #include "goya/shader.hpp"
@@ -17,9 +23,110 @@ inline auto const N_matrix = (1.f / 6.f) * glm::mat4{
     1.f,  0.f,  0.f,  0.f
 };
 
+// text or binary, see TrajectorySource
 auto LoadControloPoints(std::string const& path) -> std::vector<Vertex3d>;
 auto LoadControloPoints(char const* path) -> std::vector<Vertex3d>;
 
+// power basis of one segment, p(t) = ((a * t + b) * t + c) * t + d
+struct SplineSegment {
+  Vertex3d a;
+  Vertex3d b;
+  Vertex3d c;
+  Vertex3d d;
+};
+
+struct SplineParam {
+  std::uint32_t idx = 0U;
+  float t = 0.f;
+};
+
+// Maps positions of a sequence to stable storage slots. Inserting or erasing
+// positions shifts the slot ids behind them while the data in the slots stays
+// put, freed slots are handed out again by the next Insert().
+class SlotOrder {
+public:
+  // positions [0, count) in slots [0, count)
+  auto Reset(std::size_t count) -> void;
+
+  // count new positions from pos on, their slots are appended to slots
+  auto Insert(std::size_t pos, std::size_t count,
+              std::vector<std::uint32_t>& slots) -> void;
+  // positions [pos, pos + count), the slots they had are appended to slots
+  auto Erase(std::size_t pos, std::size_t count,
+             std::vector<std::uint32_t>& slots) -> void;
+
+  auto operator[](std::size_t pos) const noexcept -> std::uint32_t {
+    return order_[pos];
+  }
+
+  auto Size() const noexcept -> std::size_t;
+
+  // slots handed out so far, the size of arrays indexed by slot
+  auto SlotCount() const noexcept -> std::size_t;
+  auto Slots() const noexcept -> std::vector<std::uint32_t> const&;
+
+private:
+  std::vector<std::uint32_t> order_;
+  std::vector<std::uint32_t> free_;
+  std::uint32_t slot_count_ = 0U;
+};
+
+// Arc length from the start of every segment, sampled kSamples times per
+// segment and integrated with adaptive Gauss-Legendre quadrature. Locate()
+// maps a distance back to a curve parameter with binary searches and a
+// Newton step, so objects can move at a constant world space speed. Segment
+// idx of the curve is segments[order[idx]]. Offsets are measured from the
+// start of blocks of kBlock segments plus a table of block offsets, so an
+// edit redoes one block and the table.
+class ArcLengthTable {
+public:
+  static constexpr auto kSamples = 16U;
+  static constexpr auto kBlock = std::size_t(256U);
+
+  // segments [first, last) changed, a changed segment count redoes the
+  // offsets of every segment from first on
+  auto Update(std::vector<SplineSegment> const& segments,
+              SlotOrder const& order, std::uint32_t first,
+              std::uint32_t last) -> void;
+
+  auto Length() const noexcept -> float;
+
+  auto LengthAt(std::vector<SplineSegment> const& segments,
+                SlotOrder const& order, SplineParam param) const -> float;
+  auto Locate(std::vector<SplineSegment> const& segments,
+              SlotOrder const& order, float distance) const -> SplineParam;
+
+private:
+  // kSamples + 1 lengths per slot, measured from the segment start
+  std::vector<float> samples_;
+
+  // length of every segment, and the length before it from the start of its
+  // block
+  std::vector<float> lengths_;
+  std::vector<float> local_;
+
+  // length before every block followed by the total
+  std::vector<float> blocks_{0.f};
+};
+
+// Screen space bound for the line models, a line may be off the curve by
+// pixels at the distance of the piece from eye. pixels_per_unit is half the
+// viewport height in pixels times projection[1][1], 0 disables the bound.
+struct ScreenTolerance {
+  Vertex3d eye{0.f};
+  float pixels_per_unit = 0.f;
+  float pixels = 1.f;
+};
+
+auto MakeScreenTolerance(Camera const& camera, float viewport_height,
+                         float pixels = 1.f) -> ScreenTolerance;
+
+// Uniform cubic b-spline. The curve math needs no gl context, the line models
+// are only created on the first Draw() or Submit() and a null shader makes the
+// spline math only. Every segment's polynomial is cached and rebuilt whenever
+// the control points it depends on change. Segments live in slots, so moving,
+// inserting or removing a point redoes the four segments around it and
+// patches only their slots of the line models.
 class CubeBSpline {
 public:
   CubeBSpline(std::vector<Vertex3d> control_points, std::shared_ptr<Shader> shader);
@@ -28,34 +135,178 @@ public:
 
   auto ModelMatrix() -> glm::mat4;
 
-  auto SplineCoord(float t, std::uint32_t idx) -> Vertex3d;
-  auto SplineDCoord(float t, std::uint32_t idx) -> Vertex3d;
-  auto SplineDdCoord(float t, std::uint32_t idx) -> Vertex3d;
+  auto SplineCoord(float t, std::uint32_t idx) const -> Vertex3d;
+  auto SplineDCoord(float t, std::uint32_t idx) const -> Vertex3d;
+  auto SplineDdCoord(float t, std::uint32_t idx) const -> Vertex3d;
+
+  auto SplineCoord() const -> Vertex3d;
+  auto SplineDCoord() const -> Vertex3d;
+  auto SplineDdCoord() const -> Vertex3d;
+
+  // rotation minimizing frame, x to the side, y the normal and z along the
+  // curve. a lookup in the precomputed frames plus an nlerp
+  auto Orientation(float t, std::uint32_t idx) const -> glm::quat;
+  auto Orientation() const -> glm::quat;
+
+  // evaluates segment idx at count parameters, null outputs are skipped
+  auto EvaluateBatch(std::uint32_t idx, float const* ts, std::size_t count,
+                     Vertex3d* coords, Vertex3d* d_coords = nullptr,
+                     Vertex3d* dd_coords = nullptr) const -> void;
+
+  // coords at t = i / count for i in [0, count), by forward differencing
+  auto SampleSegment(std::uint32_t idx, std::size_t count,
+                     Vertex3d* coords) const -> void;
 
-  auto SplineCoord() -> Vertex3d;
-  auto SplineDCoord() -> Vertex3d;
-  auto SplineDdCoord() -> Vertex3d;
+  auto SegmentCount() const noexcept -> std::uint32_t;
+  auto Segment(std::uint32_t idx) const -> SplineSegment const&;
+
+  auto ControlPoints() const noexcept -> std::vector<Vertex3d> const&;
+
+  // line models are rebuilt on the next Draw() or Submit()
+  auto SetControlPoints(std::vector<Vertex3d> control_points) -> void;
+
+  // local edits, the changed slots are uploaded on the next Draw() or
+  // Submit(). an inserted point becomes point idx, idx == size appends
+  auto SetControlPoint(std::size_t idx, Vertex3d point) -> void;
+  auto InsertControlPoint(std::size_t idx, Vertex3d point) -> void;
+  auto RemoveControlPoint(std::size_t idx) -> void;
+
+  // the same for runs of points, e.g. to slide a window over a trajectory.
+  // TimeUpdate() stays on its part of the curve when points before it change
+  // and removing the first points keeps the frames of the rest
+  auto InsertControlPoints(std::size_t idx,
+                           std::vector<Vertex3d> const& points) -> void;
+  auto RemoveControlPoints(std::size_t idx, std::size_t count) -> void;
+
+  // segment and parameter of the last TimeUpdate()
+  auto CurrentParam() const noexcept -> SplineParam;
+
+  auto Length() const noexcept -> float;
+  auto ArcLength(float t, std::uint32_t idx) const -> float;
+  auto ArcParameter(float distance) const -> SplineParam;
+
+  // world units per second for TimeUpdate(), 0 steps the curve parameter
+  // uniformly instead, so speed follows the control point spacing
+  auto SetSpeed(float units_per_second) -> void;
+
+  // pieces of the line models are split until they are at most chord_error
+  // world units off the curve, or off by the screen tolerance when one is
+  // set. both rebuild the line models on the next Draw() or Submit()
+  auto SetTolerance(float chord_error) -> void;
+  auto SetScreenTolerance(ScreenTolerance const& tolerance) -> void;
+
+  // vertices of the line models as of the last Draw() or Submit()
+  auto VertexCount() const noexcept -> std::size_t;
 
   auto CenterCoord() -> Vertex3d;
 
+  auto SplinePoints() -> std::vector<Vertex3d>;
+  auto NormalPoints() -> std::vector<Vertex3d>;
+
+  // allocate from resource instead, e.g. a FrameArena
+  auto SplinePoints(std::pmr::memory_resource* resource)
+      -> std::pmr::vector<Vertex3d>;
+  auto NormalPoints(std::pmr::memory_resource* resource)
+      -> std::pmr::vector<Vertex3d>;
+
   auto Draw() -> void;
+  auto Submit(RenderQueue& queue) -> void;
 
 private: 
-  auto RiMatrix(std::uint32_t idx) -> glm::mat3x4;
+  auto RiMatrix(std::uint32_t idx) const -> glm::mat3x4;
+  auto ResizeSlots() -> void;
+  auto UpdateSegments(std::uint32_t first, std::uint32_t last) -> void;
+  auto UpdateFrames(std::uint32_t slot) -> void;
+  auto UpdateTwists(std::uint32_t first, std::uint32_t last) -> void;
+  auto IncomingTwist(std::uint32_t idx) const -> glm::vec2;
+  auto Twist(std::uint32_t idx) const -> glm::vec2;
+  auto MarkEdited(std::uint32_t first, std::uint32_t last,
+                  std::size_t first_point, std::size_t last_point,
+                  bool reordered) -> void;
+  auto ShiftCurrent(std::uint32_t first, std::uint32_t removed,
+                    std::uint32_t inserted) -> void;
 
-  auto SplinePoints() -> std::vector<Vertex3d>;
-  auto NormalPoints() -> std::vector<Vertex3d>;
+  auto CreateModels() -> bool;
+  auto CreateLineModels() -> void;
+  auto PatchLineModels() -> void;
+
+  // emits every piece start of seg in order, scale widens the bound
+  template <class Emit>
+  auto Tessellate(SplineSegment const& seg, float scale, int max_depth,
+                  Emit&& emit) const -> void;
+  template <class Emit>
+  auto Subdivide(SplineSegment const& seg, float scale, float t0, float t1,
+                 Vertex3d p0, Vertex3d p1, int depth, Emit& emit) const
+      -> void;
+  auto PieceTolerance(Vertex3d mid) const -> float;
+
+  template <class Vector>
+  auto FillSplinePoints(Vector& dst) -> void;
+  template <class Vector>
+  auto FillNormalPoints(Vector& dst) -> void;
+
+  // the strips of one slot of the line models
+  auto FillSegmentPoints(SplineSegment const& seg, std::vector<Vertex3d>& dst)
+      -> void;
+  auto FillSegmentNormals(SplineSegment const& seg,
+                          std::vector<Vertex3d>& dst) -> void;
 
   std::vector<Vertex3d> control_points_;
 
-  Model control_model_;
-  Model spline_model_;
-  Model normal_model_;
+  // segment idx is kept in slot order_[idx], the arrays below are per slot
+  SlotOrder order_;
+  std::vector<SplineSegment> segments_;
+  ArcLengthTable arc_table_;
+
+  // kFrameSamples + 1 rotation minimizing frames per slot, started from a
+  // normal that depends on the start tangent only. neighbours have a
+  // positive dot product so the nlerp takes the short way
+  std::vector<glm::quat> frames_;
+
+  // per segment, cos and sin of half the turn about the start tangent from
+  // that normal to the one the previous segment ends with
+  std::vector<glm::vec2> twist_in_;
+
+  // the product of twist_in_ up to a segment is the one of its block start
+  // times the one inside the block, so frames stay continuous while an edit
+  // redoes only its own frames, one block and the block products
+  std::vector<glm::vec2> twist_local_;
+  std::vector<glm::vec2> twist_blocks_;
+
+  // normal the first segment starts with once points were removed in front
+  // of it, so the frames behind do not turn. zero uses the frenet normal
+  Vertex3d start_normal_{0.f};
+
+  std::shared_ptr<Shader> shader_;
+
+  std::unique_ptr<Model> control_model_;
+  std::unique_ptr<Model> spline_model_;
+  std::unique_ptr<Model> normal_model_;
+
+  std::shared_ptr<MeshLines> control_mesh_;
+  std::shared_ptr<MeshLineSlots> spline_mesh_;
+  std::shared_ptr<MeshLineSlots> normal_mesh_;
+
+  // edits since the last Draw() or Submit()
+  std::vector<std::uint32_t> dirty_slots_;
+  std::vector<std::uint32_t> freed_slots_;
+  std::vector<std::uint32_t> edit_slots_;
+  std::size_t dirty_points_first_ = ~std::size_t(0);
+  std::size_t dirty_points_last_ = 0U;
+  bool order_dirty_ = false;
+  std::vector<Vertex3d> strip_;
 
   float animation_speed_ = 1.5f;
   float seg_t_ = 0.f;
 
+  float world_speed_ = 0.f;
+  float distance_ = 0.f;
+
   std::uint32_t curr_idx_ = 0;
+
+  float tolerance_ = 0.002f;
+  ScreenTolerance screen_;
+  std::size_t vertex_count_ = 0U;
   
 };
 
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#include "glm/glm.hpp"
+#include "goya/primitives.hpp"
+
+namespace goya {
+
+struct Aabb {
+  glm::vec3 lo = glm::vec3(std::numeric_limits<float>::max());
+  glm::vec3 hi = glm::vec3(std::numeric_limits<float>::lowest());
+};
+
+auto BoundsOf(std::vector<Vertex3d> const& points) noexcept -> Aabb;
+
+auto Union(Aabb const& lhs, Aabb const& rhs) noexcept -> Aabb;
+auto Contains(Aabb const& outer, Aabb const& inner) noexcept -> bool;
+auto SurfaceArea(Aabb const& box) noexcept -> float;
+auto Fatten(Aabb const& box, float margin) noexcept -> Aabb;
+
+// tight box around the transformed box (Arvo's method)
+auto Transform(Aabb const& box, glm::mat4 const& matrix) noexcept -> Aabb;
+
+enum class Containment : std::uint8_t { kOutside, kIntersecting, kInside };
+
+// planes point inwards: left, right, bottom, top, near, far
+struct Frustum {
+  std::array<glm::vec4, 6> planes;
+};
+
+auto ExtractFrustum(glm::mat4 const& view_projection) noexcept -> Frustum;
+
+auto Classify(Frustum const& frustum, Aabb const& box) noexcept
+    -> Containment;
+
+auto constexpr kAllPlanes = std::uint8_t(0x3F);
+
+// hierarchical variant, only tests planes still set in plane_mask and clears
+// the ones the box lies fully inside of so children can skip them
+auto Classify(Frustum const& frustum, Aabb const& box,
+              std::uint8_t& plane_mask) noexcept -> Containment;
+
+}  // namespace goya
@@ -23,6 +23,10 @@ class Camera {
 
   auto ShiftLook(float x_offset, float y_offset, TimeType delta) -> void;
 
+  // places the camera and updates the shaders right away, up may roll it
+  // until the next Refresh()
+  auto LookAlong(glm::vec3 pos, glm::vec3 front, glm::vec3 up) -> void;
+
   auto SetSpeed(float speed) noexcept -> void;
   auto GetSpeed() const noexcept -> float;
 
@@ -31,6 +35,12 @@ class Camera {
 
   auto UpdateAspectRatio(float ratio) -> void;
 
+  auto Position() const noexcept -> glm::vec3;
+  auto Front() const noexcept -> glm::vec3;
+
+  auto Projection() const noexcept -> glm::mat4;
+  auto ViewProjection() const noexcept -> glm::mat4;
+
  protected:
   auto UpdateUniforms() const -> void;
 
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <vector>
+
+#include "goya/b_spline.hpp"
+#include "goya/camera.hpp"
+#include "goya/primitives.hpp"
+
+namespace goya {
+
+// Camera on a uniform cubic b-spline, for fly-throughs that show the same
+// views on every run. The camera looks along the tangent with the rotation
+// minimizing normal as up, so it turns with the curve without twisting.
+// Positions are spaced by arc length.
+class CameraPath {
+ public:
+  // at least four points, e.g. from LoadControloPoints()
+  explicit CameraPath(std::vector<Vertex3d> control_points);
+
+  // moves camera to fraction of the path length, clamped to [0, 1]
+  auto Apply(Camera& camera, float fraction) const -> void;
+
+  auto Length() const noexcept -> float;
+
+ private:
+  CubeBSpline spline_;
+};
+
+}  // namespace goya
@@ -2,9 +2,15 @@
 
 namespace goya {
 
+class RenderQueue;
+
 class IDrawable {
  public:
   virtual auto Draw() -> void = 0;
+
+  // records a deferred Draw(), by default as an unsorted opaque packet
+  virtual auto Submit(RenderQueue& queue) -> void;
+
   virtual ~IDrawable() = default;
 };
 
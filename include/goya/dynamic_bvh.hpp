@@ -0,0 +1,78 @@
+#pragma once
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "goya/bounds.hpp"
+
+namespace goya {
+
+// Incrementally maintained bounding volume hierarchy. Leaves store fattened
+// boxes so that small motion does not touch the tree; a leaf is only
+// reinserted once its object leaves the fat box. Insertion picks siblings by
+// surface area cost and AVL style rotations keep the tree balanced.
+class DynamicBvh {
+ public:
+  static auto constexpr kNullNode = std::int32_t(-1);
+
+  struct QueryStats {
+    std::size_t nodes_visited = 0;
+    std::size_t leaves_accepted = 0;
+  };
+
+  explicit DynamicBvh(float margin = 0.1f);
+
+  auto CreateProxy(Aabb const& box, std::uint32_t user_data) -> std::int32_t;
+  auto DestroyProxy(std::int32_t proxy) -> void;
+
+  // returns true if the proxy had to be reinserted
+  auto MoveProxy(std::int32_t proxy, Aabb const& box) -> bool;
+
+  auto FatBounds(std::int32_t proxy) const -> Aabb const&;
+  auto UserData(std::int32_t proxy) const -> std::uint32_t;
+
+  // appends the user data of every leaf not outside the frustum
+  auto Query(Frustum const& frustum, std::vector<std::uint32_t>& dst)
+      -> QueryStats;
+
+  auto Height() const noexcept -> std::int32_t;
+  auto Size() const noexcept -> std::size_t;
+
+ private:
+  struct Node {
+    auto IsLeaf() const noexcept -> bool { return left == kNullNode; }
+
+    Aabb box;
+    std::uint32_t user_data;
+
+    std::int32_t parent;
+    std::int32_t left;
+    std::int32_t right;
+    std::int32_t height;
+  };
+
+  auto AllocateNode() -> std::int32_t;
+  auto FreeNode(std::int32_t node) -> void;
+
+  auto InsertLeaf(std::int32_t leaf) -> void;
+  auto RemoveLeaf(std::int32_t leaf) -> void;
+
+  auto Refit(std::int32_t node) -> void;
+  auto Balance(std::int32_t node) -> std::int32_t;
+
+  auto CollectLeaves(std::int32_t node, std::vector<std::uint32_t>& dst)
+      -> void;
+
+  float margin_;
+
+  std::int32_t root_;
+  std::int32_t free_list_;
+  std::size_t n_leaves_;
+
+  std::vector<Node> nodes_;
+  std::vector<std::pair<std::int32_t, std::uint8_t>> stack_;
+  std::vector<std::int32_t> collect_stack_;
+};
+
+}  // namespace goya
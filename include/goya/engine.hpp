@@ -1,8 +1,176 @@
 #pragma once
 
+#include <atomic>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include "glm/glm.hpp"
+#include "goya/input_log.hpp"
+#include "goya/input_state.hpp"
+#include "goya/job_system.hpp"
+#include "goya/particles.hpp"
+#include "goya/primitives.hpp"
+#include "goya/triple_buffer.hpp"
+#include "goya/window.hpp"
+
 namespace goya {
 
+// Everything the render thread needs from one simulation step. Slots are
+// recycled, so handlers should resize rather than rebuild the containers.
+struct FrameSnapshot {
+  std::uint64_t frame = 0U;
+  TimeType sim_time = 0.f;
+  TimeType delta = 0.f;
+
+  std::vector<glm::mat4> transforms;
+  std::vector<ParticleSnapshot> particles;
+
+  // fixed step only, transforms of the step before and how far the frame is
+  // past this step, in steps. see InterpolatedTransform()
+  std::vector<glm::mat4> prev_transforms;
+  TimeType alpha = 1.f;
+};
+
+// transform i blended from the step before to the snapshot's step, for
+// rotations and translations. the latest one outside of fixed step mode
+auto InterpolatedTransform(FrameSnapshot const& snapshot, std::size_t i)
+    -> glm::mat4;
+
+enum class SimulationMode : std::uint8_t {
+  kInline,    // simulate on the render thread right before rendering
+  kThreaded,  // simulate on a dedicated thread at simulation_rate
+  kFixedStep  // on the render thread in steps of 1 / simulation_rate, as
+              // many as the frame time covers, rendering interpolates
+};
+
+enum class InputSampling : std::uint8_t {
+  kFrameStart,  // right after presenting, like Window::Refresh()
+  kLate         // after the inline simulation, right before rendering
+};
+
+struct EngineConfig {
+  SimulationMode simulation_mode = SimulationMode::kThreaded;
+
+  // where the frame polls input and runs the window's handlers. late input
+  // moves the camera just before the render handlers use it
+  InputSampling input_sampling = InputSampling::kLate;
+
+  // frames the cpu may run ahead of the gpu, see Window::SetFrameLimit()
+  FrameLimit frame_limit = FrameLimit::kNone;
+  std::uint32_t max_queued_frames = 1U;
+
+  // steps per second of the simulation thread or of fixed stepping
+  float simulation_rate = 120.f;
+
+  // upper bound for a single simulation delta, avoids spirals after stalls
+  TimeType max_delta = 0.1f;
+
+  // job system workers, 0 picks one less than the hardware concurrency
+  std::size_t worker_threads = 0U;
+
+  // stop after this many rendered frames, 0 runs until the window closes
+  std::uint64_t max_frames = 0U;
+
+  // advance the simulation by this step instead of wall clock time, 0 off
+  TimeType fixed_delta = 0.f;
+};
+
+using SimulationHandler = std::function<void(TimeType, FrameSnapshot&)>;
+using SimulationTask = TaskGraph::NodeId;
+using RenderHandler = std::function<void(FrameSnapshot const&)>;
+
+// Owns the frame loop. Simulation handlers fill the back snapshot which is
+// published through a wait free triple buffer; render handlers only ever see
+// the newest complete snapshot. In threaded mode a slow simulation step keeps
+// presenting the previous snapshot and a slow frame never holds back the
+// simulation.
+//
+// Simulation handlers form a task graph on the engine's job system. Handlers
+// without a dependency between them run concurrently and have to write
+// disjoint parts of the snapshot.
 class Engine {
+ public:
+  explicit Engine(Window& window, EngineConfig config = EngineConfig());
+
+  Engine(Engine const&) = delete;
+  Engine& operator=(Engine const&) = delete;
+
+  // the handler starts once every task in deps finished
+  auto AddSimulationHandler(SimulationHandler handler,
+                            std::vector<SimulationTask> const& deps = {})
+      -> SimulationTask;
+
+  // render handlers run in registration order on the render thread
+  auto AddRenderHandler(RenderHandler handler) -> void;
+
+  auto Jobs() noexcept -> JobSystem&;
+
+  // writes the input and frame times of the next Run() to recorder, or
+  // replays them from replay instead of the window and the wall clock. both
+  // need a simulation on the render thread, null stops them
+  auto SetRecorder(InputRecorder* recorder) -> void;
+  auto SetReplay(InputReplay* replay) -> void;
+
+  // blocks until the window closes, Stop() is called or a replay ends
+  auto Run() -> void;
+  auto Stop() noexcept -> void;
+
+  auto SimulationFrames() const noexcept -> std::uint64_t;
+  auto RenderFrames() const noexcept -> std::uint64_t;
+
+  // wall clock milliseconds of every frame of the last Run()
+  auto FrameTimes() const noexcept -> std::vector<float> const&;
+
+  // milliseconds from the input poll of every frame of the last Run() to the
+  // return of its present. events are delivered by that poll, so an event
+  // waited up to a frame longer before it
+  auto InputLatencies() const noexcept -> std::vector<float> const&;
+
+ private:
+  auto SimulationLoop() -> void;
+  auto StepDelta(TimeType wall_delta) const noexcept -> TimeType;
+  auto PollInput() -> bool;
+  auto Advance(TimeType frame_delta) -> void;
+  auto Simulate(TimeType delta) -> void;
+  auto Render() -> void;
+
+  Window& window_;
+  EngineConfig config_;
+
+  JobSystem jobs_;
+
+  TaskGraph simulation_graph_;
+  std::vector<RenderHandler> render_handlers_;
+
+  // arguments of the simulation step in flight
+  TimeType sim_delta_;
+  FrameSnapshot* sim_snapshot_;
+
+  TripleBuffer<FrameSnapshot> snapshots_;
+
+  std::atomic<bool> running_;
+  std::atomic<std::uint64_t> sim_frames_;
+  std::uint64_t render_frames_;
+  std::vector<float> frame_times_;
+  std::vector<float> input_latencies_;
+  bool has_snapshot_;
+  TimeType sim_time_;
+
+  // fixed step time not simulated yet
+  TimeType accumulator_;
+  TimeType alpha_;
+  std::vector<glm::mat4> last_transforms_;
+
+  InputRecorder* recorder_;
+  InputReplay* replay_;
+  InputLogFrame replay_frame_;
+  // window events on their way to the recorder
+  std::unique_ptr<InputQueue> record_queue_;
+
+  std::exception_ptr sim_error_;
 };
 
 }  // namespace goya
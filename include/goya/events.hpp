@@ -31,6 +31,23 @@ struct ResizeEvent {
   std::int32_t height;
 };
 
+enum class InputEventType : std::uint8_t { kKey, kCursor };
+
+// one glfw key or cursor callback, as queued for InputState
+struct InputEvent {
+  InputEventType type = InputEventType::kKey;
+
+  // glfw key code and GLFW_PRESS, GLFW_RELEASE or GLFW_REPEAT
+  std::int32_t key = 0;
+  std::int32_t action = 0;
+
+  double x_pos = 0.0;
+  double y_pos = 0.0;
+
+  // glfw time of the poll that delivered it
+  double time = 0.0;
+};
+
 using KeyEventHandler = std::function<void(KeyEvent, TimeType)>;
 using CursorEventHandler = std::function<void(CursorEvent, TimeType)>;
 using WinResizeEventHandler = std::function<void(ResizeEvent)>;
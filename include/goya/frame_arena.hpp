@@ -0,0 +1,58 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <memory_resource>
+#include <vector>
+
+namespace goya {
+
+// Bump allocator for memory that only lives for one frame, e.g. as the
+// resource of std::pmr containers. Deallocation is a no-op, Reset() releases
+// everything at once. Requests that do not fit spill into overflow blocks and
+// the next Reset() grows the block past the high water mark, so a steady
+// state frame never touches the heap. Not thread safe, every thread that
+// needs frame memory owns its own arena.
+class FrameArena : public std::pmr::memory_resource {
+ public:
+  static constexpr auto kDefaultCapacity = std::size_t(64U) << 10U;
+
+  explicit FrameArena(std::size_t capacity = kDefaultCapacity);
+  ~FrameArena() override;
+
+  FrameArena(FrameArena const&) = delete;
+  FrameArena& operator=(FrameArena const&) = delete;
+
+  // every pointer handed out before is invalid afterwards
+  auto Reset() -> void;
+
+  // bytes handed out since the last Reset(), including overflow
+  auto Used() const noexcept -> std::size_t;
+  auto Capacity() const noexcept -> std::size_t;
+  auto HighWater() const noexcept -> std::size_t;
+
+ private:
+  struct OverflowBlock {
+    void* ptr;
+    std::size_t bytes;
+    std::size_t alignment;
+  };
+
+  auto do_allocate(std::size_t bytes, std::size_t alignment) -> void* override;
+  auto do_deallocate(void* ptr, std::size_t bytes, std::size_t alignment)
+      -> void override;
+  auto do_is_equal(std::pmr::memory_resource const& other) const noexcept
+      -> bool override;
+
+  auto ReleaseOverflow() noexcept -> void;
+
+  std::unique_ptr<std::byte[]> block_;
+  std::size_t capacity_;
+  std::size_t offset_;
+
+  std::vector<OverflowBlock> overflow_;
+  std::size_t overflow_bytes_;
+  std::size_t high_water_;
+};
+
+}  // namespace goya
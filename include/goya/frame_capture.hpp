@@ -0,0 +1,92 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "GL/glew.h"
+#include "goya/job_system.hpp"
+
+namespace goya {
+
+enum class CaptureFormat : std::uint8_t {
+  kPng,  // rgba8, deflate with stored blocks, so encoding is a copy
+  kRaw   // rgba8 bytes, top row first, no header
+};
+
+struct CaptureConfig {
+  // frame_000000.png, frame_000001.png, ... go here, it is created if needed
+  std::string directory = "capture";
+  CaptureFormat format = CaptureFormat::kPng;
+
+  // pixel buffers in the ring, a frame is read back this many frames later
+  std::uint32_t lag = 3U;
+
+  // frames encoded at once, each holds a copy of the image
+  std::uint32_t encode_slots = 4U;
+};
+
+// rgba8 rows bottom up, as glReadPixels returns them, to a png top down
+auto EncodePng(std::int32_t width, std::int32_t height,
+               std::uint8_t const* rgba, std::vector<std::uint8_t>& dst)
+    -> void;
+
+// Captures rendered frames without stalling on the gpu. Capture() starts an
+// asynchronous glReadPixels into the next pixel buffer of a ring and fences
+// it. The buffer is mapped when the ring comes back to it, lag frames later,
+// so the copy has long finished. Encoding and writing the files run on the
+// job system. Only a gpu more than lag frames behind or encoders slower than
+// the frame rate block Capture(), both count as stalls.
+class FrameCapture {
+ public:
+  FrameCapture(std::int32_t width, std::int32_t height, CaptureConfig config,
+               JobSystem& jobs);
+  ~FrameCapture();
+
+  FrameCapture(FrameCapture const&) = delete;
+  FrameCapture& operator=(FrameCapture const&) = delete;
+
+  // reads [0, width) x [0, height) of the read framebuffer, so it goes after
+  // the frame's draws and before the swap. needs the gl context
+  auto Capture() -> void;
+
+  // reads back and writes every captured frame, rethrows encoding errors
+  auto Finish() -> void;
+
+  auto Frames() const noexcept -> std::uint64_t;
+  auto Stalls() const noexcept -> std::uint64_t;
+
+ private:
+  struct ReadSlot {
+    std::uint32_t pbo = 0U;
+    GLsync fence = nullptr;
+    std::uint64_t frame = 0U;
+  };
+
+  struct EncodeSlot {
+    TaskGroup group;
+    std::uint64_t frame = 0U;
+    std::vector<std::uint8_t> pixels;
+    std::vector<std::uint8_t> bytes;
+  };
+
+  // maps the frame in slot and hands it to an encoder
+  auto Resolve(ReadSlot& slot) -> void;
+  auto Write(EncodeSlot& slot) const -> void;
+
+  std::int32_t width_;
+  std::int32_t height_;
+  std::size_t frame_bytes_;
+  CaptureConfig config_;
+  JobSystem& jobs_;
+
+  std::vector<ReadSlot> read_slots_;
+  std::vector<std::unique_ptr<EncodeSlot>> encode_slots_;
+  std::size_t next_encode_ = 0U;
+
+  std::uint64_t n_frames_ = 0U;
+  std::uint64_t n_stalls_ = 0U;
+};
+
+}  // namespace goya
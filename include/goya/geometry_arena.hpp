@@ -0,0 +1,129 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "glm/glm.hpp"
+#include "goya/mesh.hpp"
+#include "goya/mesh_obj_data.hpp"
+#include "goya/primitives.hpp"
+#include "goya/shader.hpp"
+
+namespace goya {
+
+enum class ArenaPrimitive : std::uint8_t { kTriangles, kLines, kLineStrip };
+
+// offset and length of a sub allocation, both in vertices
+struct ArenaRange {
+  std::size_t first;
+  std::size_t count;
+};
+
+// Sub-allocates static meshes from one large vertex buffer sharing a single
+// vertex array object. Freed ranges go to an offset ordered free list that
+// coalesces neighbours; Defragment() compacts live meshes on the gpu. Mesh
+// ids stay valid across defragmentation and growth, ranges do not.
+class GeometryArena {
+ public:
+  using MeshId = std::uint32_t;
+
+  explicit GeometryArena(std::size_t initial_capacity);
+  ~GeometryArena();
+
+  GeometryArena(GeometryArena const&) = delete;
+  GeometryArena& operator=(GeometryArena const&) = delete;
+
+  auto Allocate(std::vector<Vertex3d> const& vertices) -> MeshId;
+  auto Free(MeshId id) -> void;
+
+  auto Range(MeshId id) const -> ArenaRange;
+
+  auto Defragment() -> void;
+
+  // largest free block over total free space, 1 when unfragmented
+  auto Contiguity() const noexcept -> float;
+
+  auto Capacity() const noexcept -> std::size_t;
+  auto Used() const noexcept -> std::size_t;
+
+  auto VertexArray() const noexcept -> std::uint32_t;
+
+  auto Draw(ArenaPrimitive primitive, MeshId id) -> void;
+
+  // one glMultiDrawArrays for every mesh in ids
+  auto MultiDraw(ArenaPrimitive primitive, std::vector<MeshId> const& ids)
+      -> void;
+
+ private:
+  auto FindFree(std::size_t count) -> std::size_t;
+  auto Release(ArenaRange range) -> void;
+  auto Grow(std::size_t min_capacity) -> void;
+  auto Relocate(std::size_t capacity) -> void;
+
+  std::size_t capacity_;
+  std::size_t used_;
+
+  std::vector<ArenaRange> free_list_;
+  std::vector<ArenaRange> ranges_;
+  std::vector<MeshId> free_ids_;
+
+  std::vector<std::int32_t> draw_firsts_;
+  std::vector<std::int32_t> draw_counts_;
+
+  std::uint32_t vao_;
+  std::uint32_t vbo_;
+};
+
+// mesh living inside a geometry arena, drawable wherever an IMesh is
+class ArenaMesh : public IMesh {
+ public:
+  ArenaMesh(std::shared_ptr<GeometryArena> arena,
+            std::vector<Vertex3d> const& vertices, ArenaPrimitive primitive);
+  ArenaMesh(std::shared_ptr<GeometryArena> arena, MeshObjData const& obj_data);
+  ~ArenaMesh();
+
+  ArenaMesh(ArenaMesh const&) = delete;
+  ArenaMesh& operator=(ArenaMesh const&) = delete;
+
+  auto Draw() -> void override;
+  auto VertexArray() const noexcept -> std::uint32_t override;
+  auto Bounds() const noexcept -> Aabb override;
+
+  auto Id() const noexcept -> GeometryArena::MeshId;
+  auto Primitive() const noexcept -> ArenaPrimitive;
+
+ private:
+  std::shared_ptr<GeometryArena> arena_;
+  GeometryArena::MeshId id_;
+  ArenaPrimitive primitive_;
+  Aabb bounds_;
+};
+
+// arena meshes sharing shader, transform and color, drawn in a single call
+class ArenaBatch : public IDrawable {
+ public:
+  ArenaBatch(std::shared_ptr<Shader> shader,
+             std::shared_ptr<GeometryArena> arena, ArenaPrimitive primitive);
+
+  auto Add(ArenaMesh const& mesh) -> void;
+  auto Clear() -> void;
+
+  auto SetModelMatrix(glm::mat4 model) -> void;
+  auto SetColor(glm::vec3 color) -> void;
+
+  auto Draw() -> void override;
+  auto Submit(RenderQueue& queue) -> void override;
+
+ private:
+  std::shared_ptr<Shader> shader_;
+  std::shared_ptr<GeometryArena> arena_;
+  ArenaPrimitive primitive_;
+
+  std::vector<GeometryArena::MeshId> ids_;
+
+  glm::vec3 color_ = glm::vec3{0.88f, 0.88f, 0.88f};
+  glm::mat4 model_matrix_ = glm::mat4(1.f);
+};
+
+}  // namespace goya
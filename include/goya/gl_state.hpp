@@ -0,0 +1,85 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+
+namespace goya {
+
+struct GlStateStats {
+  std::uint64_t issued = 0;
+  std::uint64_t skipped = 0;
+};
+
+// Shadows the bits of OpenGL context state that drawables touch and filters
+// out calls which would not change it. Every bind or enable in goya must go
+// through this cache, otherwise the shadow copy goes stale; call Invalidate()
+// after handing the context to foreign code.
+class GlStateCache {
+ public:
+  GlStateCache();
+
+  GlStateCache(GlStateCache const&) = delete;
+  GlStateCache& operator=(GlStateCache const&) = delete;
+
+  auto UseProgram(std::uint32_t program) -> void;
+  auto BindVertexArray(std::uint32_t vao) -> void;
+  auto BindBuffer(std::uint32_t target, std::uint32_t buffer) -> void;
+
+  auto SetBlend(bool enabled) -> void;
+  auto BlendFunc(std::uint32_t src_factor, std::uint32_t dst_factor) -> void;
+
+  auto SetDepthTest(bool enabled) -> void;
+  auto SetDepthWrite(bool enabled) -> void;
+  auto DepthFunc(std::uint32_t func) -> void;
+
+  auto SetCullFace(bool enabled) -> void;
+  auto CullFace(std::uint32_t mode) -> void;
+
+  auto DeleteVertexArray(std::uint32_t vao) -> void;
+  auto DeleteBuffer(std::uint32_t buffer) -> void;
+
+  // forgets everything, for a context that was just made current or is
+  // going away
+  auto Invalidate() -> void;
+
+  // rolls the per frame counters, FrameStats() then reports the closed frame
+  auto BeginFrame() -> void;
+
+  auto FrameStats() const noexcept -> GlStateStats;
+
+ private:
+  enum class Tristate : std::int8_t { kUnknown = -1, kOff = 0, kOn = 1 };
+
+  auto SetCapability(std::uint32_t cap, Tristate& cached, bool enabled)
+      -> void;
+
+  auto Issue() noexcept -> void;
+  auto Skip() noexcept -> void;
+
+  static auto constexpr kUnknownName = ~std::uint32_t(0);
+  static auto constexpr kTrackedTargets = 6U;
+
+  std::uint32_t program_;
+  std::uint32_t vao_;
+  std::array<std::uint32_t, kTrackedTargets> buffers_;
+
+  Tristate blend_;
+  std::uint32_t blend_src_;
+  std::uint32_t blend_dst_;
+
+  Tristate depth_test_;
+  Tristate depth_write_;
+  std::uint32_t depth_func_;
+
+  Tristate cull_face_;
+  std::uint32_t cull_mode_;
+
+  GlStateStats frame_stats_;
+  GlStateStats last_frame_stats_;
+};
+
+// cache for the context current on the calling thread; goya renders from a
+// single thread so there is exactly one
+auto GlState() -> GlStateCache&;
+
+}  // namespace goya
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "goya/events.hpp"
+#include "goya/primitives.hpp"
+
+namespace goya {
+
+// Everything a frame took from outside the simulation.
+struct InputLogFrame {
+  // seconds the frame advanced the simulation by, before fixed stepping
+  TimeType frame_delta = 0.f;
+  // seconds since the input poll of the frame before
+  TimeType poll_delta = 0.f;
+
+  std::vector<InputEvent> events;
+};
+
+// Writes a session as a binary input log: kMagic, a uint32 seed count, the
+// uint64 seeds and the float64 start position of the cursor, then per frame
+// both deltas as float32 and a varint event count. Key events take a byte
+// tag, a zigzag varint key and a byte action, cursor events a byte tag and
+// float64 x and y. Values are little endian.
+class InputRecorder {
+ public:
+  static constexpr char kMagic[8] = {'G', 'O', 'Y', 'A', 'I', 'N', 'P', '1'};
+
+  InputRecorder(std::string const& path, std::vector<std::uint64_t> seeds);
+
+  InputRecorder(InputRecorder const&) = delete;
+  InputRecorder& operator=(InputRecorder const&) = delete;
+
+  // writes the header, once before the first frame
+  auto Begin(double cursor_x, double cursor_y) -> void;
+
+  // events of the current frame, in the order they were polled
+  auto Record(InputEvent const& event) -> void;
+  auto EndFrame(TimeType frame_delta, TimeType poll_delta) -> void;
+
+  auto Frames() const noexcept -> std::uint64_t;
+
+ private:
+  std::string path_;
+  std::ofstream ofstrm_;
+  std::vector<std::uint64_t> seeds_;
+
+  // encoded deltas and events of the current frame
+  std::vector<char> header_;
+  std::vector<char> events_;
+  std::uint32_t n_events_ = 0U;
+
+  std::uint64_t n_frames_ = 0U;
+};
+
+// Reads an input log back frame by frame.
+class InputReplay {
+ public:
+  explicit InputReplay(std::string const& path);
+
+  InputReplay(InputReplay const&) = delete;
+  InputReplay& operator=(InputReplay const&) = delete;
+
+  auto Seeds() const noexcept -> std::vector<std::uint64_t> const&;
+  auto CursorStart() const noexcept -> std::pair<double, double>;
+
+  // false once every frame was read
+  auto Next(InputLogFrame& dst) -> bool;
+
+  auto Frames() const noexcept -> std::uint64_t;
+  // sum of the frame deltas read so far
+  auto Duration() const noexcept -> double;
+
+ private:
+  std::string path_;
+  std::ifstream ifstrm_;
+  std::vector<std::uint64_t> seeds_;
+  double cursor_x_ = 0.0;
+  double cursor_y_ = 0.0;
+
+  std::uint64_t n_frames_ = 0U;
+  double duration_ = 0.0;
+};
+
+}  // namespace goya
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <bitset>
+#include <cstdint>
+#include <utility>
+
+#include "goya/events.hpp"
+#include "goya/spsc_ring.hpp"
+
+namespace goya {
+
+// events from the thread polling the window to one consumer thread
+using InputQueue = SpscRing<InputEvent, 1024U>;
+
+// Keyboard and cursor state of one frame, built from input events. Keys are
+// bits, so movement polls whether a key is held instead of reacting to press
+// and repeat events, whose rate depends on the os. A press and a release
+// within one frame both show up as edges.
+class InputState {
+ public:
+  // glfw key codes are below this
+  static constexpr auto kKeyCount = std::size_t(512U);
+
+  // clears the edges and the cursor motion of the last frame
+  auto BeginFrame() noexcept -> void;
+  // back to no key held and no cursor position
+  auto Reset() noexcept -> void;
+
+  auto Apply(InputEvent const& event) noexcept -> void;
+  // applies every queued event, consumer side of queue
+  auto Drain(InputQueue& queue) noexcept -> void;
+
+  auto IsDown(std::int32_t key) const noexcept -> bool;
+  auto WasPressed(std::int32_t key) const noexcept -> bool;
+  auto WasReleased(std::int32_t key) const noexcept -> bool;
+
+  // cursor motion since BeginFrame(), the first event after construction
+  // only sets the position
+  auto CursorDelta() const noexcept -> std::pair<double, double>;
+  auto CursorPosition() const noexcept -> std::pair<double, double>;
+
+  // events applied since BeginFrame()
+  auto EventCount() const noexcept -> std::uint32_t;
+
+ private:
+  std::bitset<kKeyCount> down_;
+  std::bitset<kKeyCount> pressed_;
+  std::bitset<kKeyCount> released_;
+
+  double x_pos_ = 0.0;
+  double y_pos_ = 0.0;
+  double dx_ = 0.0;
+  double dy_ = 0.0;
+  bool has_cursor_ = false;
+
+  std::uint32_t n_events_ = 0U;
+};
+
+}  // namespace goya
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "glm/glm.hpp"
+#include "goya/drawable.hpp"
+#include "goya/mesh.hpp"
+#include "goya/shader.hpp"
+
+namespace goya {
+
+// layout of the per instance attribute buffer, see shaders/instanced.vs
+struct InstanceData {
+  glm::mat4 model;
+  glm::vec3 color;
+};
+
+// Draws every instance of a shared mesh with a single instanced draw call.
+// Transforms and colors live in a divisor 1 vertex buffer which is patched
+// per block of instances, so moving a few instances uploads a few blocks.
+class InstancedModel : public IDrawable {
+ public:
+  InstancedModel(std::shared_ptr<Shader> shader,
+                 std::shared_ptr<MeshTriangle> mesh);
+  ~InstancedModel();
+
+  InstancedModel(InstancedModel const&) = delete;
+  InstancedModel& operator=(InstancedModel const&) = delete;
+
+  auto AddInstance(glm::mat4 const& model, glm::vec3 color) -> std::size_t;
+  auto Resize(std::size_t n_instances) -> void;
+  auto Size() const noexcept -> std::size_t;
+
+  auto SetModelMatrix(std::size_t idx, glm::mat4 const& model) -> void;
+  auto SetColor(std::size_t idx, glm::vec3 color) -> void;
+
+  // direct write access to [first, first + count), marked for upload
+  auto MapInstances(std::size_t first, std::size_t count) -> InstanceData*;
+
+  auto Draw() -> void override;
+  auto Submit(RenderQueue& queue) -> void override;
+
+ private:
+  auto MarkDirty(std::size_t first, std::size_t count) -> void;
+  auto Upload() -> void;
+
+  std::shared_ptr<Shader> shader_;
+  std::shared_ptr<MeshTriangle> mesh_;
+
+  std::vector<InstanceData> instances_;
+  std::vector<std::uint8_t> dirty_blocks_;
+  bool any_dirty_;
+
+  std::size_t gpu_capacity_;
+
+  std::uint32_t vao_;
+  std::uint32_t vbo_instances_;
+};
+
+}  // namespace goya
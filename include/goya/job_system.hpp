@@ -0,0 +1,169 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace goya {
+
+class JobSystem;
+
+// counts outstanding jobs, JobSystem::Wait() returns once it drops to zero and
+// rethrows the first exception thrown by one of the group's jobs
+class TaskGroup {
+ public:
+  TaskGroup() = default;
+
+  TaskGroup(TaskGroup const&) = delete;
+  TaskGroup& operator=(TaskGroup const&) = delete;
+
+  auto Done() const noexcept -> bool;
+
+ private:
+  friend class JobSystem;
+
+  auto Fail(std::exception_ptr error) -> void;
+
+  std::atomic<std::size_t> pending_{0U};
+
+  std::mutex error_mtx_;
+  std::exception_ptr error_;
+};
+
+struct WorkerStats {
+  std::uint64_t jobs_executed = 0U;
+  std::uint64_t steals = 0U;
+  double busy_seconds = 0.0;
+};
+
+// Work stealing scheduler. Every worker owns a Chase-Lev deque, pushing and
+// popping at the bottom while idle workers steal from the top. Threads that
+// are not workers submit through a shared injection queue and help out with
+// pending jobs while they wait on a group.
+class JobSystem {
+ public:
+  // 0 picks one worker less than the hardware concurrency
+  explicit JobSystem(std::size_t n_workers = 0U);
+  ~JobSystem();
+
+  JobSystem(JobSystem const&) = delete;
+  JobSystem& operator=(JobSystem const&) = delete;
+
+  auto Spawn(TaskGroup& group, std::function<void()> fn) -> void;
+  auto Wait(TaskGroup& group) -> void;
+
+  // calls fn(first, last) on chunks of at most grain indices, blocking
+  auto ParallelFor(std::size_t begin, std::size_t end, std::size_t grain,
+                   std::function<void(std::size_t, std::size_t)> const& fn)
+      -> void;
+
+  auto WorkerCount() const noexcept -> std::size_t;
+
+  // snapshot of the counters since the last ResetStats()
+  auto Stats() const -> std::vector<WorkerStats>;
+  auto ResetStats() -> void;
+
+ private:
+  struct Job {
+    std::function<void()> fn;
+    TaskGroup* group;
+  };
+
+  class WorkStealingDeque {
+   public:
+    explicit WorkStealingDeque(std::size_t capacity);
+
+    // owner only, false when full
+    auto Push(Job* job) noexcept -> bool;
+    auto Pop() noexcept -> Job*;
+
+    // any thread
+    auto Steal() noexcept -> Job*;
+
+   private:
+    std::int64_t mask_;
+    std::unique_ptr<std::atomic<Job*>[]> buffer_;
+
+    alignas(64) std::atomic<std::int64_t> top_;
+    alignas(64) std::atomic<std::int64_t> bottom_;
+  };
+
+  struct Worker {
+    explicit Worker(std::size_t deque_capacity) : deque(deque_capacity) {}
+
+    WorkStealingDeque deque;
+    std::thread thread;
+
+    std::atomic<std::uint64_t> jobs_executed{0U};
+    std::atomic<std::uint64_t> steals{0U};
+    std::atomic<std::uint64_t> busy_ns{0U};
+  };
+
+  auto WorkerLoop(std::size_t idx) -> void;
+
+  auto FindJob(std::size_t self) -> Job*;
+  auto Execute(Job* job, std::size_t self) -> void;
+  auto Enqueue(Job* job) -> void;
+
+  static auto JobCache() -> std::vector<std::unique_ptr<Job>>&;
+  auto AllocateJob() -> Job*;
+  auto RecycleJob(Job* job) -> void;
+
+  std::vector<std::unique_ptr<Worker>> workers_;
+
+  // consumed from injection_head_ on, the capacity is kept once drained
+  std::mutex injection_mtx_;
+  std::vector<Job*> injection_;
+  std::size_t injection_head_;
+
+  // jobs spilled by full thread caches, refills empty ones
+  std::mutex job_pool_mtx_;
+  std::vector<std::unique_ptr<Job>> job_pool_;
+
+  std::atomic<std::size_t> queued_;
+  std::atomic<std::size_t> sleeping_;
+  std::atomic<bool> stop_;
+
+  std::mutex sleep_mtx_;
+  std::condition_variable sleep_cv_;
+};
+
+// Static dependency graph of jobs that can be run many times, e.g. once per
+// frame. A node is spawned as soon as all of its dependencies completed.
+class TaskGraph {
+ public:
+  using NodeId = std::uint32_t;
+
+  // dependencies have to be added first, so the graph is acyclic
+  auto Add(std::function<void()> fn, std::vector<NodeId> const& deps = {})
+      -> NodeId;
+
+  auto Size() const noexcept -> std::size_t;
+
+  // blocks until every node ran
+  auto Run(JobSystem& jobs) -> void;
+
+ private:
+  struct Node {
+    std::function<void()> fn;
+    std::vector<NodeId> successors;
+    std::uint32_t n_deps = 0U;
+    std::atomic<std::uint32_t> remaining{0U};
+  };
+
+  auto SpawnNode(NodeId id) -> void;
+
+  std::deque<Node> nodes_;
+
+  JobSystem* run_jobs_ = nullptr;
+  TaskGroup* run_group_ = nullptr;
+};
+
+}  // namespace goya
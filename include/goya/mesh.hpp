@@ -3,37 +3,120 @@
 #include <cstdint>
 #include <vector>
 
-#include "goya/shader.hpp"
+#include "goya/bounds.hpp"
 #include "goya/drawable.hpp"
 #include "goya/mesh_obj_data.hpp"
+#include "goya/shader.hpp"
 
 namespace goya {
 
-class IMesh : public IDrawable {};
+namespace detail {
+
+// flattens indexed faces into a triangle soup
+auto TransformObjToVertices(MeshObjData const& obj) -> std::vector<Vertex3d>;
+
+}  // namespace detail
+
+class IMesh : public IDrawable {
+ public:
+  virtual auto VertexArray() const noexcept -> std::uint32_t = 0;
+
+  // object space bounds
+  virtual auto Bounds() const noexcept -> Aabb = 0;
+
+  auto Submit(RenderQueue& queue) -> void override;
+};
 
 class MeshLines : public IMesh {
  public:
   MeshLines(std::vector<Vertex3d> const& points);
   ~MeshLines();
 
+  // uploads points [first, last) of the new strip and draws all of it, the
+  // buffer is reallocated and refilled once the strip outgrows it
+  auto Update(std::vector<Vertex3d> const& points, std::size_t first,
+              std::size_t last) -> void;
+
   auto Draw() -> void override;
+  auto VertexArray() const noexcept -> std::uint32_t override;
+  auto Bounds() const noexcept -> Aabb override;
 
   private:
     std::size_t n_points_;
+    std::size_t capacity_;
+    Aabb bounds_;
 
     std::uint32_t vao_;
     std::uint32_t vbo_;
 };
 
+// Line strips of up to SlotSize() vertices in fixed slots of one buffer,
+// drawn in the slot order given to SetOrder() with a single
+// glMultiDrawArrays. Writing a slot uploads only its range, so changing or
+// reordering a few strips leaves the rest of the buffer alone.
+class MeshLineSlots : public IMesh {
+ public:
+  explicit MeshLineSlots(std::size_t slot_size);
+  ~MeshLineSlots();
+
+  MeshLineSlots(MeshLineSlots const&) = delete;
+  MeshLineSlots& operator=(MeshLineSlots const&) = delete;
+
+  // slot i is points [i * SlotSize(), i * SlotSize() + counts[i]), replaces
+  // every slot with one upload
+  auto Assign(std::vector<Vertex3d> const& points,
+              std::vector<std::uint32_t> const& counts) -> void;
+
+  // count is at most SlotSize(), the buffer grows for slots past its end.
+  // slots left out of the order should be emptied with a count of zero
+  auto Write(std::uint32_t slot, Vertex3d const* points, std::size_t count)
+      -> void;
+  auto SetOrder(std::vector<std::uint32_t> const& slots) -> void;
+
+  auto SlotSize() const noexcept -> std::size_t;
+
+  // vertices over every slot
+  auto VertexCount() const noexcept -> std::size_t;
+
+  auto Draw() -> void override;
+  auto VertexArray() const noexcept -> std::uint32_t override;
+  auto Bounds() const noexcept -> Aabb override;
+
+ private:
+  auto Reserve(std::size_t slots) -> void;
+
+  std::size_t slot_size_;
+  std::size_t capacity_;
+  std::size_t n_vertices_;
+  Aabb bounds_;
+
+  std::vector<std::uint32_t> counts_;
+  std::vector<std::uint32_t> order_;
+
+  // draw arguments, rebuilt after writes or a new order
+  std::vector<std::int32_t> draw_firsts_;
+  std::vector<std::int32_t> draw_counts_;
+  bool draw_dirty_;
+
+  std::uint32_t vao_;
+  std::uint32_t vbo_;
+};
+
 class MeshTriangle : public IMesh {
  public:
   MeshTriangle(MeshObjData obj_data);
   ~MeshTriangle();
 
   auto Draw() -> void override;
+  auto VertexArray() const noexcept -> std::uint32_t override;
+  auto Bounds() const noexcept -> Aabb override;
+
+  auto VertexBuffer() const noexcept -> std::uint32_t;
+  auto VertexCount() const noexcept -> std::size_t;
 
  private:
   std::size_t n_vertices_;
+  Aabb bounds_;
 
   std::uint32_t vao_;
   std::uint32_t vbo_;
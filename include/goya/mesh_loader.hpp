@@ -1,11 +1,20 @@
 #pragma once
 
 #include <string>
+#include <vector>
 
 #include "goya/mesh_obj_data.hpp"
+#include "goya/primitives.hpp"
 
 namespace goya {
 
+namespace detail {
+
+// scales vertices uniformly into the [-1, 1] cube
+auto NormalizeVertices(std::vector<Vertex3d>& vertices) -> void;
+
+}  // namespace detail
+
 auto LoadMeshObjData(std::string const& path) -> MeshObjData;
 
 auto LoadMeshObjData(char const* path) -> MeshObjData;
@@ -6,6 +6,7 @@
 #include "glm/glm.hpp"
 #include "glm/gtc/matrix_transform.hpp"
 #include "goya//drawable.hpp"
+#include "goya/bounds.hpp"
 #include "goya/mesh.hpp"
 
 namespace goya {
@@ -21,7 +22,16 @@ class Model : public IDrawable {
   auto SetModelMatrix(glm::mat4 model) -> void;
   auto SetColor(glm::vec3 color) -> void;
 
+  auto ModelMatrix() const noexcept -> glm::mat4 const&;
+
+  // world space bounds of the wrapped mesh
+  auto Bounds() const noexcept -> Aabb;
+
+  // bumped on every transform change
+  auto TransformVersion() const noexcept -> std::uint32_t;
+
   auto Draw() -> void override;
+  auto Submit(RenderQueue& queue) -> void override;
 
  private:
   auto UpdateUniforms() -> void;
@@ -31,6 +41,12 @@ class Model : public IDrawable {
 
   std::shared_ptr<Shader> shader_;
   std::shared_ptr<IDrawable> drawable_;
+
+  // vao of the wrapped mesh, only used for sorting
+  std::uint32_t vao_hint_;
+
+  Aabb local_bounds_;
+  std::uint32_t transform_version_ = 0U;
 };
 
 }  // namespace goya
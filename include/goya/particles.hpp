@@ -5,6 +5,7 @@
 #include <vector>
 
 #include "glm/glm.hpp"
+#include "goya/job_system.hpp"
 #include "goya/mesh.hpp"
 #include "goya/primitives.hpp"
 #include "goya/shader.hpp"
@@ -18,6 +19,12 @@ struct Particle {
   float life_len;
 };
 
+// render side copy of the per instance buffers of a particle effect
+struct ParticleSnapshot {
+  std::vector<glm::vec3> positions;
+  std::vector<glm::vec4> colors;
+};
+
 class ParticleEffect : public IDrawable {
  public:
   ParticleEffect(std::shared_ptr<Shader> shader,
@@ -27,17 +34,28 @@ class ParticleEffect : public IDrawable {
 
   ~ParticleEffect();
 
+  // simulation side, no gl calls
   auto Update(TimeType const delta) -> void;
+  auto Update(TimeType const delta, JobSystem& jobs) -> void;
+  auto Capture(ParticleSnapshot& dst) const -> void;
+
+  // render side, Draw() renders whatever was uploaded last
+  auto Upload() -> void;
+  auto Upload(ParticleSnapshot const& src) -> void;
+
   auto Draw() -> void override;
+  auto Submit(RenderQueue& queue) -> void override;
 
   auto SetScale(glm::mat4 const scale_matrix) -> void;
 
  private:
   auto UpdateLife(TimeType const delta) -> void;
-  auto UpdatePositionsBuffer() -> void;
-  auto UpdateColorBuffer() -> void;
   auto Respawn(TimeType const delta) -> void;
-  auto UpdateBuffers() -> void;
+  auto ResizeBuffers() -> void;
+  auto FillBuffers(std::size_t first, std::size_t last) -> void;
+  auto InitGl() -> void;
+  auto UploadBuffers(std::vector<glm::vec3> const& positions,
+                     std::vector<glm::vec4> const& colors) -> void;
 
   std::shared_ptr<Shader> shader_;
   std::function<Particle(void)> particle_src_;
@@ -51,6 +69,12 @@ class ParticleEffect : public IDrawable {
   std::vector<glm::vec3> pos_buffer_;
   std::vector<glm::vec4> color_buffer_;
 
+  std::size_t n_uploaded_;
+  glm::vec3 uploaded_anchor_;
+
+  glm::mat4 scale_matrix_;
+  bool scale_dirty_;
+
   std::uint32_t vao_;
   std::uint32_t vbo_vertex_;
   std::uint32_t vbo_pos_;
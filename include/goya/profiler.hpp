@@ -0,0 +1,181 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace goya {
+
+enum class ProfileEventKind : std::uint8_t { kCpuZone, kGpuZone, kCounter };
+
+// names are never copied, they have to outlive the profiler (literals)
+struct ProfileEvent {
+  char const* name;
+  ProfileEventKind kind;
+  std::uint32_t thread;
+
+  std::uint64_t start_ns;
+  std::uint64_t end_ns;
+  double value;  // counters only
+};
+
+// merged per name, equal names from different call sites add up
+struct ProfileTotals {
+  std::string name;
+  ProfileEventKind kind = ProfileEventKind::kCpuZone;
+
+  std::uint64_t calls = 0U;
+  std::uint64_t total_ns = 0U;
+  std::uint64_t max_ns = 0U;
+
+  double counter_sum = 0.0;
+  double counter_last = 0.0;
+};
+
+// CPU zones and counters are written to a ring buffer owned by the recording
+// thread, the render thread drains all rings once per frame in BeginFrame().
+// GPU zones are GL_TIME_ELAPSED queries which can not nest, a GPU zone opened
+// inside another one is dropped. Queries are double buffered per frame and
+// only read back once available, so reading them never stalls the pipeline.
+class Profiler {
+ public:
+  Profiler();
+  ~Profiler();
+
+  Profiler(Profiler const&) = delete;
+  Profiler& operator=(Profiler const&) = delete;
+
+  auto SetEnabled(bool enabled) noexcept -> void;
+  auto Enabled() const noexcept -> bool;
+
+  // keep drained events around for WriteChromeTrace()
+  auto SetCapture(bool capture) -> void;
+
+  // print a rolling summary to stdout every interval, 0 disables it
+  auto SetSummaryInterval(double seconds) -> void;
+
+  // names the calling thread in summaries and traces
+  auto SetThreadName(std::string name) -> void;
+
+  auto Now() const noexcept -> std::uint64_t;
+
+  // any thread
+  auto RecordZone(char const* name, std::uint64_t start_ns,
+                  std::uint64_t end_ns) -> void;
+  auto Counter(char const* name, double value) -> void;
+
+  // render thread with a current context, false if the zone was dropped
+  auto BeginGpuZone(char const* name) -> bool;
+  auto EndGpuZone() -> void;
+
+  // render thread, once per frame right after presenting
+  auto BeginFrame() -> void;
+
+  // deletes the queries, has to run while the context is still alive
+  auto ReleaseGpu() -> void;
+
+  // everything drained since the summary was last printed or reset
+  auto SummaryTotals() const -> std::vector<ProfileTotals>;
+  auto SummaryFrames() const noexcept -> std::uint64_t;
+  auto ResetSummary() -> void;
+
+  auto PrintSummary(std::ostream& ostrm) -> void;
+  auto WriteChromeTrace(std::string const& path) -> void;
+
+ private:
+  using Clock = std::chrono::steady_clock;
+
+  struct ThreadBuffer;
+  struct GpuFrame;
+
+  struct ZoneStats {
+    ProfileEventKind kind;
+    std::uint64_t calls = 0U;
+    std::uint64_t total_ns = 0U;
+    std::uint64_t max_ns = 0U;
+
+    double counter_sum = 0.0;
+    double counter_last = 0.0;
+  };
+
+  auto LocalBuffer() -> ThreadBuffer&;
+  auto Push(ProfileEvent const& event) -> void;
+
+  auto Collect() -> void;
+  auto CollectGpu(GpuFrame& frame) -> void;
+  auto Accumulate(ProfileEvent const& event) -> void;
+
+  Clock::time_point epoch_;
+  std::atomic<bool> enabled_;
+
+  std::mutex buffers_mtx_;
+  std::vector<std::unique_ptr<ThreadBuffer>> buffers_;
+
+  std::vector<std::unique_ptr<GpuFrame>> gpu_frames_;
+  std::size_t gpu_frame_idx_;
+  bool gpu_zone_open_;
+  std::uint64_t gpu_dropped_;
+
+  bool capture_;
+  std::vector<ProfileEvent> captured_;
+
+  double summary_interval_;
+  std::uint64_t summary_start_ns_;
+  std::uint64_t summary_frames_;
+  std::unordered_map<char const*, ZoneStats> summary_;
+};
+
+auto GlobalProfiler() -> Profiler&;
+
+class ScopedZone {
+ public:
+  explicit ScopedZone(char const* name) noexcept;
+  ~ScopedZone();
+
+  ScopedZone(ScopedZone const&) = delete;
+  ScopedZone& operator=(ScopedZone const&) = delete;
+
+ private:
+  char const* name_;
+  std::uint64_t start_ns_;
+};
+
+class ScopedGpuZone {
+ public:
+  explicit ScopedGpuZone(char const* name);
+  ~ScopedGpuZone();
+
+  ScopedGpuZone(ScopedGpuZone const&) = delete;
+  ScopedGpuZone& operator=(ScopedGpuZone const&) = delete;
+
+ private:
+  bool active_;
+};
+
+}  // namespace goya
+
+#define GOYA_PROFILE_CONCAT_IMPL(a, b) a##b
+#define GOYA_PROFILE_CONCAT(a, b) GOYA_PROFILE_CONCAT_IMPL(a, b)
+
+#ifdef GOYA_PROFILER_ENABLED
+#define GOYA_PROFILE_ZONE(name) \
+  ::goya::ScopedZone const GOYA_PROFILE_CONCAT(goya_zone_, __LINE__)(name)
+#define GOYA_PROFILE_GPU_ZONE(name)                                        \
+  ::goya::ScopedGpuZone const GOYA_PROFILE_CONCAT(goya_gpu_zone_, __LINE__)( \
+      name)
+#define GOYA_PROFILE_COUNTER(name, value) \
+  ::goya::GlobalProfiler().Counter(name, static_cast<double>(value))
+#define GOYA_PROFILE_THREAD_NAME(name) \
+  ::goya::GlobalProfiler().SetThreadName(name)
+#else
+#define GOYA_PROFILE_ZONE(name) static_cast<void>(0)
+#define GOYA_PROFILE_GPU_ZONE(name) static_cast<void>(0)
+#define GOYA_PROFILE_COUNTER(name, value) static_cast<void>(0)
+#define GOYA_PROFILE_THREAD_NAME(name) static_cast<void>(0)
+#endif
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+#include "glm/glm.hpp"
+#include "goya/drawable.hpp"
+
+namespace goya {
+
+enum class RenderPass : std::uint8_t {
+  kOpaque = 0,
+  kTransparent = 1,
+  kOverlay = 2
+};
+
+// 64 bit sort key, most significant bits first:
+//   opaque/overlay: pass(4) | program(12) | vao(16) | depth(24) | unused(8)
+//   transparent:    pass(4) | far-to-near depth(24) | program(12) | vao(16)
+// so opaque draws group by state and transparent ones blend back to front
+// depth is expected in [0, 1], see RenderQueue::Depth
+auto MakeDrawKey(RenderPass pass, std::uint32_t program, std::uint32_t vao,
+                 float depth) noexcept -> std::uint64_t;
+
+auto DrawKeyPass(std::uint64_t key) noexcept -> RenderPass;
+
+struct DrawPacket {
+  std::uint64_t key;
+  IDrawable* drawable;
+};
+
+// per thread recording buffer, handed over with RenderQueue::Merge
+class DrawList {
+ public:
+  auto Push(std::uint64_t key, IDrawable* drawable) -> void;
+
+  auto Size() const noexcept -> std::size_t;
+  auto Clear() noexcept -> void;
+
+ private:
+  friend class RenderQueue;
+
+  std::vector<DrawPacket> packets_;
+};
+
+class RenderQueue {
+ public:
+  auto SetView(glm::vec3 eye, glm::vec3 front, float far_plane) -> void;
+
+  // normalized view depth of a world space point
+  auto Depth(glm::vec3 pos) const noexcept -> float;
+
+  // records from the owning thread
+  auto Push(std::uint64_t key, IDrawable* drawable) -> void;
+
+  // thread safe, moves all packets out of the list
+  auto Merge(DrawList& list) -> void;
+
+  auto Size() const noexcept -> std::size_t;
+
+  auto Sort() -> void;
+
+  // sorts, draws every packet and leaves the queue empty for the next frame
+  auto Execute() -> void;
+
+ private:
+  glm::vec3 eye_ = glm::vec3(0.f);
+  glm::vec3 front_ = glm::vec3(0.f, 0.f, -1.f);
+  float far_plane_ = 100.f;
+
+  std::mutex merge_mtx_;
+
+  std::vector<DrawPacket> packets_;
+  std::vector<DrawPacket> scratch_;
+};
+
+}  // namespace goya
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "goya/camera.hpp"
+#include "goya/dynamic_bvh.hpp"
+#include "goya/model.hpp"
+
+namespace goya {
+
+struct CullStats {
+  std::size_t objects = 0;
+  std::size_t visible = 0;
+  std::size_t nodes_visited = 0;
+  std::size_t reinserted = 0;
+
+  float update_ms = 0.f;
+  float cull_ms = 0.f;
+};
+
+// Owns world space bounds of models in a dynamic bvh and culls them against
+// the camera frustum. Model transforms are polled through their version
+// counter, so only models that moved since the last Update() are refitted.
+class Scene {
+ public:
+  using ObjectId = std::uint32_t;
+
+  auto Add(std::shared_ptr<Model> model) -> ObjectId;
+  auto Remove(ObjectId id) -> void;
+
+  auto Update() -> void;
+  auto Cull(Camera const& camera) -> std::vector<Model*> const&;
+
+  // submits the models that survived the last Cull()
+  auto Submit(RenderQueue& queue) -> void;
+
+  auto Stats() const noexcept -> CullStats const&;
+
+ private:
+  struct Entry {
+    std::shared_ptr<Model> model;
+    std::int32_t proxy;
+    std::uint32_t version;
+  };
+
+  DynamicBvh bvh_;
+
+  std::vector<Entry> entries_;
+  std::vector<ObjectId> free_ids_;
+
+  std::vector<std::uint32_t> visible_ids_;
+  std::vector<Model*> visible_;
+
+  CullStats stats_;
+};
+
+}  // namespace goya
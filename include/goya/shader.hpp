@@ -11,6 +11,10 @@ class Shader {
  public:
   Shader(char const* vertex_src_path, char const* fragment_src_path);
 
+  // with tessellation stages, the program draws GL_PATCHES
+  Shader(char const* vertex_src_path, char const* tess_control_src_path,
+         char const* tess_evaluation_src_path, char const* fragment_src_path);
+
   auto Id() const noexcept -> std::uint32_t;
   auto Use() const noexcept -> void;
 
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "glm/glm.hpp"
+#include "goya/b_spline.hpp"
+#include "goya/instanced_model.hpp"
+#include "goya/job_system.hpp"
+#include "goya/primitives.hpp"
+
+namespace goya {
+
+// Moves crowds of objects along shared splines. Followers keep their path,
+// arc length, speed and offset in separate arrays, Update() advances them in
+// batches per job and writes model matrices straight to the destination.
+// Paths are borrowed, they have to outlive the followers and must not change
+// their control points while an Update() runs.
+class SplineFollowers {
+ public:
+  auto AddPath(CubeBSpline const& path) -> std::uint32_t;
+
+  // offset is applied in the frame of the follower, x to the side, y along
+  // the normal and z along the path. speed is in world units per second
+  auto AddFollower(std::uint32_t path, float distance, float speed,
+                   glm::vec3 offset = glm::vec3(0.f)) -> std::size_t;
+
+  auto Size() const noexcept -> std::size_t;
+  auto Distance(std::size_t follower) const -> float;
+
+  // uniform scale of every model matrix
+  auto SetScale(float scale) noexcept -> void;
+
+  // dst holds Size() matrices
+  auto Update(TimeType delta, JobSystem& jobs, glm::mat4* dst) -> void;
+
+  // into the instances [first, first + Size())
+  auto Update(TimeType delta, JobSystem& jobs, InstancedModel& dst,
+              std::size_t first = 0U) -> void;
+
+ private:
+  template <class Store>
+  auto UpdateBatch(TimeType delta, std::size_t first, std::size_t last,
+                   Store const& store) -> void;
+
+  std::vector<CubeBSpline const*> paths_;
+
+  std::vector<std::uint32_t> path_;
+  std::vector<float> distance_;
+  std::vector<float> speed_;
+  std::vector<glm::vec3> offset_;
+
+  float scale_ = 1.f;
+};
+
+}  // namespace goya
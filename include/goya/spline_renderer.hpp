@@ -0,0 +1,78 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "glm/glm.hpp"
+#include "goya/drawable.hpp"
+#include "goya/primitives.hpp"
+#include "goya/shader.hpp"
+
+namespace goya {
+
+// Draws uniform cubic b-splines with tessellation shaders, see
+// shaders/spline.*. Only control points are uploaded and every segment is a
+// patch of the four points it depends on, so any number of curves is one
+// draw call without cpu tessellation. The control stage culls patches and
+// picks their line count from the projected size.
+class SplineRenderer : public IDrawable {
+ public:
+  explicit SplineRenderer(std::shared_ptr<Shader> shader);
+  ~SplineRenderer();
+
+  SplineRenderer(SplineRenderer const&) = delete;
+  SplineRenderer& operator=(SplineRenderer const&) = delete;
+
+  // returns the curve index, a curve needs at least four points
+  auto AddCurve(std::vector<Vertex3d> const& control_points) -> std::size_t;
+
+  // the point count of a curve is fixed, only changed points are uploaded
+  auto SetControlPoints(std::size_t curve,
+                        std::vector<Vertex3d> const& control_points) -> void;
+  auto SetControlPoint(std::size_t curve, std::size_t idx, Vertex3d point)
+      -> void;
+
+  auto CurveCount() const noexcept -> std::size_t;
+  auto PatchCount() const noexcept -> std::size_t;
+
+  auto SetColor(glm::vec3 color) -> void;
+
+  // target screen length of one tessellated line
+  auto SetPixelsPerLine(float pixels) -> void;
+
+  auto Draw() -> void override;
+  auto Submit(RenderQueue& queue) -> void override;
+
+ private:
+  struct Curve {
+    std::size_t first;
+    std::size_t count;
+  };
+
+  auto MarkDirty(std::size_t first, std::size_t count) -> void;
+  auto Upload() -> void;
+
+  std::shared_ptr<Shader> shader_;
+
+  std::vector<Curve> curves_;
+  std::vector<Vertex3d> points_;
+  std::vector<std::uint32_t> indices_;
+
+  // dirty point range, indices only change when curves are added
+  std::size_t dirty_first_;
+  std::size_t dirty_last_;
+  bool indices_dirty_;
+
+  std::size_t gpu_points_;
+  std::size_t gpu_indices_;
+
+  glm::vec3 color_ = glm::vec3(0.f, 0.5f, 0.5f);
+  float pixels_per_line_ = 8.f;
+
+  std::uint32_t vao_;
+  std::uint32_t vbo_;
+  std::uint32_t ebo_;
+};
+
+}  // namespace goya
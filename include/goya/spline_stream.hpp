@@ -0,0 +1,73 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include "goya/b_spline.hpp"
+#include "goya/job_system.hpp"
+#include "goya/primitives.hpp"
+#include "goya/shader.hpp"
+#include "goya/trajectory_source.hpp"
+
+namespace goya {
+
+// Follows a trajectory that is only partly resident. A window of control
+// points around the current segment is kept in a CubeBSpline, so only its
+// segments are evaluated and tessellated. The chunk of points behind the
+// window is read on the job system ahead of time. Whenever the current
+// segment passes the middle of the window a few points are dropped in front
+// and as many appended from the chunk, so building the new segments costs
+// about as much per frame as the distance moved. Past the end of the
+// trajectory it starts over with the first window.
+class SplineStream {
+ public:
+  static constexpr auto kDefaultWindow = std::size_t(4096U);
+  static constexpr auto kDefaultChunk = std::size_t(1024U);
+
+  // trajectories of at most window points stay resident as a whole
+  SplineStream(std::shared_ptr<TrajectorySource const> source,
+               std::shared_ptr<Shader> shader,
+               std::size_t window = kDefaultWindow,
+               std::size_t chunk = kDefaultChunk);
+  ~SplineStream();
+
+  SplineStream(SplineStream const&) = delete;
+  SplineStream& operator=(SplineStream const&) = delete;
+
+  // moves the window, so no Draw() or Submit() of the spline may run at the
+  // same time
+  auto TimeUpdate(TimeType delta, JobSystem& jobs) -> void;
+
+  auto Spline() noexcept -> CubeBSpline&;
+  auto Spline() const noexcept -> CubeBSpline const&;
+
+  // trajectory index of the first resident control point
+  auto FirstPoint() const noexcept -> std::size_t;
+  auto IsStreaming() const noexcept -> bool;
+
+ private:
+  auto Slide(JobSystem& jobs) -> bool;
+  auto Prefetch(JobSystem& jobs) -> void;
+  auto Restart(JobSystem& jobs) -> void;
+  auto WaitPrefetch() -> void;
+
+  std::shared_ptr<TrajectorySource const> source_;
+  CubeBSpline spline_;
+
+  std::size_t window_;
+  std::size_t chunk_;
+  std::size_t first_ = 0U;
+
+  // points appended next, from ready_used_ on
+  std::vector<Vertex3d> ready_;
+  std::size_t ready_used_ = 0U;
+  std::vector<Vertex3d> step_;
+
+  // the chunk behind ready_, filled by the job in flight
+  std::vector<Vertex3d> next_;
+  std::size_t next_first_ = 0U;
+  TaskGroup prefetch_;
+  JobSystem* prefetch_jobs_ = nullptr;
+};
+
+}  // namespace goya
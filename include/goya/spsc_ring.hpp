@@ -0,0 +1,71 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+
+namespace goya {
+
+// Lock free single producer, single consumer queue of at most Capacity
+// values. Head and tail only ever grow, each side keeps a cached copy of the
+// other one's index so it touches the shared cache line only when the ring
+// looks full or empty.
+template <class T, std::size_t Capacity>
+class SpscRing {
+  static_assert(Capacity != 0U && (Capacity & (Capacity - 1U)) == 0U,
+                "capacity has to be a power of two");
+
+ public:
+  // producer side, false when full
+  auto TryPush(T const& value) noexcept -> bool {
+    auto const tail = tail_.load(std::memory_order_relaxed);
+    if (tail - head_cache_ == Capacity) {
+      head_cache_ = head_.load(std::memory_order_acquire);
+      if (tail - head_cache_ == Capacity) {
+        return false;
+      }
+    }
+
+    slots_[tail & kMask] = value;
+    tail_.store(tail + 1U, std::memory_order_release);
+    return true;
+  }
+
+  // consumer side, false when empty
+  auto TryPop(T& dst) noexcept -> bool {
+    auto const head = head_.load(std::memory_order_relaxed);
+    if (head == tail_cache_) {
+      tail_cache_ = tail_.load(std::memory_order_acquire);
+      if (head == tail_cache_) {
+        return false;
+      }
+    }
+
+    dst = slots_[head & kMask];
+    head_.store(head + 1U, std::memory_order_release);
+    return true;
+  }
+
+  // either side, exact only while the other one is idle
+  auto SizeApprox() const noexcept -> std::size_t {
+    return tail_.load(std::memory_order_acquire) -
+           head_.load(std::memory_order_acquire);
+  }
+
+  static constexpr auto Size() noexcept -> std::size_t { return Capacity; }
+
+ private:
+  static auto constexpr kMask = Capacity - 1U;
+
+  std::array<T, Capacity> slots_{};
+
+  // consumer
+  alignas(64) std::atomic<std::size_t> head_{0U};
+  std::size_t tail_cache_ = 0U;
+
+  // producer
+  alignas(64) std::atomic<std::size_t> tail_{0U};
+  std::size_t head_cache_ = 0U;
+};
+
+}  // namespace goya
@@ -0,0 +1,116 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include "goya/b_spline.hpp"
+#include "goya/camera.hpp"
+#include "goya/engine.hpp"
+#include "goya/geometry_arena.hpp"
+#include "goya/instanced_model.hpp"
+#include "goya/mesh.hpp"
+#include "goya/mesh_obj_data.hpp"
+#include "goya/model.hpp"
+#include "goya/particles.hpp"
+#include "goya/render_queue.hpp"
+#include "goya/scene.hpp"
+#include "goya/shader.hpp"
+#include "goya/spline_followers.hpp"
+#include "goya/spline_renderer.hpp"
+
+namespace goya {
+
+struct StressConfig {
+  std::size_t models = 1U;
+  std::size_t effects = 1U;
+  std::size_t particles_per_effect = 1000U;
+
+  // every path is a random spline through this many control points inside
+  // a cube of half size extent around the origin
+  std::size_t control_points = 12U;
+  float extent = 20.f;
+
+  // instanced crowds sharing a few paths, they use the first mesh
+  std::size_t followers = 0U;
+  std::size_t follower_paths = 8U;
+
+  // static props scattered like the models, baked into world space and
+  // drawn together with a single multi draw
+  std::size_t props = 0U;
+
+  std::uint32_t seed = 42U;
+};
+
+struct StressShaders {
+  std::shared_ptr<Shader> model;
+  std::shared_ptr<Shader> particle;
+
+  // optional, draws every model path with a SplineRenderer
+  std::shared_ptr<Shader> path;
+
+  // needed for followers
+  std::shared_ptr<Shader> instanced;
+};
+
+// Procedural scene for scaling runs. Models cycle through the given meshes
+// and each one follows its own random spline, every particle effect emits
+// from the head of another one. Followers are one instanced draw moved by
+// SplineFollowers. Model and prop meshes live in one geometry arena, so the
+// models share a vertex array and the props are one ArenaBatch. Generation
+// is deterministic for a seed.
+class StressScene {
+ public:
+  StressScene(StressConfig const& config,
+              std::vector<MeshObjData> const& meshes,
+              StressShaders const& shaders);
+
+  StressScene(StressScene const&) = delete;
+  StressScene& operator=(StressScene const&) = delete;
+
+  // registers the simulation and render handlers, both have to outlive the
+  // engine's Run()
+  auto Attach(Engine& engine, Camera const& camera, float far_plane) -> void;
+
+  auto Config() const noexcept -> StressConfig const&;
+
+ private:
+  auto SpawnFollowers(std::minstd_rand& rng, MeshObjData const& mesh,
+                      std::shared_ptr<Shader> instanced_shader) -> void;
+  auto SpawnProps(std::minstd_rand& rng,
+                  std::vector<std::vector<Vertex3d>> const& soups,
+                  std::shared_ptr<Shader> shader) -> void;
+  auto SimulatePaths(TimeType delta, FrameSnapshot& snapshot, JobSystem& jobs)
+      -> void;
+  auto SimulateEffects(TimeType delta, FrameSnapshot& snapshot,
+                       JobSystem& jobs) -> void;
+  auto Render(FrameSnapshot const& snapshot, Camera const& camera,
+              float far_plane, JobSystem& jobs) -> void;
+
+  StressConfig config_;
+
+  std::vector<CubeBSpline> paths_;
+  std::vector<CubeBSpline> emitter_paths_;
+
+  // models_ and props_ draw from here
+  std::shared_ptr<GeometryArena> arena_;
+  std::vector<std::shared_ptr<ArenaMesh>> meshes_;
+
+  std::vector<std::shared_ptr<Model>> models_;
+  std::vector<std::shared_ptr<ParticleEffect>> effects_;
+  std::unique_ptr<SplineRenderer> path_renderer_;
+
+  // followers point into follower_paths_, it must never reallocate
+  std::vector<CubeBSpline> follower_paths_;
+  SplineFollowers followers_;
+  std::unique_ptr<InstancedModel> follower_instances_;
+
+  std::vector<std::unique_ptr<ArenaMesh>> props_;
+  std::unique_ptr<ArenaBatch> prop_batch_;
+
+  Scene scene_;
+  RenderQueue queue_;
+};
+
+}  // namespace goya
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "goya/primitives.hpp"
+
+namespace goya {
+
+// Read only view of a trajectory file that is too big to load at once. The
+// file is memory mapped, so only the pages of points that are read become
+// resident. Binary files start with kBinaryMagic and a little endian uint64
+// point count followed by x, y and z float32 per point. Anything else is
+// text with three whitespace separated numbers per point, like the control
+// point files. Read() is const and may run on several threads at once.
+class TrajectorySource {
+ public:
+  static constexpr char kBinaryMagic[8] = {'G', 'O', 'Y', 'A',
+                                           'T', 'R', 'J', '1'};
+
+  explicit TrajectorySource(std::string const& path);
+  ~TrajectorySource();
+
+  TrajectorySource(TrajectorySource const&) = delete;
+  TrajectorySource& operator=(TrajectorySource const&) = delete;
+
+  auto Size() const noexcept -> std::size_t;
+  auto IsBinary() const noexcept -> bool;
+
+  // points [first, first + count), clamped to Size(). returns the number of
+  // points written to dst
+  auto Read(std::size_t first, std::size_t count, Vertex3d* dst) const
+      -> std::size_t;
+  auto Read(std::size_t first, std::size_t count) const
+      -> std::vector<Vertex3d>;
+
+  // writes points as a binary trajectory
+  static auto WriteBinary(std::string const& path,
+                          std::vector<Vertex3d> const& points) -> void;
+
+ private:
+  auto IndexText() -> void;
+  auto Unmap() noexcept -> void;
+
+  char const* data_ = nullptr;
+  std::size_t size_ = 0U;
+
+  // owns the bytes where memory mapping is not available
+  std::vector<char> buffer_;
+
+  std::size_t n_points_ = 0U;
+  bool binary_ = false;
+
+  // text only, byte offset of every kIndexStride-th point so a read parses
+  // at most kIndexStride - 1 points it does not return
+  std::vector<std::uint64_t> index_;
+};
+
+}  // namespace goya
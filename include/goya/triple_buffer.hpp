@@ -0,0 +1,51 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+namespace goya {
+
+// Wait free single producer, single consumer mailbox. The producer always
+// owns a back slot and the consumer a front slot; publishing swaps the back
+// slot with the shared middle one, acquiring swaps the front slot with it.
+// Neither side ever blocks the other and the consumer always sees the newest
+// complete value, stale ones are silently dropped.
+template <class T>
+class TripleBuffer {
+ public:
+  // producer side
+  auto Back() noexcept -> T& { return slots_[back_]; }
+
+  auto Publish() noexcept -> void {
+    auto const fresh_back = static_cast<std::uint8_t>(back_ | kFresh);
+    auto const prev = state_.exchange(fresh_back, std::memory_order_acq_rel);
+    back_ = static_cast<std::uint8_t>(prev & kIndexMask);
+  }
+
+  // consumer side, returns false if nothing new was published
+  auto Acquire() noexcept -> bool {
+    if (!(state_.load(std::memory_order_relaxed) & kFresh)) {
+      return false;
+    }
+
+    auto const prev = state_.exchange(front_, std::memory_order_acq_rel);
+    front_ = static_cast<std::uint8_t>(prev & kIndexMask);
+    return true;
+  }
+
+  auto Front() noexcept -> T& { return slots_[front_]; }
+  auto Front() const noexcept -> T const& { return slots_[front_]; }
+
+ private:
+  static auto constexpr kIndexMask = std::uint8_t(0x03);
+  static auto constexpr kFresh = std::uint8_t(0x04);
+
+  std::array<T, 3> slots_;
+
+  std::uint8_t back_ = 0U;
+  std::uint8_t front_ = 1U;
+  std::atomic<std::uint8_t> state_{2U};
+};
+
+}  // namespace goya
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <cstdint>
+#include <memory_resource>
 #include <string>
 #include <vector>
 
@@ -10,12 +11,30 @@
 /* clang-format on */
 
 #include "goya/events.hpp"
+#include "goya/frame_arena.hpp"
+#include "goya/input_state.hpp"
 
 namespace goya {
 
+enum class WindowMode : std::uint8_t {
+  kWindowed,
+  // invisible window rendering into an offscreen framebuffer, for runs
+  // without a display such as CI or Mesa llvmpipe render nodes
+  kHeadless
+};
+
+// how far the cpu may run ahead of the gpu, fewer queued frames show input
+// sooner. headless windows always finish every frame
+enum class FrameLimit : std::uint8_t {
+  kNone,    // as many as the driver queues
+  kFinish,  // glFinish after every present
+  kFence    // wait on fences once more than max_queued frames are in flight
+};
+
 class Window {
  public:
-  Window(std::int32_t width, std::int32_t height, std::string title);
+  Window(std::int32_t width, std::int32_t height, std::string title,
+         WindowMode mode = WindowMode::kWindowed);
 
   Window(Window const&) = delete;
   Window& operator=(Window const&) = delete;
@@ -23,8 +42,42 @@ class Window {
   Window(Window&&) = delete;
   Window& operator=(Window&&) = delete;
 
+  // Present(), BeginFrame() and PollInput() in one, false once the window
+  // should close
   auto Refresh() -> bool;
 
+  // the parts of Refresh() for frame loops that poll input later, e.g. right
+  // before the camera is used
+  auto Present() -> void;
+  auto BeginFrame() -> void;
+  // runs the key, cursor and animation handlers with the time since the last
+  // poll, false once the window should close
+  auto PollInput() -> bool;
+
+  auto SetFrameLimit(FrameLimit limit, std::uint32_t max_queued = 1U) -> void;
+
+  // glfw time of the last poll and of the return of the last present,
+  // including the frame limit wait
+  auto PollTime() const noexcept -> double;
+  auto PresentTime() const noexcept -> double;
+
+  // keys and cursor as of the last PollInput(), edges and cursor motion are
+  // the ones since the poll before. PollDelta() is the time between them
+  auto Input() const noexcept -> InputState const&;
+  auto PollDelta() const noexcept -> TimeType;
+
+  // every event is pushed to queue as well, e.g. for a simulation thread that
+  // keeps its own InputState. null stops it, a full queue drops events
+  auto SetInputQueue(InputQueue* queue) noexcept -> void;
+  auto DroppedInputEvents() const noexcept -> std::uint64_t;
+
+  // PollInput() with recorded events and poll delta instead of live ones,
+  // which are dropped. the queue does not see replayed events
+  auto ReplayInput(std::vector<InputEvent> const& events, TimeType poll_delta)
+      -> bool;
+  // forgets held keys, the cursor starts at x_pos, y_pos
+  auto ResetInput(double x_pos, double y_pos) -> void;
+
   auto Width() const noexcept -> std::int32_t;
   auto Height() const noexcept -> std::int32_t;
   auto AspectRatio() const noexcept -> float;
@@ -34,6 +87,16 @@ class Window {
   auto Title() const -> std::string const&;
   auto WinPtr() -> GLFWwindow*;
 
+  auto Mode() const noexcept -> WindowMode;
+
+  // framebuffer frames are rendered into, 0 for the default one
+  auto Framebuffer() const noexcept -> std::uint32_t;
+
+  // render thread scratch memory, reset by the next BeginFrame()
+  auto FrameMemory() noexcept -> FrameArena&;
+
+  // every handler is called for every event, polling Input() once per frame
+  // does not depend on the event rate
   auto AddKeyHandler(KeyEventHandler key_handler) -> void;
   auto AddCursorHandler(CursorEventHandler mouse_handler) -> void;
   auto AddWinResizeHandler(WinResizeEventHandler win_resize_handlers) -> void;
@@ -43,6 +106,12 @@ class Window {
 
  private:
   struct GlfwBridge {
+    auto BeginFrame() -> void;
+
+    // live events, dropped while replaying
+    auto Push(InputEvent const& event) -> void;
+    auto Deliver(InputEvent const& event) -> void;
+
     auto ResizeCallback(std::int32_t const width, std::int32_t const height)
         -> void;
 
@@ -55,8 +124,16 @@ class Window {
     std::int32_t width_;
     std::int32_t height_;
 
-    std::vector<KeyEvent> key_events_;
-    std::vector<CursorEvent> cursor_events_;
+    // events only live until the handlers ran, their storage is frame memory
+    FrameArena frame_arena_;
+    std::pmr::vector<KeyEvent> key_events_{&frame_arena_};
+    std::pmr::vector<CursorEvent> cursor_events_{&frame_arena_};
+
+    InputState input_;
+    InputQueue* input_queue_ = nullptr;
+    std::uint64_t dropped_events_ = 0U;
+    double poll_time_ = 0.0;
+    bool replaying_ = false;
 
     std::vector<KeyEventHandler> key_handlers_;
     std::vector<CursorEventHandler> cursor_handlers_;
@@ -64,10 +141,24 @@ class Window {
     std::vector<AnimationHandler> animation_handlers_;
   };
 
+  auto CreateOffscreenTarget() -> void;
+  auto LimitFrames() -> void;
+
   std::string title_;
+  WindowMode mode_;
   GLFWwindow* win_ptr_;
 
-  double prev_refresh_;
+  std::uint32_t fbo_;
+  std::uint32_t rbo_color_;
+  std::uint32_t rbo_depth_;
+
+  FrameLimit frame_limit_;
+  std::uint32_t max_queued_;
+  std::vector<GLsync> fences_;
+
+  double prev_poll_;
+  double present_time_;
+  TimeType poll_delta_;
   GlfwBridge gb_;
 };
 
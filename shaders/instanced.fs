@@ -0,0 +1,8 @@
+#version 410 core
+
+in vec3 InstanceColor;
+out vec4 FragColor;
+
+void main() { 
+    FragColor = vec4(InstanceColor, 1.f);
+} 
@@ -0,0 +1,15 @@
+#version 410 core
+
+layout (location = 0) in vec3 aPos;
+layout (location = 1) in mat4 aModel;
+layout (location = 5) in vec3 aColor;
+
+out vec3 InstanceColor;
+
+uniform mat4 view;
+uniform mat4 projection;
+
+void main(){
+	gl_Position = projection * view * aModel * vec4(aPos, 1.0);
+	InstanceColor = aColor;
+}
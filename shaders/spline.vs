@@ -0,0 +1,8 @@
+#version 410 core
+
+layout (location = 0) in vec3 aPos;
+
+// control points pass through, the evaluation stage projects the curve
+void main(){
+	gl_Position = vec4(aPos, 1.0);
+}
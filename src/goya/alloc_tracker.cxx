@@ -0,0 +1,297 @@
+#include "goya/alloc_tracker.hpp"
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+namespace goya {
+
+namespace detail {
+
+// one cache line per subsystem, threads tagged differently do not contend
+struct alignas(64) AllocCounters {
+  std::atomic<std::uint64_t> allocations;
+  std::atomic<std::uint64_t> deallocations;
+  std::atomic<std::uint64_t> bytes;
+};
+
+// static storage is zero initialized before any dynamic initializer runs, so
+// operator new may be called from other static constructors
+std::array<AllocCounters, AllocTracker::kSubsystems> alloc_counters;
+thread_local AllocSubsystem tls_alloc_subsystem = AllocSubsystem::kUntagged;
+
+auto Counters() noexcept -> AllocCounters& {
+  return alloc_counters[static_cast<std::size_t>(tls_alloc_subsystem)];
+}
+
+auto Load(AllocCounters const& counters) noexcept -> AllocStats {
+  auto dst = AllocStats();
+  dst.allocations = counters.allocations.load(std::memory_order_relaxed);
+  dst.deallocations = counters.deallocations.load(std::memory_order_relaxed);
+  dst.bytes = counters.bytes.load(std::memory_order_relaxed);
+
+  return dst;
+}
+
+auto Difference(AllocStats const& lhs, AllocStats const& rhs) noexcept
+    -> AllocStats {
+  auto dst = AllocStats();
+  dst.allocations = lhs.allocations - rhs.allocations;
+  dst.deallocations = lhs.deallocations - rhs.deallocations;
+  dst.bytes = lhs.bytes - rhs.bytes;
+
+  return dst;
+}
+
+auto Accumulate(AllocStats& dst, AllocStats const& src) noexcept -> void {
+  dst.allocations += src.allocations;
+  dst.deallocations += src.deallocations;
+  dst.bytes += src.bytes;
+}
+
+#ifdef GOYA_ALLOC_TRACKER_ENABLED
+
+auto Allocate(std::size_t size, std::size_t const alignment) noexcept
+    -> void* {
+  size = size == 0U ? 1U : size;
+
+  auto ptr = static_cast<void*>(nullptr);
+  if (alignment <= __STDCPP_DEFAULT_NEW_ALIGNMENT__) {
+    ptr = std::malloc(size);
+  } else {
+    // aligned_alloc wants a multiple of the alignment
+    ptr = std::aligned_alloc(alignment,
+                             (size + alignment - 1U) & ~(alignment - 1U));
+  }
+
+  if (ptr) {
+    auto& counters = Counters();
+    counters.allocations.fetch_add(1U, std::memory_order_relaxed);
+    counters.bytes.fetch_add(size, std::memory_order_relaxed);
+  }
+
+  return ptr;
+}
+
+auto AllocateOrThrow(std::size_t const size, std::size_t const alignment)
+    -> void* {
+  for (;;) {
+    if (auto ptr = Allocate(size, alignment); ptr) {
+      return ptr;
+    }
+
+    auto const handler = std::get_new_handler();
+    if (!handler) {
+      throw std::bad_alloc();
+    }
+
+    handler();
+  }
+}
+
+auto AllocateOrNull(std::size_t const size,
+                    std::size_t const alignment) noexcept -> void* {
+  try {
+    return AllocateOrThrow(size, alignment);
+  } catch (...) {
+    return nullptr;
+  }
+}
+
+auto Deallocate(void* ptr) noexcept -> void {
+  if (!ptr) {
+    return;
+  }
+
+  Counters().deallocations.fetch_add(1U, std::memory_order_relaxed);
+  std::free(ptr);
+}
+
+#endif
+
+}  // namespace detail
+
+auto AllocSubsystemName(AllocSubsystem const subsystem) noexcept
+    -> char const* {
+  switch (subsystem) {
+    case AllocSubsystem::kUntagged:
+      return "untagged";
+    case AllocSubsystem::kWindow:
+      return "window";
+    case AllocSubsystem::kMesh:
+      return "mesh";
+    case AllocSubsystem::kSpline:
+      return "spline";
+    case AllocSubsystem::kParticles:
+      return "particles";
+    case AllocSubsystem::kScene:
+      return "scene";
+    case AllocSubsystem::kRender:
+      return "render";
+    case AllocSubsystem::kJobs:
+      return "jobs";
+    case AllocSubsystem::kCount:
+      break;
+  }
+
+  return "unknown";
+}
+
+auto AllocTracker::Enabled() noexcept -> bool {
+#ifdef GOYA_ALLOC_TRACKER_ENABLED
+  return true;
+#else
+  return false;
+#endif
+}
+
+auto AllocTracker::Totals(AllocSubsystem const subsystem) const noexcept
+    -> AllocStats {
+  return detail::Load(
+      detail::alloc_counters[static_cast<std::size_t>(subsystem)]);
+}
+
+auto AllocTracker::Totals() const noexcept -> AllocStats {
+  auto dst = AllocStats();
+  for (auto const& counters : detail::alloc_counters) {
+    detail::Accumulate(dst, detail::Load(counters));
+  }
+
+  return dst;
+}
+
+auto AllocTracker::BeginFrame() noexcept -> void {
+  for (auto i = std::size_t(0U); i < kSubsystems; ++i) {
+    auto const now = detail::Load(detail::alloc_counters[i]);
+    frame_[i] = detail::Difference(now, frame_start_[i]);
+    frame_start_[i] = now;
+  }
+}
+
+auto AllocTracker::FrameStats(AllocSubsystem const subsystem) const noexcept
+    -> AllocStats {
+  return frame_[static_cast<std::size_t>(subsystem)];
+}
+
+auto AllocTracker::FrameStats() const noexcept -> AllocStats {
+  auto dst = AllocStats();
+  for (auto const& stats : frame_) {
+    detail::Accumulate(dst, stats);
+  }
+
+  return dst;
+}
+
+auto GlobalAllocTracker() -> AllocTracker& {
+  static auto tracker = AllocTracker();
+  return tracker;
+}
+
+AllocScope::AllocScope(AllocSubsystem const subsystem) noexcept
+    : prev_(detail::tls_alloc_subsystem) {
+  detail::tls_alloc_subsystem = subsystem;
+}
+
+AllocScope::~AllocScope() { detail::tls_alloc_subsystem = prev_; }
+
+}  // namespace goya
+
+#ifdef GOYA_ALLOC_TRACKER_ENABLED
+
+// replaceable global allocation functions, every other form forwards here
+
+auto operator new(std::size_t size) -> void* {
+  return goya::detail::AllocateOrThrow(size,
+                                       __STDCPP_DEFAULT_NEW_ALIGNMENT__);
+}
+
+auto operator new[](std::size_t size) -> void* {
+  return goya::detail::AllocateOrThrow(size,
+                                       __STDCPP_DEFAULT_NEW_ALIGNMENT__);
+}
+
+auto operator new(std::size_t size, std::nothrow_t const&) noexcept
+    -> void* {
+  return goya::detail::AllocateOrNull(size, __STDCPP_DEFAULT_NEW_ALIGNMENT__);
+}
+
+auto operator new[](std::size_t size, std::nothrow_t const&) noexcept
+    -> void* {
+  return goya::detail::AllocateOrNull(size, __STDCPP_DEFAULT_NEW_ALIGNMENT__);
+}
+
+auto operator new(std::size_t size, std::align_val_t alignment) -> void* {
+  return goya::detail::AllocateOrThrow(size,
+                                       static_cast<std::size_t>(alignment));
+}
+
+auto operator new[](std::size_t size, std::align_val_t alignment) -> void* {
+  return goya::detail::AllocateOrThrow(size,
+                                       static_cast<std::size_t>(alignment));
+}
+
+auto operator new(std::size_t size, std::align_val_t alignment,
+                  std::nothrow_t const&) noexcept -> void* {
+  return goya::detail::AllocateOrNull(size,
+                                      static_cast<std::size_t>(alignment));
+}
+
+auto operator new[](std::size_t size, std::align_val_t alignment,
+                    std::nothrow_t const&) noexcept -> void* {
+  return goya::detail::AllocateOrNull(size,
+                                      static_cast<std::size_t>(alignment));
+}
+
+auto operator delete(void* ptr) noexcept -> void {
+  goya::detail::Deallocate(ptr);
+}
+
+auto operator delete[](void* ptr) noexcept -> void {
+  goya::detail::Deallocate(ptr);
+}
+
+auto operator delete(void* ptr, std::size_t) noexcept -> void {
+  goya::detail::Deallocate(ptr);
+}
+
+auto operator delete[](void* ptr, std::size_t) noexcept -> void {
+  goya::detail::Deallocate(ptr);
+}
+
+auto operator delete(void* ptr, std::nothrow_t const&) noexcept -> void {
+  goya::detail::Deallocate(ptr);
+}
+
+auto operator delete[](void* ptr, std::nothrow_t const&) noexcept -> void {
+  goya::detail::Deallocate(ptr);
+}
+
+auto operator delete(void* ptr, std::align_val_t) noexcept -> void {
+  goya::detail::Deallocate(ptr);
+}
+
+auto operator delete[](void* ptr, std::align_val_t) noexcept -> void {
+  goya::detail::Deallocate(ptr);
+}
+
+auto operator delete(void* ptr, std::size_t, std::align_val_t) noexcept
+    -> void {
+  goya::detail::Deallocate(ptr);
+}
+
+auto operator delete[](void* ptr, std::size_t, std::align_val_t) noexcept
+    -> void {
+  goya::detail::Deallocate(ptr);
+}
+
+auto operator delete(void* ptr, std::align_val_t,
+                     std::nothrow_t const&) noexcept -> void {
+  goya::detail::Deallocate(ptr);
+}
+
+auto operator delete[](void* ptr, std::align_val_t,
+                       std::nothrow_t const&) noexcept -> void {
+  goya::detail::Deallocate(ptr);
+}
+
+#endif
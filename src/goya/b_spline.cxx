@@ -1,99 +1,638 @@
 #include "goya/b_spline.hpp"
 
+#include <algorithm>
+#include <array>
 #include <cmath>
-#include <fstream>
+#include <stdexcept>
+#include <utility>
 
 #include "GL/glew.h"
 #include "glm/gtc/matrix_transform.hpp"
 #include "glm/gtc/type_ptr.hpp"
+#include "goya/alloc_tracker.hpp"
+#include "goya/profiler.hpp"
+#include "goya/trajectory_source.hpp"
 
 namespace goya {
 
-auto LoadControloPoints(std::string const& path) -> std::vector<Vertex3d> {
-  return LoadControloPoints(path.c_str());
+namespace detail {
+
+// normals only show the shape, their pieces may be this much coarser
+static auto constexpr kNormalToleranceScale = 16.f;
+
+// 2^6 pieces per segment at most, e.g. for a cusp, and 2^4 for the normals.
+// they bound the slot sizes of the line models
+static auto constexpr kMaxTessellationDepth = 6;
+static auto constexpr kMaxNormalDepth = 4;
+
+// piece starts plus the segment end, and two vertices per normal
+static auto constexpr kSplineSlotSize =
+    (std::size_t(1U) << kMaxTessellationDepth) + 1U;
+static auto constexpr kNormalSlotSize = std::size_t(2U) << kMaxNormalDepth;
+
+// keeps the screen space bound finite for pieces at the eye
+static auto constexpr kMinEyeDistance = 1e-2f;
+
+// rotation minimizing frames per segment
+static auto constexpr kFrameSamples = 32U;
+static auto constexpr kFrameRow = std::size_t(kFrameSamples) + 1U;
+
+// segments per block of twist products
+static auto constexpr kTwistBlock = std::size_t(256U);
+
+// five point Gauss-Legendre rule on [-1, 1], exact for polynomials up to
+// degree nine
+static auto constexpr kGaussNodes = std::array<float, 5U>{
+    -0.9061798459f, -0.5384693101f, 0.f, 0.5384693101f, 0.9061798459f};
+static auto constexpr kGaussWeights = std::array<float, 5U>{
+    0.2369268851f, 0.4786286705f, 0.5688888889f, 0.4786286705f,
+    0.2369268851f};
+
+// halves of an interval are refined until they agree with the whole
+static auto constexpr kArcTolerance = 1e-5f;
+static auto constexpr kArcMaxDepth = 8;
+static auto constexpr kNewtonSteps = 1;
+
+auto Coord(SplineSegment const& seg, float const t) -> Vertex3d {
+  return ((seg.a * t + seg.b) * t + seg.c) * t + seg.d;
 }
 
-auto LoadControloPoints(char const* path) -> std::vector<Vertex3d> {
-  auto dst = std::vector<Vertex3d>();
-  auto ifstrm = std::ifstream(path);
-  auto v = Vertex3d();
-  while (ifstrm >> v.x >> v.y >> v.z) {
-    dst.push_back(v);
+auto DCoord(SplineSegment const& seg, float const t) -> Vertex3d {
+  return (3.f * seg.a * t + 2.f * seg.b) * t + seg.c;
+}
+
+auto DdCoord(SplineSegment const& seg, float const t) -> Vertex3d {
+  return 6.f * seg.a * t + 2.f * seg.b;
+}
+
+// rotations about one axis as cos and sin of their half angle
+auto ComplexMul(glm::vec2 const lhs, glm::vec2 const rhs) -> glm::vec2 {
+  return glm::vec2(lhs.x * rhs.x - lhs.y * rhs.y,
+                   lhs.x * rhs.y + lhs.y * rhs.x);
+}
+
+// a changed segment count moves the values behind the edit at first, so they
+// stay with their segments
+template <class T>
+auto ShiftTail(std::vector<T>& values, std::size_t first, std::size_t count)
+    -> void {
+  auto const at = values.begin() + static_cast<std::ptrdiff_t>(first);
+  if (count > values.size()) {
+    values.insert(at, count - values.size(), T());
+  } else if (count < values.size()) {
+    values.erase(at, at + static_cast<std::ptrdiff_t>(values.size() - count));
   }
+}
+
+auto Speed(SplineSegment const& seg, float const t) -> float {
+  return glm::length(DCoord(seg, t));
+}
+
+// any normal of tangent, it only has to be the same for the same tangent
+auto StartNormal(Vertex3d const tangent) -> Vertex3d {
+  auto const helper = std::abs(tangent.y) < 0.9f ? glm::vec3(0.f, 1.f, 0.f)
+                                                 : glm::vec3(1.f, 0.f, 0.f);
+  return glm::normalize(glm::cross(tangent, glm::cross(helper, tangent)));
+}
+
+auto GaussLegendre(SplineSegment const& seg, float const t0, float const t1)
+    -> float {
+  auto const mid = 0.5f * (t0 + t1);
+  auto const half = 0.5f * (t1 - t0);
+
+  auto sum = 0.f;
+  for (auto i = std::size_t(0U); i < kGaussNodes.size(); ++i) {
+    sum += kGaussWeights[i] * Speed(seg, mid + half * kGaussNodes[i]);
+  }
+
+  return half * sum;
+}
+
+auto AdaptiveLength(SplineSegment const& seg, float const t0, float const t1,
+                    float const whole, int const depth) -> float {
+  auto const mid = 0.5f * (t0 + t1);
+  auto const left = GaussLegendre(seg, t0, mid);
+  auto const right = GaussLegendre(seg, mid, t1);
+
+  if (depth == 0 ||
+      std::abs(left + right - whole) <= kArcTolerance * (left + right)) {
+    return left + right;
+  }
+
+  return AdaptiveLength(seg, t0, mid, left, depth - 1) +
+         AdaptiveLength(seg, mid, t1, right, depth - 1);
+}
+
+// distance of p from the line through a and b
+auto LineDistance(Vertex3d const p, Vertex3d const a, Vertex3d const b)
+    -> float {
+  auto const ab = b - a;
+  auto const len2 = glm::dot(ab, ab);
+  if (len2 <= 0.f) {
+    return glm::length(p - a);
+  }
+
+  return glm::length(glm::cross(p - a, ab)) / std::sqrt(len2);
+}
+
+}  // namespace detail
+
+auto MakeScreenTolerance(Camera const& camera, float viewport_height,
+                         float pixels) -> ScreenTolerance {
+  auto dst = ScreenTolerance();
+  dst.eye = camera.Position();
+  dst.pixels_per_unit = 0.5f * viewport_height * camera.Projection()[1][1];
+  dst.pixels = pixels;
 
   return dst;
 }
 
+auto SlotOrder::Reset(std::size_t count) -> void {
+  order_.resize(count);
+  for (auto pos = std::size_t(0U); pos < count; ++pos) {
+    order_[pos] = static_cast<std::uint32_t>(pos);
+  }
+
+  free_.clear();
+  slot_count_ = static_cast<std::uint32_t>(count);
+}
+
+auto SlotOrder::Insert(std::size_t pos, std::size_t count,
+                       std::vector<std::uint32_t>& slots) -> void {
+  auto const first = slots.size();
+  for (auto i = std::size_t(0U); i < count; ++i) {
+    if (free_.empty()) {
+      slots.push_back(slot_count_++);
+    } else {
+      slots.push_back(free_.back());
+      free_.pop_back();
+    }
+  }
+
+  order_.insert(order_.begin() + static_cast<std::ptrdiff_t>(pos),
+                slots.begin() + static_cast<std::ptrdiff_t>(first),
+                slots.end());
+}
+
+auto SlotOrder::Erase(std::size_t pos, std::size_t count,
+                      std::vector<std::uint32_t>& slots) -> void {
+  auto const at = order_.begin() + static_cast<std::ptrdiff_t>(pos);
+  auto const end = at + static_cast<std::ptrdiff_t>(count);
+  slots.insert(slots.end(), at, end);
+  free_.insert(free_.end(), at, end);
+  order_.erase(at, end);
+}
+
+auto SlotOrder::Size() const noexcept -> std::size_t { return order_.size(); }
+
+auto SlotOrder::SlotCount() const noexcept -> std::size_t {
+  return slot_count_;
+}
+
+auto SlotOrder::Slots() const noexcept -> std::vector<std::uint32_t> const& {
+  return order_;
+}
+
+auto ArcLengthTable::Update(std::vector<SplineSegment> const& segments,
+                            SlotOrder const& order, std::uint32_t first,
+                            std::uint32_t last) -> void {
+  auto constexpr row = kSamples + 1U;
+
+  auto const n = order.Size();
+  auto const resized = lengths_.size() != n;
+  samples_.resize(order.SlotCount() * row);
+  detail::ShiftTail(lengths_, first, n);
+  local_.resize(n);
+  blocks_.resize((n + kBlock - 1U) / kBlock + 1U);
+
+  auto constexpr dt = 1.f / kSamples;
+  for (auto idx = first; idx < last; ++idx) {
+    auto const& seg = segments[order[idx]];
+    auto const samples = samples_.begin() + order[idx] * row;
+    samples[0] = 0.f;
+    for (auto k = 1U; k < row; ++k) {
+      auto const t0 = static_cast<float>(k - 1U) * dt;
+      auto const whole = detail::GaussLegendre(seg, t0, t0 + dt);
+      samples[k] = samples[k - 1U] +
+                   detail::AdaptiveLength(seg, t0, t0 + dt, whole,
+                                          detail::kArcMaxDepth);
+    }
+    lengths_[idx] = samples[kSamples];
+  }
+
+  // offsets in the blocks of the edit move, or in every block behind it once
+  // the segments shifted
+  auto const first_block = first / kBlock;
+  auto const end =
+      resized ? n : std::min(n, (last + kBlock - 1U) / kBlock * kBlock);
+  for (auto begin = first_block * kBlock; begin < end; begin += kBlock) {
+    auto offset = 0.f;
+    for (auto idx = begin; idx < std::min(begin + kBlock, n); ++idx) {
+      local_[idx] = offset;
+      offset += lengths_[idx];
+    }
+  }
+
+  for (auto block = first_block; block + 1U < blocks_.size(); ++block) {
+    auto const back = std::min((block + 1U) * kBlock, n) - 1U;
+    blocks_[block + 1U] = blocks_[block] + local_[back] + lengths_[back];
+  }
+}
+
+auto ArcLengthTable::Length() const noexcept -> float {
+  return blocks_.back();
+}
+
+auto ArcLengthTable::LengthAt(std::vector<SplineSegment> const& segments,
+                              SlotOrder const& order,
+                              SplineParam const param) const -> float {
+  auto const slot = order[param.idx];
+  auto const t = std::clamp(param.t, 0.f, 1.f);
+  auto const k = std::min(static_cast<std::uint32_t>(t * kSamples),
+                          kSamples - 1U);
+  auto const t0 = static_cast<float>(k) / kSamples;
+
+  // a single rule is plenty inside one sample interval
+  return blocks_[param.idx / kBlock] + local_[param.idx] +
+         samples_[slot * (kSamples + 1U) + k] +
+         detail::GaussLegendre(segments[slot], t0, t);
+}
+
+auto ArcLengthTable::Locate(std::vector<SplineSegment> const& segments,
+                            SlotOrder const& order,
+                            float const distance) const -> SplineParam {
+  if (order.Size() == 0U) {
+    return SplineParam();
+  }
+
+  auto const s = std::clamp(distance, 0.f, Length());
+  auto const block_it =
+      std::upper_bound(blocks_.begin() + 1, blocks_.end() - 1, s);
+  auto const block = static_cast<std::size_t>(block_it - blocks_.begin() - 1);
+
+  auto const block_s = s - blocks_[block];
+  auto const block_first = block * kBlock;
+  auto const block_last = std::min(block_first + kBlock, order.Size());
+  auto const seg_it = std::upper_bound(
+      local_.begin() + static_cast<std::ptrdiff_t>(block_first) + 1,
+      local_.begin() + static_cast<std::ptrdiff_t>(block_last), block_s);
+  auto const idx = static_cast<std::uint32_t>(seg_it - local_.begin() - 1);
+  auto const& seg = segments[order[idx]];
+
+  auto const local = block_s - local_[idx];
+  auto const row = samples_.begin() + order[idx] * (kSamples + 1U);
+  auto const k = static_cast<std::uint32_t>(
+      std::upper_bound(row + 1, row + kSamples, local) - row - 1);
+
+  auto const dt = 1.f / kSamples;
+  auto const t0 = static_cast<float>(k) * dt;
+  auto const l0 = row[k];
+  auto const l1 = row[k + 1U];
+
+  // linear guess inside the sample interval, Newton polishes it since the
+  // derivative of the arc length is the speed
+  auto t = l1 > l0 ? t0 + dt * (local - l0) / (l1 - l0) : t0;
+  for (auto i = 0; i < detail::kNewtonSteps; ++i) {
+    auto const speed = detail::Speed(seg, t);
+    if (speed <= 0.f) {
+      break;
+    }
+
+    auto const error = l0 + detail::GaussLegendre(seg, t0, t) - local;
+    t = std::clamp(t - error / speed, t0, t0 + dt);
+  }
+
+  return SplineParam{idx, t};
+}
+
+auto LoadControloPoints(std::string const& path) -> std::vector<Vertex3d> {
+  return LoadControloPoints(path.c_str());
+}
+
+auto LoadControloPoints(char const* path) -> std::vector<Vertex3d> {
+  auto const source = TrajectorySource(path);
+  return source.Read(0U, source.Size());
+}
+
 CubeBSpline::CubeBSpline(std::vector<Vertex3d> control_points,
                          std::shared_ptr<Shader> shader)
-    : control_points_(std::move(control_points)),
-      control_model_(shader, std::make_unique<MeshLines>(control_points_)),
-      spline_model_(shader, std::make_unique<MeshLines>(SplinePoints())),
-      normal_model_(shader, std::make_unique<MeshLines>(NormalPoints())) {
-  control_model_.SetColor(glm::vec3{1.0f, 0.f, 0.f});
-  spline_model_.SetColor(glm::vec3(0.f, 0.5f, 0.5f));
-  normal_model_.SetColor(glm::vec3(0.1f, 0.1f, 0.1f));
+    : control_points_(std::move(control_points)), shader_(std::move(shader)) {
+  order_.Reset(SegmentCount());
+  ResizeSlots();
+  UpdateSegments(0U, SegmentCount());
 }
 
 auto CubeBSpline::TimeUpdate(TimeType delta) -> void {
+  if (world_speed_ > 0.f) {
+    auto const length = Length();
+    if (length <= 0.f) {
+      return;
+    }
+
+    distance_ = std::fmod(distance_ + delta * world_speed_, length);
+    auto const param = ArcParameter(distance_);
+    curr_idx_ = param.idx;
+    seg_t_ = param.t;
+    return;
+  }
+
   seg_t_ += delta * animation_speed_;
   if (seg_t_ >= 1.f) {
     seg_t_ -= 1.f;
-    curr_idx_ = (curr_idx_ + 1) % (control_points_.size() - 3);
+    curr_idx_ = (curr_idx_ + 1) % SegmentCount();
   }
 }
 
+// the frenet frame flips where the curvature passes zero, the precomputed
+// rotation minimizing frames do not
 auto CubeBSpline::ModelMatrix() -> glm::mat4 {
-  auto model = glm::mat4(1.f);
+  auto model = glm::mat4_cast(Orientation());
+  model[3] = glm::vec4(SplineCoord(), 1.f);
+
+  return model;
+}
 
-  model = glm::translate(model, SplineCoord());
-  // auto const s = glm::vec3{0.f, 0.f, 1.f};
-  // auto const e = glm::normalize(SplineDCoord());
+auto CubeBSpline::SplineCoord() const -> Vertex3d {
+  return SplineCoord(seg_t_, curr_idx_);
+}
 
-  // auto const axis = glm::normalize(glm::cross(s, e));
-  // auto const deg =
-  //     std::acos(glm::dot(s, e) / (glm::length(s) * glm::length(e)));
+auto CubeBSpline::SplineCoord(float t, std::uint32_t idx) const -> Vertex3d {
+  return detail::Coord(Segment(idx), t);
+}
 
-  // return glm::rotate(model, deg, axis);
+auto CubeBSpline::SplineDCoord() const -> Vertex3d {
+  return SplineDCoord(seg_t_, curr_idx_);
+}
 
-  auto const v = glm::normalize(SplineDCoord());    // z
-  auto const u = glm::normalize(SplineDdCoord());   // y
-  auto const w = glm::normalize(glm::cross(u, v));  // x
+auto CubeBSpline::SplineDCoord(float t, std::uint32_t idx) const -> Vertex3d {
+  return detail::DCoord(Segment(idx), t);
+}
 
-  /* clang-format off */
-  auto const dcm = glm::mat4{
-    w.x, w.y, w.z, 0,
-    u.x, u.y, u.z, 0,
-    v.x, v.y, v.z, 0,
-    0,   0,   0,   1
-  };
-  /* clnag-format on */
+auto CubeBSpline::SplineDdCoord() const -> Vertex3d {
+  return SplineDdCoord(seg_t_, curr_idx_);
+}
 
-  return model * dcm;
+auto CubeBSpline::SplineDdCoord(float t, std::uint32_t idx) const -> Vertex3d {
+  return detail::DdCoord(Segment(idx), t);
 }
 
-auto CubeBSpline::SplineCoord() -> Vertex3d {
-  return SplineCoord(seg_t_, curr_idx_);
+auto CubeBSpline::Orientation() const -> glm::quat {
+  return Orientation(seg_t_, curr_idx_);
 }
 
-auto CubeBSpline::SplineCoord(float t, std::uint32_t idx) -> Vertex3d {
-  return glm::vec4{t * t * t, t * t, t, 1} * N_matrix * RiMatrix(idx);
+// the frames of a slot start from a normal of their own, the twist turns
+// them about the tangent to where the previous segment left off
+auto CubeBSpline::Orientation(float t, std::uint32_t idx) const -> glm::quat {
+  auto const s = std::clamp(t, 0.f, 1.f) * detail::kFrameSamples;
+  auto const i = std::min(static_cast<std::size_t>(s),
+                          std::size_t(detail::kFrameSamples) - 1U);
+  auto const f = s - static_cast<float>(i);
+
+  auto const frames = frames_.data() + order_[idx] * detail::kFrameRow;
+  auto const twist = Twist(idx);
+
+  return glm::normalize((frames[i] * (1.f - f) + frames[i + 1U] * f) *
+                        glm::quat(twist.x, 0.f, 0.f, twist.y));
 }
 
-auto CubeBSpline::SplineDCoord() -> Vertex3d {
-  return SplineDCoord(seg_t_, curr_idx_);
+// one loop per output without branches inside, so they vectorize
+auto CubeBSpline::EvaluateBatch(std::uint32_t idx, float const* ts,
+                                std::size_t count, Vertex3d* coords,
+                                Vertex3d* d_coords, Vertex3d* dd_coords) const
+    -> void {
+  auto const& seg = Segment(idx);
+
+  if (coords) {
+    for (auto i = std::size_t(0U); i < count; ++i) {
+      auto const t = ts[i];
+      coords[i] = ((seg.a * t + seg.b) * t + seg.c) * t + seg.d;
+    }
+  }
+
+  if (d_coords) {
+    auto const a3 = 3.f * seg.a;
+    auto const b2 = 2.f * seg.b;
+    for (auto i = std::size_t(0U); i < count; ++i) {
+      auto const t = ts[i];
+      d_coords[i] = (a3 * t + b2) * t + seg.c;
+    }
+  }
+
+  if (dd_coords) {
+    auto const a6 = 6.f * seg.a;
+    auto const b2 = 2.f * seg.b;
+    for (auto i = std::size_t(0U); i < count; ++i) {
+      dd_coords[i] = a6 * ts[i] + b2;
+    }
+  }
 }
 
-auto CubeBSpline::SplineDCoord(float t, std::uint32_t idx) -> Vertex3d {
-  return glm::vec4{3 * t * t, 2 * t, 1, 0} * N_matrix * RiMatrix(idx);
+// three additions per sample, the error over one segment stays far below
+// what a line model can show
+auto CubeBSpline::SampleSegment(std::uint32_t idx, std::size_t count,
+                                Vertex3d* coords) const -> void {
+  if (count == 0U) {
+    return;
+  }
+
+  auto const& seg = Segment(idx);
+  auto const h = 1.f / static_cast<float>(count);
+  auto const h2 = h * h;
+  auto const h3 = h2 * h;
+
+  auto coord = seg.d;
+  auto delta = seg.a * h3 + seg.b * h2 + seg.c * h;
+  auto delta2 = 6.f * seg.a * h3 + 2.f * seg.b * h2;
+  auto const delta3 = 6.f * seg.a * h3;
+
+  for (auto i = std::size_t(0U); i < count; ++i) {
+    coords[i] = coord;
+    coord += delta;
+    delta += delta2;
+    delta2 += delta3;
+  }
 }
 
-auto CubeBSpline::SplineDdCoord() -> Vertex3d {
-  return SplineDdCoord(seg_t_, curr_idx_);
+auto CubeBSpline::SegmentCount() const noexcept -> std::uint32_t {
+  return control_points_.size() < 4U
+             ? 0U
+             : static_cast<std::uint32_t>(control_points_.size() - 3U);
+}
+
+auto CubeBSpline::Segment(std::uint32_t idx) const -> SplineSegment const& {
+  return segments_[order_[idx]];
+}
+
+auto CubeBSpline::ControlPoints() const noexcept
+    -> std::vector<Vertex3d> const& {
+  return control_points_;
+}
+
+auto CubeBSpline::SetControlPoints(std::vector<Vertex3d> control_points)
+    -> void {
+  control_points_ = std::move(control_points);
+  start_normal_ = Vertex3d(0.f);
+  order_.Reset(SegmentCount());
+  ResizeSlots();
+  UpdateSegments(0U, SegmentCount());
+
+  curr_idx_ = SegmentCount() == 0U ? 0U : curr_idx_ % SegmentCount();
+  control_model_.reset();
+}
+
+auto CubeBSpline::SetControlPoint(std::size_t idx, Vertex3d point) -> void {
+  control_points_.at(idx) = point;
+
+  // point idx shapes the segments idx - 3 to idx
+  auto const first = static_cast<std::uint32_t>(idx < 3U ? 0U : idx - 3U);
+  auto const last =
+      std::min(static_cast<std::uint32_t>(idx + 1U), SegmentCount());
+  UpdateSegments(first, last);
+  MarkEdited(first, last, idx, idx + 1U, false);
+}
+
+auto CubeBSpline::InsertControlPoint(std::size_t idx, Vertex3d point)
+    -> void {
+  InsertControlPoints(idx, std::vector<Vertex3d>{point});
+}
+
+auto CubeBSpline::RemoveControlPoint(std::size_t idx) -> void {
+  RemoveControlPoints(idx, 1U);
+}
+
+// the segments past the new points keep their polynomials and only move
+// back, so slots are added in front of them
+auto CubeBSpline::InsertControlPoints(std::size_t idx,
+                                      std::vector<Vertex3d> const& points)
+    -> void {
+  if (idx > control_points_.size()) {
+    throw std::out_of_range(
+        "[goya::CubeBSpline] insert position past the last control point.");
+  }
+
+  if (points.empty()) {
+    return;
+  }
+
+  auto const alloc_scope = AllocScope(AllocSubsystem::kSpline);
+
+  auto const n_segments = SegmentCount();
+  control_points_.insert(
+      control_points_.begin() + static_cast<std::ptrdiff_t>(idx),
+      points.begin(), points.end());
+
+  auto const first = static_cast<std::uint32_t>(idx < 3U ? 0U : idx - 3U);
+  auto const inserted = SegmentCount() - n_segments;
+  if (inserted != 0U) {
+    edit_slots_.clear();
+    order_.Insert(first, inserted, edit_slots_);
+
+    // a reused slot is written again instead of emptied
+    if (!freed_slots_.empty()) {
+      std::sort(edit_slots_.begin(), edit_slots_.end());
+      freed_slots_.erase(
+          std::remove_if(freed_slots_.begin(), freed_slots_.end(),
+                         [&](std::uint32_t slot) -> bool {
+                           return std::binary_search(edit_slots_.begin(),
+                                                     edit_slots_.end(), slot);
+                         }),
+          freed_slots_.end());
+    }
+    ResizeSlots();
+  }
+
+  auto const last = std::min(
+      static_cast<std::uint32_t>(idx + points.size()), SegmentCount());
+  UpdateSegments(first, last);
+  MarkEdited(first, last, idx, control_points_.size(), true);
+  ShiftCurrent(first, 0U, inserted);
+}
+
+auto CubeBSpline::RemoveControlPoints(std::size_t idx, std::size_t count)
+    -> void {
+  if (idx > control_points_.size() || count > control_points_.size() - idx) {
+    throw std::out_of_range(
+        "[goya::CubeBSpline] no control points at that range.");
+  }
+
+  if (count == 0U) {
+    return;
+  }
+
+  auto const alloc_scope = AllocScope(AllocSubsystem::kSpline);
+
+  // the frames behind the removed points keep turning from the normal the
+  // new first segment started with
+  auto const n_segments = SegmentCount();
+  if (idx == 0U && count < n_segments) {
+    auto const frame = glm::mat3_cast(
+        Orientation(0.f, static_cast<std::uint32_t>(count)));
+    start_normal_ = frame[1];
+  }
+
+  control_points_.erase(
+      control_points_.begin() + static_cast<std::ptrdiff_t>(idx),
+      control_points_.begin() + static_cast<std::ptrdiff_t>(idx + count));
+
+  auto const first = static_cast<std::uint32_t>(idx < 3U ? 0U : idx - 3U);
+  auto const removed = n_segments - SegmentCount();
+  if (removed != 0U) {
+    auto& slots = spline_model_ && normal_model_ ? freed_slots_ : edit_slots_;
+    edit_slots_.clear();
+    order_.Erase(first, removed, slots);
+  }
+
+  // segments idx - 3 to idx - 1 held the removed points' neighbours
+  auto const last = std::min(static_cast<std::uint32_t>(idx), SegmentCount());
+  UpdateSegments(first, std::max(first, last));
+  MarkEdited(first, std::max(first, last), idx, control_points_.size(), true);
+  ShiftCurrent(first, removed, 0U);
 }
 
-auto CubeBSpline::SplineDdCoord(float t, std::uint32_t idx) -> Vertex3d {
-  return glm::vec4{6 * t, 2, 0, 0} * N_matrix * RiMatrix(idx);
+auto CubeBSpline::CurrentParam() const noexcept -> SplineParam {
+  return SplineParam{curr_idx_, seg_t_};
+}
+
+auto CubeBSpline::Length() const noexcept -> float {
+  return arc_table_.Length();
+}
+
+auto CubeBSpline::ArcLength(float t, std::uint32_t idx) const -> float {
+  return arc_table_.LengthAt(segments_, order_, SplineParam{idx, t});
+}
+
+auto CubeBSpline::ArcParameter(float distance) const -> SplineParam {
+  return arc_table_.Locate(segments_, order_, distance);
+}
+
+auto CubeBSpline::SetSpeed(float units_per_second) -> void {
+  world_speed_ = units_per_second;
+  if (world_speed_ > 0.f && SegmentCount() != 0U) {
+    // continue from the current position instead of jumping to the start
+    distance_ = ArcLength(seg_t_, curr_idx_);
+  }
+}
+
+auto CubeBSpline::SetTolerance(float chord_error) -> void {
+  if (chord_error <= 0.f) {
+    throw std::invalid_argument(
+        "[goya::CubeBSpline] tolerance has to be positive.");
+  }
+
+  tolerance_ = chord_error;
+  spline_model_.reset();
+  normal_model_.reset();
+}
+
+auto CubeBSpline::SetScreenTolerance(ScreenTolerance const& tolerance)
+    -> void {
+  screen_ = tolerance;
+  spline_model_.reset();
+  normal_model_.reset();
+}
+
+auto CubeBSpline::VertexCount() const noexcept -> std::size_t {
+  return vertex_count_;
 }
 
 auto CubeBSpline::CenterCoord() -> Vertex3d {
@@ -109,12 +648,31 @@ auto CubeBSpline::CenterCoord() -> Vertex3d {
 }
 
 auto CubeBSpline::Draw() -> void {
-  control_model_.Draw();
-  spline_model_.Draw();
-  normal_model_.Draw();
+  GOYA_PROFILE_ZONE("CubeBSpline::Draw");
+  GOYA_PROFILE_GPU_ZONE("CubeBSpline::Draw");
+
+  if (!CreateModels()) {
+    return;
+  }
+
+  GOYA_PROFILE_COUNTER("CubeBSpline::vertices", vertex_count_);
+
+  control_model_->Draw();
+  spline_model_->Draw();
+  normal_model_->Draw();
+}
+
+auto CubeBSpline::Submit(RenderQueue& queue) -> void {
+  if (!CreateModels()) {
+    return;
+  }
+
+  control_model_->Submit(queue);
+  spline_model_->Submit(queue);
+  normal_model_->Submit(queue);
 }
 
-auto CubeBSpline::RiMatrix(std::uint32_t idx) -> glm::mat3x4 {
+auto CubeBSpline::RiMatrix(std::uint32_t idx) const -> glm::mat3x4 {
   auto R = glm::mat3x4{};
   for (auto axis = 0; axis < R.length(); ++axis) {
     for (auto i = 0U; i < 4U; ++i) {
@@ -125,30 +683,412 @@ auto CubeBSpline::RiMatrix(std::uint32_t idx) -> glm::mat3x4 {
   return R;
 }
 
-auto CubeBSpline::SplinePoints() -> std::vector<Vertex3d> {
-  auto dst = std::vector<Vertex3d>();
-  for (auto idx = 0U; idx < control_points_.size() - 3; ++idx) {
-    for (auto seg_t = 0.f; seg_t < 1.f; seg_t += 0.01f) {
-      dst.push_back(SplineCoord(seg_t, idx));
+auto CubeBSpline::ResizeSlots() -> void {
+  segments_.resize(order_.SlotCount());
+  frames_.resize(order_.SlotCount() * detail::kFrameRow);
+}
+
+auto CubeBSpline::UpdateSegments(std::uint32_t first, std::uint32_t last)
+    -> void {
+  for (auto idx = first; idx < last; ++idx) {
+    // rows of the basis matrix product are the power basis coefficients
+    auto const ri = RiMatrix(idx);
+    auto& seg = segments_[order_[idx]];
+    seg.a = glm::vec4{1.f, 0.f, 0.f, 0.f} * N_matrix * ri;
+    seg.b = glm::vec4{0.f, 1.f, 0.f, 0.f} * N_matrix * ri;
+    seg.c = glm::vec4{0.f, 0.f, 1.f, 0.f} * N_matrix * ri;
+    seg.d = glm::vec4{0.f, 0.f, 0.f, 1.f} * N_matrix * ri;
+
+    UpdateFrames(order_[idx]);
+  }
+
+  arc_table_.Update(segments_, order_, first, last);
+  UpdateTwists(first, last);
+}
+
+// double reflection, Wang et al. 2008, over the samples of one segment
+auto CubeBSpline::UpdateFrames(std::uint32_t slot) -> void {
+  auto const& seg = segments_[slot];
+  auto const frames = frames_.begin() + slot * detail::kFrameRow;
+
+  auto x = detail::Coord(seg, 0.f);
+  auto tangent = glm::normalize(detail::DCoord(seg, 0.f));
+  auto normal = detail::StartNormal(tangent);
+
+  auto const store = [&](std::size_t at) -> void {
+    auto const frame =
+        glm::mat3(glm::cross(normal, tangent), normal, tangent);
+    auto q = glm::quat_cast(frame);
+    if (at != 0U && glm::dot(q, frames[at - 1U]) < 0.f) {
+      q = -q;
+    }
+    frames[at] = q;
+  };
+
+  store(0U);
+
+  auto const step = 1.f / detail::kFrameSamples;
+  for (auto i = 1U; i <= detail::kFrameSamples; ++i) {
+    auto const t = static_cast<float>(i) * step;
+    auto const next_x = detail::Coord(seg, t);
+    auto const next_tangent = glm::normalize(detail::DCoord(seg, t));
+
+    // reflect the frame over the bisector of the chord, then over the one
+    // between the reflected and the real tangent
+    auto const v1 = next_x - x;
+    auto const c1 = glm::dot(v1, v1);
+    auto normal_l = normal;
+    auto tangent_l = tangent;
+    if (c1 > 0.f) {
+      normal_l -= (2.f / c1) * glm::dot(v1, normal) * v1;
+      tangent_l -= (2.f / c1) * glm::dot(v1, tangent) * v1;
+    }
+
+    auto const v2 = next_tangent - tangent_l;
+    auto const c2 = glm::dot(v2, v2);
+    normal = c2 > 0.f ? normal_l - (2.f / c2) * glm::dot(v2, normal_l) * v2
+                      : normal_l;
+
+    // keeps the frame orthonormal against drift
+    tangent = next_tangent;
+    normal = glm::normalize(normal - glm::dot(normal, tangent) * tangent);
+    x = next_x;
+
+    store(i);
+  }
+}
+
+// the twists of the edited segments and of the one behind them change. like
+// the arc length offsets the products are redone in their blocks, or in every
+// block behind them once the segments shifted
+auto CubeBSpline::UpdateTwists(std::uint32_t first, std::uint32_t last)
+    -> void {
+  auto constexpr kBlock = detail::kTwistBlock;
+
+  auto const n = std::size_t(SegmentCount());
+  auto const resized = twist_in_.size() != n;
+  detail::ShiftTail(twist_in_, first, n);
+  twist_local_.resize(n);
+  twist_blocks_.resize((n + kBlock - 1U) / kBlock);
+
+  auto const changed_end = std::min(std::size_t(last) + 1U, n);
+  for (auto idx = std::size_t(first); idx < changed_end; ++idx) {
+    twist_in_[idx] = IncomingTwist(static_cast<std::uint32_t>(idx));
+  }
+
+  auto const first_block = first / kBlock;
+  auto const end =
+      resized ? n : std::min(n, (changed_end + kBlock - 1U) / kBlock * kBlock);
+  for (auto begin = first_block * kBlock; begin < end; begin += kBlock) {
+    auto twist = glm::vec2(1.f, 0.f);
+    for (auto idx = begin; idx < std::min(begin + kBlock, n); ++idx) {
+      twist = detail::ComplexMul(twist, twist_in_[idx]);
+      twist_local_[idx] = twist;
     }
   }
 
+  if (!twist_blocks_.empty()) {
+    twist_blocks_[0] = glm::vec2(1.f, 0.f);
+  }
+
+  for (auto block = std::max(first_block, std::size_t(1U));
+       block < twist_blocks_.size(); ++block) {
+    twist_blocks_[block] = glm::normalize(detail::ComplexMul(
+        twist_blocks_[block - 1U], twist_local_[block * kBlock - 1U]));
+  }
+}
+
+auto CubeBSpline::Twist(std::uint32_t idx) const -> glm::vec2 {
+  return detail::ComplexMul(twist_blocks_[idx / detail::kTwistBlock],
+                            twist_local_[idx]);
+}
+
+auto CubeBSpline::IncomingTwist(std::uint32_t idx) const -> glm::vec2 {
+  auto const start = glm::mat3_cast(frames_[order_[idx] * detail::kFrameRow]);
+
+  auto incoming = start[1];
+  auto const kept =
+      start_normal_ - glm::dot(start_normal_, start[2]) * start[2];
+  if (idx == 0U && glm::dot(kept, kept) >= 1e-12f) {
+    incoming = glm::normalize(kept);
+  } else if (idx == 0U) {
+    // the curve starts with the frenet normal, or any on a straight start
+    auto const dd = SplineDdCoord(0.f, 0U);
+    auto const normal = dd - glm::dot(dd, start[2]) * start[2];
+    if (glm::dot(normal, normal) >= 1e-12f) {
+      incoming = glm::normalize(normal);
+    }
+  } else {
+    auto const prev = order_[idx - 1U] * detail::kFrameRow;
+    incoming = glm::mat3_cast(frames_[prev + detail::kFrameSamples])[1];
+  }
+
+  // a turn by angle about z takes the normal to -sin x + cos y
+  auto const half = 0.5f * std::atan2(-glm::dot(incoming, start[0]),
+                                      glm::dot(incoming, start[1]));
+  return glm::vec2(std::cos(half), std::sin(half));
+}
+
+auto CubeBSpline::MarkEdited(std::uint32_t first, std::uint32_t last,
+                             std::size_t first_point, std::size_t last_point,
+                             bool reordered) -> void {
+  if (!control_model_) {
+    return;
+  }
+
+  dirty_points_first_ = std::min(dirty_points_first_, first_point);
+  dirty_points_last_ = std::max(dirty_points_last_, last_point);
+  if (!spline_model_ || !normal_model_) {
+    return;
+  }
+
+  for (auto idx = first; idx < last; ++idx) {
+    dirty_slots_.push_back(order_[idx]);
+  }
+  order_dirty_ = order_dirty_ || reordered;
+}
+
+// segments [first, first + removed) were replaced by inserted new ones
+auto CubeBSpline::ShiftCurrent(std::uint32_t first, std::uint32_t removed,
+                               std::uint32_t inserted) -> void {
+  if (curr_idx_ >= first + removed) {
+    curr_idx_ = curr_idx_ - removed + inserted;
+  } else if (curr_idx_ > first) {
+    curr_idx_ = first;
+  }
+  curr_idx_ = std::min(curr_idx_, std::max(SegmentCount(), 1U) - 1U);
+
+  if (world_speed_ > 0.f && SegmentCount() != 0U) {
+    distance_ = ArcLength(seg_t_, curr_idx_);
+  }
+}
+
+auto CubeBSpline::CreateModels() -> bool {
+  if (!shader_) {
+    return false;
+  }
+
+  auto const alloc_scope = AllocScope(AllocSubsystem::kSpline);
+
+  if (!control_model_) {
+    control_mesh_ = std::make_shared<MeshLines>(control_points_);
+    control_model_ = std::make_unique<Model>(shader_, control_mesh_);
+    control_model_->SetColor(glm::vec3{1.0f, 0.f, 0.f});
+    dirty_points_first_ = ~std::size_t(0);
+    dirty_points_last_ = 0U;
+
+    // the curve depends on the control points too
+    spline_model_.reset();
+  } else if (dirty_points_first_ < dirty_points_last_) {
+    control_mesh_->Update(control_points_, dirty_points_first_,
+                          dirty_points_last_);
+    dirty_points_first_ = ~std::size_t(0);
+    dirty_points_last_ = 0U;
+  }
+
+  // a tolerance change only rebuilds these two
+  if (!spline_model_ || !normal_model_) {
+    CreateLineModels();
+  } else if (!dirty_slots_.empty() || !freed_slots_.empty() || order_dirty_) {
+    PatchLineModels();
+  }
+
+  return true;
+}
+
+// every slot in one upload per model
+auto CubeBSpline::CreateLineModels() -> void {
+  auto const n_slots = order_.SlotCount();
+  auto spline_points = std::vector<Vertex3d>(n_slots * detail::kSplineSlotSize);
+  auto normal_points = std::vector<Vertex3d>(n_slots * detail::kNormalSlotSize);
+  auto spline_counts = std::vector<std::uint32_t>(n_slots, 0U);
+  auto normal_counts = std::vector<std::uint32_t>(n_slots, 0U);
+
+  for (auto idx = 0U; idx < SegmentCount(); ++idx) {
+    auto const slot = order_[idx];
+
+    FillSegmentPoints(segments_[slot], strip_);
+    std::copy(strip_.begin(), strip_.end(),
+              spline_points.begin() + static_cast<std::ptrdiff_t>(
+                                          slot * detail::kSplineSlotSize));
+    spline_counts[slot] = static_cast<std::uint32_t>(strip_.size());
+
+    FillSegmentNormals(segments_[slot], strip_);
+    std::copy(strip_.begin(), strip_.end(),
+              normal_points.begin() + static_cast<std::ptrdiff_t>(
+                                          slot * detail::kNormalSlotSize));
+    normal_counts[slot] = static_cast<std::uint32_t>(strip_.size());
+  }
+
+  spline_mesh_ = std::make_shared<MeshLineSlots>(detail::kSplineSlotSize);
+  spline_mesh_->Assign(spline_points, spline_counts);
+  spline_mesh_->SetOrder(order_.Slots());
+
+  normal_mesh_ = std::make_shared<MeshLineSlots>(detail::kNormalSlotSize);
+  normal_mesh_->Assign(normal_points, normal_counts);
+  normal_mesh_->SetOrder(order_.Slots());
+
+  spline_model_ = std::make_unique<Model>(shader_, spline_mesh_);
+  normal_model_ = std::make_unique<Model>(shader_, normal_mesh_);
+
+  spline_model_->SetColor(glm::vec3(0.f, 0.5f, 0.5f));
+  normal_model_->SetColor(glm::vec3(0.1f, 0.1f, 0.1f));
+
+  vertex_count_ = spline_mesh_->VertexCount() + normal_mesh_->VertexCount();
+  dirty_slots_.clear();
+  freed_slots_.clear();
+  order_dirty_ = false;
+}
+
+// only the slots of edited segments are tessellated and uploaded, a removed
+// segment's slot is emptied and left out of the draw order
+auto CubeBSpline::PatchLineModels() -> void {
+  std::sort(dirty_slots_.begin(), dirty_slots_.end());
+  dirty_slots_.erase(std::unique(dirty_slots_.begin(), dirty_slots_.end()),
+                     dirty_slots_.end());
+
+  for (auto const slot : dirty_slots_) {
+    FillSegmentPoints(segments_[slot], strip_);
+    spline_mesh_->Write(slot, strip_.data(), strip_.size());
+
+    FillSegmentNormals(segments_[slot], strip_);
+    normal_mesh_->Write(slot, strip_.data(), strip_.size());
+  }
+
+  // after the writes, a slot may have been edited before it was freed
+  for (auto const slot : freed_slots_) {
+    spline_mesh_->Write(slot, nullptr, 0U);
+    normal_mesh_->Write(slot, nullptr, 0U);
+  }
+
+  if (order_dirty_) {
+    spline_mesh_->SetOrder(order_.Slots());
+    normal_mesh_->SetOrder(order_.Slots());
+  }
+
+  vertex_count_ = spline_mesh_->VertexCount() + normal_mesh_->VertexCount();
+  dirty_slots_.clear();
+  freed_slots_.clear();
+  order_dirty_ = false;
+}
+
+auto CubeBSpline::SplinePoints() -> std::vector<Vertex3d> {
+  auto dst = std::vector<Vertex3d>();
+  FillSplinePoints(dst);
+
   return dst;
 }
 
 auto CubeBSpline::NormalPoints() -> std::vector<Vertex3d> {
   auto dst = std::vector<Vertex3d>();
-  for (auto idx = 0U; idx < control_points_.size() - 3; ++idx) {
-    for (auto seg_t = 0.f; seg_t < 1.f; seg_t += 0.1f) {
-      auto const spline_coord = SplineCoord(seg_t, idx);
-      auto const normal_dir = glm::normalize(SplineDdCoord(seg_t, idx));
+  FillNormalPoints(dst);
+
+  return dst;
+}
+
+auto CubeBSpline::SplinePoints(std::pmr::memory_resource* resource)
+    -> std::pmr::vector<Vertex3d> {
+  auto dst = std::pmr::vector<Vertex3d>(resource);
+  FillSplinePoints(dst);
+
+  return dst;
+}
+
+auto CubeBSpline::NormalPoints(std::pmr::memory_resource* resource)
+    -> std::pmr::vector<Vertex3d> {
+  auto dst = std::pmr::vector<Vertex3d>(resource);
+  FillNormalPoints(dst);
+
+  return dst;
+}
+
+template <class Emit>
+auto CubeBSpline::Tessellate(SplineSegment const& seg, float scale,
+                             int max_depth, Emit&& emit) const -> void {
+  Subdivide(seg, scale, 0.f, 1.f, detail::Coord(seg, 0.f),
+            detail::Coord(seg, 1.f), max_depth, emit);
+}
 
-      dst.push_back(spline_coord);
-      dst.push_back(spline_coord + normal_dir);
+// a piece is flat once its quarter points and midpoint are close enough to
+// the chord, three probes catch the s shape a lone midpoint misses. depth
+// counts down to zero
+template <class Emit>
+auto CubeBSpline::Subdivide(SplineSegment const& seg, float scale, float t0,
+                            float t1, Vertex3d p0, Vertex3d p1, int depth,
+                            Emit& emit) const -> void {
+  auto const tm = 0.5f * (t0 + t1);
+  auto const pm = detail::Coord(seg, tm);
+
+  if (depth > 0) {
+    auto const q1 = detail::Coord(seg, 0.5f * (t0 + tm));
+    auto const q3 = detail::Coord(seg, 0.5f * (tm + t1));
+    auto const error = std::max({detail::LineDistance(q1, p0, p1),
+                                 detail::LineDistance(pm, p0, p1),
+                                 detail::LineDistance(q3, p0, p1)});
+
+    if (error > scale * PieceTolerance(pm)) {
+      Subdivide(seg, scale, t0, tm, p0, pm, depth - 1, emit);
+      Subdivide(seg, scale, tm, t1, pm, p1, depth - 1, emit);
+      return;
     }
   }
 
-  return dst;
+  emit(t0, p0);
+}
+
+auto CubeBSpline::PieceTolerance(Vertex3d mid) const -> float {
+  if (screen_.pixels_per_unit <= 0.f) {
+    return tolerance_;
+  }
+
+  auto const distance =
+      std::max(glm::distance(screen_.eye, mid), detail::kMinEyeDistance);
+  return screen_.pixels * distance / screen_.pixels_per_unit;
+}
+
+template <class Vector>
+auto CubeBSpline::FillSplinePoints(Vector& dst) -> void {
+  dst.clear();
+  for (auto idx = 0U; idx < SegmentCount(); ++idx) {
+    Tessellate(Segment(idx), 1.f, detail::kMaxTessellationDepth,
+               [&](float, Vertex3d point) -> void { dst.push_back(point); });
+  }
+
+  if (SegmentCount() != 0U) {
+    dst.push_back(SplineCoord(1.f, SegmentCount() - 1U));
+  }
+}
+
+template <class Vector>
+auto CubeBSpline::FillNormalPoints(Vector& dst) -> void {
+  dst.clear();
+  for (auto idx = 0U; idx < SegmentCount(); ++idx) {
+    auto const& seg = Segment(idx);
+    Tessellate(seg, detail::kNormalToleranceScale, detail::kMaxNormalDepth,
+               [&](float t, Vertex3d point) -> void {
+                 dst.push_back(point);
+                 dst.push_back(point +
+                               glm::normalize(detail::DdCoord(seg, t)));
+               });
+  }
+}
+
+auto CubeBSpline::FillSegmentPoints(SplineSegment const& seg,
+                                    std::vector<Vertex3d>& dst) -> void {
+  dst.clear();
+  Tessellate(seg, 1.f, detail::kMaxTessellationDepth,
+             [&](float, Vertex3d point) -> void { dst.push_back(point); });
+  dst.push_back(detail::Coord(seg, 1.f));
+}
+
+auto CubeBSpline::FillSegmentNormals(SplineSegment const& seg,
+                                     std::vector<Vertex3d>& dst) -> void {
+  dst.clear();
+  Tessellate(seg, detail::kNormalToleranceScale, detail::kMaxNormalDepth,
+             [&](float t, Vertex3d point) -> void {
+               dst.push_back(point);
+               dst.push_back(point + glm::normalize(detail::DdCoord(seg, t)));
+             });
 }
 
 }  // namespace goya
@@ -0,0 +1,108 @@
+#include "goya/bounds.hpp"
+
+#include <cmath>
+
+namespace goya {
+
+auto BoundsOf(std::vector<Vertex3d> const& points) noexcept -> Aabb {
+  auto dst = Aabb();
+  for (auto const& point : points) {
+    dst.lo = glm::min(dst.lo, point);
+    dst.hi = glm::max(dst.hi, point);
+  }
+
+  return dst;
+}
+
+auto Union(Aabb const& lhs, Aabb const& rhs) noexcept -> Aabb {
+  return Aabb{glm::min(lhs.lo, rhs.lo), glm::max(lhs.hi, rhs.hi)};
+}
+
+auto Contains(Aabb const& outer, Aabb const& inner) noexcept -> bool {
+  return outer.lo.x <= inner.lo.x && outer.lo.y <= inner.lo.y &&
+         outer.lo.z <= inner.lo.z && inner.hi.x <= outer.hi.x &&
+         inner.hi.y <= outer.hi.y && inner.hi.z <= outer.hi.z;
+}
+
+auto SurfaceArea(Aabb const& box) noexcept -> float {
+  auto const d = box.hi - box.lo;
+  return 2.f * (d.x * d.y + d.y * d.z + d.z * d.x);
+}
+
+auto Fatten(Aabb const& box, float const margin) noexcept -> Aabb {
+  return Aabb{box.lo - glm::vec3(margin), box.hi + glm::vec3(margin)};
+}
+
+auto Transform(Aabb const& box, glm::mat4 const& matrix) noexcept -> Aabb {
+  auto dst = Aabb{glm::vec3(matrix[3]), glm::vec3(matrix[3])};
+  for (auto col = 0; col < 3; ++col) {
+    for (auto row = 0; row < 3; ++row) {
+      auto const a = matrix[col][row] * box.lo[col];
+      auto const b = matrix[col][row] * box.hi[col];
+
+      dst.lo[row] += std::min(a, b);
+      dst.hi[row] += std::max(a, b);
+    }
+  }
+
+  return dst;
+}
+
+// Gribb & Hartmann, rows of the column major matrix combined pairwise
+auto ExtractFrustum(glm::mat4 const& view_projection) noexcept -> Frustum {
+  auto const row = [&view_projection](int const idx) -> glm::vec4 {
+    return glm::vec4(view_projection[0][idx], view_projection[1][idx],
+                     view_projection[2][idx], view_projection[3][idx]);
+  };
+
+  auto dst = Frustum();
+  for (auto axis = 0; axis < 3; ++axis) {
+    auto const idx = static_cast<std::size_t>(axis) * 2U;
+    dst.planes[idx] = row(3) + row(axis);
+    dst.planes[idx + 1U] = row(3) - row(axis);
+  }
+
+  for (auto& plane : dst.planes) {
+    plane /= glm::length(glm::vec3(plane));
+  }
+
+  return dst;
+}
+
+auto Classify(Frustum const& frustum, Aabb const& box) noexcept
+    -> Containment {
+  auto plane_mask = kAllPlanes;
+  return Classify(frustum, box, plane_mask);
+}
+
+// center/extent form: the box projects onto each plane normal as a segment
+// of radius dot(|n|, extent) around the projected center
+auto Classify(Frustum const& frustum, Aabb const& box,
+              std::uint8_t& plane_mask) noexcept -> Containment {
+  auto const center = (box.hi + box.lo) * 0.5f;
+  auto const extent = (box.hi - box.lo) * 0.5f;
+
+  for (auto i = 0U; i < frustum.planes.size(); ++i) {
+    auto const bit = static_cast<std::uint8_t>(1U << i);
+    if (!(plane_mask & bit)) {
+      continue;
+    }
+
+    auto const& plane = frustum.planes[i];
+    auto const normal = glm::vec3(plane);
+    auto const dist = glm::dot(normal, center) + plane.w;
+    auto const radius = glm::dot(glm::abs(normal), extent);
+
+    if (dist < -radius) {
+      return Containment::kOutside;
+    }
+
+    if (dist >= radius) {
+      plane_mask = static_cast<std::uint8_t>(plane_mask & ~bit);
+    }
+  }
+
+  return plane_mask == 0U ? Containment::kInside : Containment::kIntersecting;
+}
+
+}  // namespace goya
@@ -17,7 +17,8 @@ Camera::Camera(glm::vec3 pos, glm::vec3 front, glm::vec3 up,
       front_(front),
       up_(up),
       right_(glm::normalize(glm::cross(front_, up_))),
-      projection_(projection) {}
+      projection_(projection),
+      view_(glm::lookAt(pos_, pos_ + front_, up_)) {}
 
 auto Camera::AddShader(std::shared_ptr<Shader> shader) -> void {
   shaders_.push_back(std::move(shader));
@@ -71,6 +72,21 @@ auto Camera::ShiftLook(float x_offset, float y_offset, TimeType delta) -> void {
   pitch_ = std::min(std::max(pitch_, -89.f), 89.f);
 }
 
+auto Camera::LookAlong(glm::vec3 pos, glm::vec3 front, glm::vec3 up)
+    -> void {
+  pos_ = pos;
+  front_ = glm::normalize(front);
+  right_ = glm::normalize(glm::cross(front_, up));
+  up_ = glm::cross(right_, front_);
+
+  // a later Refresh() keeps looking the same way
+  pitch_ = glm::degrees(std::asin(std::min(std::max(front_.y, -1.f), 1.f)));
+  yaw_ = glm::degrees(std::atan2(front_.z, front_.x));
+
+  view_ = glm::lookAt(pos_, pos_ + front_, up_);
+  UpdateUniforms();
+}
+
 auto Camera::SetSpeed(float speed) noexcept -> void { speed_ = speed; }
 
 auto Camera::GetSpeed() const noexcept -> float { return speed_; }
@@ -85,4 +101,16 @@ auto Camera::UpdateAspectRatio(float ratio) -> void {
   projection_ = glm::perspective(glm::radians(55.f), ratio, 0.1f, 100.f);
 }
 
+auto Camera::Position() const noexcept -> glm::vec3 { return pos_; }
+
+auto Camera::Front() const noexcept -> glm::vec3 { return front_; }
+
+auto Camera::Projection() const noexcept -> glm::mat4 {
+  return projection_;
+}
+
+auto Camera::ViewProjection() const noexcept -> glm::mat4 {
+  return projection_ * view_;
+}
+
 }  // namespace goya
@@ -0,0 +1,41 @@
+#include "goya/camera_path.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+#include <utility>
+
+namespace goya {
+
+namespace detail {
+
+static auto constexpr kMinPathPoints = std::size_t(4U);
+
+auto CheckedPath(std::vector<Vertex3d> control_points)
+    -> std::vector<Vertex3d> {
+  if (control_points.size() < kMinPathPoints) {
+    throw std::invalid_argument(
+        "[goya::CameraPath] a path needs at least 4 control points.");
+  }
+
+  return control_points;
+}
+
+}  // namespace detail
+
+CameraPath::CameraPath(std::vector<Vertex3d> control_points)
+    : spline_(detail::CheckedPath(std::move(control_points)), nullptr) {}
+
+auto CameraPath::Apply(Camera& camera, float const fraction) const -> void {
+  auto const param =
+      spline_.ArcParameter(std::clamp(fraction, 0.f, 1.f) * spline_.Length());
+
+  auto const front = spline_.SplineDCoord(param.t, param.idx);
+  auto const up =
+      spline_.Orientation(param.t, param.idx) * Vertex3d(0.f, 1.f, 0.f);
+
+  camera.LookAlong(spline_.SplineCoord(param.t, param.idx), front, up);
+}
+
+auto CameraPath::Length() const noexcept -> float { return spline_.Length(); }
+
+}  // namespace goya
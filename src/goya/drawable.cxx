@@ -1 +1,11 @@
 #include "goya/drawable.hpp"
+
+#include "goya/render_queue.hpp"
+
+namespace goya {
+
+auto IDrawable::Submit(RenderQueue& queue) -> void {
+  queue.Push(MakeDrawKey(RenderPass::kOpaque, 0U, 0U, 0.f), this);
+}
+
+}  // namespace goya
@@ -0,0 +1,327 @@
+#include "goya/dynamic_bvh.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+#include <stdexcept>
+
+namespace goya {
+
+namespace detail {
+
+auto constexpr kMinFatMargin = 1e-3f;
+
+// grows the box relative to its own extent so big and small objects both get
+// some slack before they need to be reinserted
+auto FattenRelative(Aabb const& box, float const margin) noexcept -> Aabb {
+  auto const slack = (box.hi - box.lo) * margin + glm::vec3(kMinFatMargin);
+  return Aabb{box.lo - slack, box.hi + slack};
+}
+
+}  // namespace detail
+
+DynamicBvh::DynamicBvh(float const margin)
+    : margin_(margin), root_(kNullNode), free_list_(kNullNode), n_leaves_(0U) {}
+
+auto DynamicBvh::CreateProxy(Aabb const& box, std::uint32_t const user_data)
+    -> std::int32_t {
+  auto const proxy = AllocateNode();
+
+  auto& node = nodes_[static_cast<std::size_t>(proxy)];
+  node.box = detail::FattenRelative(box, margin_);
+  node.user_data = user_data;
+  node.height = 0;
+
+  InsertLeaf(proxy);
+  ++n_leaves_;
+
+  return proxy;
+}
+
+auto DynamicBvh::DestroyProxy(std::int32_t const proxy) -> void {
+  RemoveLeaf(proxy);
+  FreeNode(proxy);
+  --n_leaves_;
+}
+
+auto DynamicBvh::MoveProxy(std::int32_t const proxy, Aabb const& box) -> bool {
+  auto& node = nodes_[static_cast<std::size_t>(proxy)];
+  if (Contains(node.box, box)) {
+    return false;
+  }
+
+  RemoveLeaf(proxy);
+  nodes_[static_cast<std::size_t>(proxy)].box =
+      detail::FattenRelative(box, margin_);
+  InsertLeaf(proxy);
+
+  return true;
+}
+
+auto DynamicBvh::FatBounds(std::int32_t const proxy) const -> Aabb const& {
+  return nodes_[static_cast<std::size_t>(proxy)].box;
+}
+
+auto DynamicBvh::UserData(std::int32_t const proxy) const -> std::uint32_t {
+  return nodes_[static_cast<std::size_t>(proxy)].user_data;
+}
+
+auto DynamicBvh::Query(Frustum const& frustum, std::vector<std::uint32_t>& dst)
+    -> QueryStats {
+  auto stats = QueryStats();
+  if (root_ == kNullNode) {
+    return stats;
+  }
+
+  auto const n_before = dst.size();
+
+  stack_.clear();
+  stack_.emplace_back(root_, kAllPlanes);
+  while (!stack_.empty()) {
+    auto [idx, plane_mask] = stack_.back();
+    stack_.pop_back();
+    ++stats.nodes_visited;
+
+    auto const& node = nodes_[static_cast<std::size_t>(idx)];
+    auto const containment = Classify(frustum, node.box, plane_mask);
+    if (containment == Containment::kOutside) {
+      continue;
+    }
+
+    if (node.IsLeaf()) {
+      dst.push_back(node.user_data);
+    } else if (containment == Containment::kInside) {
+      // whole subtree is visible, no more plane tests below this node
+      CollectLeaves(idx, dst);
+    } else {
+      stack_.emplace_back(node.left, plane_mask);
+      stack_.emplace_back(node.right, plane_mask);
+    }
+  }
+
+  stats.leaves_accepted = dst.size() - n_before;
+  return stats;
+}
+
+auto DynamicBvh::Height() const noexcept -> std::int32_t {
+  return root_ == kNullNode ? 0 : nodes_[static_cast<std::size_t>(root_)].height;
+}
+
+auto DynamicBvh::Size() const noexcept -> std::size_t { return n_leaves_; }
+
+auto DynamicBvh::AllocateNode() -> std::int32_t {
+  if (free_list_ == kNullNode) {
+    nodes_.emplace_back();
+    free_list_ = static_cast<std::int32_t>(nodes_.size() - 1U);
+    nodes_.back().parent = kNullNode;
+  }
+
+  auto const idx = free_list_;
+  auto& node = nodes_[static_cast<std::size_t>(idx)];
+  free_list_ = node.parent;
+
+  node.parent = kNullNode;
+  node.left = kNullNode;
+  node.right = kNullNode;
+  node.height = 0;
+  node.user_data = 0U;
+
+  return idx;
+}
+
+auto DynamicBvh::FreeNode(std::int32_t const node) -> void {
+  auto& dst = nodes_[static_cast<std::size_t>(node)];
+  dst.parent = free_list_;
+  dst.height = -1;
+  free_list_ = node;
+}
+
+auto DynamicBvh::InsertLeaf(std::int32_t const leaf) -> void {
+  if (root_ == kNullNode) {
+    root_ = leaf;
+    nodes_[static_cast<std::size_t>(leaf)].parent = kNullNode;
+    return;
+  }
+
+  auto const at = [this](std::int32_t idx) -> Node& {
+    return nodes_[static_cast<std::size_t>(idx)];
+  };
+
+  // descend towards the cheapest sibling by surface area heuristic
+  auto const leaf_box = at(leaf).box;
+  auto idx = root_;
+  while (!at(idx).IsLeaf()) {
+    auto const& node = at(idx);
+    auto const area = SurfaceArea(node.box);
+    auto const combined_area = SurfaceArea(Union(node.box, leaf_box));
+
+    auto const cost = 2.f * combined_area;
+    auto const inheritance_cost = 2.f * (combined_area - area);
+
+    auto const child_cost = [&](std::int32_t child) -> float {
+      auto const& child_node = at(child);
+      auto const merged = SurfaceArea(Union(leaf_box, child_node.box));
+      return child_node.IsLeaf()
+                 ? merged + inheritance_cost
+                 : merged - SurfaceArea(child_node.box) + inheritance_cost;
+    };
+
+    auto const left_cost = child_cost(node.left);
+    auto const right_cost = child_cost(node.right);
+    if (cost < left_cost && cost < right_cost) {
+      break;
+    }
+
+    idx = left_cost < right_cost ? node.left : node.right;
+  }
+
+  auto const sibling = idx;
+  auto const old_parent = at(sibling).parent;
+
+  auto const new_parent = AllocateNode();
+  at(new_parent).parent = old_parent;
+  at(new_parent).box = Union(leaf_box, at(sibling).box);
+  at(new_parent).height = at(sibling).height + 1;
+  at(new_parent).left = sibling;
+  at(new_parent).right = leaf;
+  at(sibling).parent = new_parent;
+  at(leaf).parent = new_parent;
+
+  if (old_parent == kNullNode) {
+    root_ = new_parent;
+  } else if (at(old_parent).left == sibling) {
+    at(old_parent).left = new_parent;
+  } else {
+    at(old_parent).right = new_parent;
+  }
+
+  Refit(new_parent);
+}
+
+auto DynamicBvh::RemoveLeaf(std::int32_t const leaf) -> void {
+  if (leaf == root_) {
+    root_ = kNullNode;
+    return;
+  }
+
+  auto const at = [this](std::int32_t idx) -> Node& {
+    return nodes_[static_cast<std::size_t>(idx)];
+  };
+
+  auto const parent = at(leaf).parent;
+  auto const grand_parent = at(parent).parent;
+  auto const sibling =
+      at(parent).left == leaf ? at(parent).right : at(parent).left;
+
+  if (grand_parent == kNullNode) {
+    root_ = sibling;
+    at(sibling).parent = kNullNode;
+    FreeNode(parent);
+    return;
+  }
+
+  if (at(grand_parent).left == parent) {
+    at(grand_parent).left = sibling;
+  } else {
+    at(grand_parent).right = sibling;
+  }
+
+  at(sibling).parent = grand_parent;
+  FreeNode(parent);
+
+  Refit(grand_parent);
+}
+
+// walks up from node, rebalancing and refitting every ancestor
+auto DynamicBvh::Refit(std::int32_t node) -> void {
+  while (node != kNullNode) {
+    node = Balance(node);
+
+    auto& dst = nodes_[static_cast<std::size_t>(node)];
+    auto const& left = nodes_[static_cast<std::size_t>(dst.left)];
+    auto const& right = nodes_[static_cast<std::size_t>(dst.right)];
+
+    dst.height = 1 + std::max(left.height, right.height);
+    dst.box = Union(left.box, right.box);
+
+    node = dst.parent;
+  }
+}
+
+// single rotation promoting the taller grandchild, returns the subtree root
+auto DynamicBvh::Balance(std::int32_t const a_idx) -> std::int32_t {
+  auto const at = [this](std::int32_t idx) -> Node& {
+    return nodes_[static_cast<std::size_t>(idx)];
+  };
+
+  auto& a = at(a_idx);
+  if (a.IsLeaf() || a.height < 2) {
+    return a_idx;
+  }
+
+  auto const b_idx = a.left;
+  auto const c_idx = a.right;
+  auto const balance = at(c_idx).height - at(b_idx).height;
+  if (std::abs(balance) <= 1) {
+    return a_idx;
+  }
+
+  // rotate the taller child up, x is the taller child, y its sibling
+  auto const x_idx = balance > 0 ? c_idx : b_idx;
+  auto& x = at(x_idx);
+
+  auto const f_idx = x.left;
+  auto const g_idx = x.right;
+
+  x.left = a_idx;
+  x.parent = a.parent;
+  a.parent = x_idx;
+
+  if (x.parent == kNullNode) {
+    root_ = x_idx;
+  } else if (at(x.parent).left == a_idx) {
+    at(x.parent).left = x_idx;
+  } else {
+    at(x.parent).right = x_idx;
+  }
+
+  auto const keep_idx = at(f_idx).height > at(g_idx).height ? f_idx : g_idx;
+  auto const move_idx = keep_idx == f_idx ? g_idx : f_idx;
+
+  x.right = keep_idx;
+  if (balance > 0) {
+    a.right = move_idx;
+  } else {
+    a.left = move_idx;
+  }
+  at(move_idx).parent = a_idx;
+
+  auto const& a_left = at(a.left);
+  auto const& a_right = at(a.right);
+  a.box = Union(a_left.box, a_right.box);
+  a.height = 1 + std::max(a_left.height, a_right.height);
+
+  x.box = Union(a.box, at(keep_idx).box);
+  x.height = 1 + std::max(a.height, at(keep_idx).height);
+
+  return x_idx;
+}
+
+auto DynamicBvh::CollectLeaves(std::int32_t const node,
+                               std::vector<std::uint32_t>& dst) -> void {
+  collect_stack_.clear();
+  collect_stack_.push_back(node);
+  while (!collect_stack_.empty()) {
+    auto const& curr =
+        nodes_[static_cast<std::size_t>(collect_stack_.back())];
+    collect_stack_.pop_back();
+
+    if (curr.IsLeaf()) {
+      dst.push_back(curr.user_data);
+    } else {
+      collect_stack_.push_back(curr.left);
+      collect_stack_.push_back(curr.right);
+    }
+  }
+}
+
+}  // namespace goya
@@ -1,6 +1,341 @@
 #include "goya/engine.hpp"
 
+#include <algorithm>
+#include <chrono>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+
+#include "glm/gtc/quaternion.hpp"
+#include "goya/profiler.hpp"
+
 namespace goya {
 
+namespace detail {
+
+using EngineClock = std::chrono::steady_clock;
+
+auto SecondsBetween(EngineClock::time_point const from,
+                    EngineClock::time_point const to) -> TimeType {
+  return std::chrono::duration<TimeType>(to - from).count();
+}
+
+}  // namespace detail
+
+auto InterpolatedTransform(FrameSnapshot const& snapshot, std::size_t const i)
+    -> glm::mat4 {
+  auto const& curr = snapshot.transforms[i];
+  if (i >= snapshot.prev_transforms.size()) {
+    return curr;
+  }
+
+  // blending the matrices themselves would shear mid rotation
+  auto const& prev = snapshot.prev_transforms[i];
+  auto const rotation = glm::slerp(glm::quat_cast(glm::mat3(prev)),
+                                   glm::quat_cast(glm::mat3(curr)),
+                                   snapshot.alpha);
+
+  auto dst = glm::mat4_cast(rotation);
+  dst[3] = glm::mix(prev[3], curr[3], snapshot.alpha);
+
+  return dst;
+}
+
+Engine::Engine(Window& window, EngineConfig config)
+    : window_(window),
+      config_(config),
+      jobs_(config.worker_threads),
+      sim_delta_(0.f),
+      sim_snapshot_(nullptr),
+      running_(false),
+      sim_frames_(0U),
+      render_frames_(0U),
+      has_snapshot_(false),
+      sim_time_(0.f),
+      accumulator_(0.f),
+      alpha_(1.f),
+      recorder_(nullptr),
+      replay_(nullptr) {
+  window_.SetFrameLimit(config_.frame_limit, config_.max_queued_frames);
+}
+
+auto Engine::AddSimulationHandler(SimulationHandler handler,
+                                  std::vector<SimulationTask> const& deps)
+    -> SimulationTask {
+  return simulation_graph_.Add(
+      [this, handler = std::move(handler)]() -> void {
+        handler(sim_delta_, *sim_snapshot_);
+      },
+      deps);
+}
+
+auto Engine::AddRenderHandler(RenderHandler handler) -> void {
+  render_handlers_.push_back(std::move(handler));
+}
+
+auto Engine::SetRecorder(InputRecorder* recorder) -> void {
+  if (recorder != nullptr &&
+      config_.simulation_mode == SimulationMode::kThreaded) {
+    throw std::invalid_argument(
+        "[goya::Engine] recording needs an inline or fixed step simulation.");
+  }
+
+  recorder_ = recorder;
+  if (recorder_ != nullptr && !record_queue_) {
+    record_queue_ = std::make_unique<InputQueue>();
+  }
+}
+
+auto Engine::SetReplay(InputReplay* replay) -> void {
+  if (replay != nullptr &&
+      config_.simulation_mode == SimulationMode::kThreaded) {
+    throw std::invalid_argument(
+        "[goya::Engine] replaying needs an inline or fixed step simulation.");
+  }
+
+  replay_ = replay;
+}
+
+auto Engine::Run() -> void {
+  running_.store(true, std::memory_order_release);
+  GOYA_PROFILE_THREAD_NAME("render");
+
+  auto sim_thread = std::thread();
+  if (config_.simulation_mode == SimulationMode::kThreaded) {
+    sim_thread = std::thread([this]() -> void { SimulationLoop(); });
+  }
+
+  auto const join = [&]() -> void {
+    running_.store(false, std::memory_order_release);
+    if (sim_thread.joinable()) {
+      sim_thread.join();
+    }
+  };
+
+  frame_times_.clear();
+  input_latencies_.clear();
+  if (config_.max_frames != 0U) {
+    frame_times_.reserve(config_.max_frames);
+    input_latencies_.reserve(config_.max_frames);
+  }
+
+  auto const late_input = config_.input_sampling == InputSampling::kLate;
+
+  if (replay_ != nullptr) {
+    auto const [x_pos, y_pos] = replay_->CursorStart();
+    window_.ResetInput(x_pos, y_pos);
+  } else if (recorder_ != nullptr) {
+    auto const [x_pos, y_pos] = window_.Input().CursorPosition();
+    recorder_->Begin(x_pos, y_pos);
+    window_.SetInputQueue(record_queue_.get());
+  }
+
+  try {
+    auto prev = detail::EngineClock::now();
+    auto frame_start = prev;
+    auto first_frame = true;
+    while (running_.load(std::memory_order_acquire)) {
+      // a frame spans from one present to the next, so it includes the swap
+      // or, headless, waiting for the gpu to finish the previous frame
+      window_.Present();
+      auto const now = detail::EngineClock::now();
+      if (!std::exchange(first_frame, false)) {
+        frame_times_.push_back(
+            1000.f * detail::SecondsBetween(frame_start, now));
+
+        auto const latency = static_cast<float>(
+            1000.0 * (window_.PresentTime() - window_.PollTime()));
+        input_latencies_.push_back(latency);
+        GOYA_PROFILE_COUNTER("Engine::input_latency_ms", latency);
+      }
+      frame_start = now;
+
+      window_.BeginFrame();
+      if (replay_ != nullptr && !replay_->Next(replay_frame_)) {
+        break;
+      }
+
+      if (!late_input && !PollInput()) {
+        break;
+      }
+
+      if (config_.max_frames != 0U && render_frames_ >= config_.max_frames) {
+        break;
+      }
+
+      // a replay takes the recorded frame time, however long the frame took
+      auto frame_delta = 0.f;
+      if (config_.simulation_mode != SimulationMode::kThreaded) {
+        frame_delta = replay_ != nullptr
+                          ? replay_frame_.frame_delta
+                          : StepDelta(detail::SecondsBetween(prev, now));
+        Advance(frame_delta);
+        prev = now;
+      }
+
+      if (late_input && !PollInput()) {
+        break;
+      }
+
+      Render();
+      if (recorder_ != nullptr) {
+        recorder_->EndFrame(frame_delta, window_.PollDelta());
+      }
+    }
+  } catch (...) {
+    window_.SetInputQueue(nullptr);
+    join();
+    throw;
+  }
+
+  if (recorder_ != nullptr) {
+    window_.SetInputQueue(nullptr);
+  }
+
+  join();
+  if (sim_error_) {
+    std::rethrow_exception(sim_error_);
+  }
+}
+
+auto Engine::Jobs() noexcept -> JobSystem& { return jobs_; }
+
+auto Engine::Stop() noexcept -> void {
+  running_.store(false, std::memory_order_release);
+}
+
+auto Engine::SimulationFrames() const noexcept -> std::uint64_t {
+  return sim_frames_.load(std::memory_order_relaxed);
+}
+
+auto Engine::RenderFrames() const noexcept -> std::uint64_t {
+  return render_frames_;
+}
+
+auto Engine::FrameTimes() const noexcept -> std::vector<float> const& {
+  return frame_times_;
+}
+
+auto Engine::InputLatencies() const noexcept -> std::vector<float> const& {
+  return input_latencies_;
+}
+
+auto Engine::SimulationLoop() -> void {
+  auto const step = std::chrono::duration_cast<detail::EngineClock::duration>(
+      std::chrono::duration<double>(1.0 / config_.simulation_rate));
+
+  GOYA_PROFILE_THREAD_NAME("simulation");
+
+  try {
+    auto prev = detail::EngineClock::now();
+    auto next = prev + step;
+    while (running_.load(std::memory_order_acquire)) {
+      std::this_thread::sleep_until(next);
+
+      auto const now = detail::EngineClock::now();
+      Simulate(StepDelta(detail::SecondsBetween(prev, now)));
+      prev = now;
+
+      // a late step does not trigger a burst of catch up steps
+      next = std::max(next + step, now);
+    }
+  } catch (...) {
+    sim_error_ = std::current_exception();
+    running_.store(false, std::memory_order_release);
+  }
+}
+
+auto Engine::StepDelta(TimeType const wall_delta) const noexcept
+    -> TimeType {
+  if (config_.fixed_delta > 0.f) {
+    return config_.fixed_delta;
+  }
+
+  return std::min(wall_delta, config_.max_delta);
+}
+
+auto Engine::PollInput() -> bool {
+  if (replay_ != nullptr) {
+    return window_.ReplayInput(replay_frame_.events, replay_frame_.poll_delta);
+  }
+
+  auto const dropped = window_.DroppedInputEvents();
+  auto const open = window_.PollInput();
+  if (recorder_ == nullptr) {
+    return open;
+  }
+
+  if (window_.DroppedInputEvents() != dropped) {
+    throw std::runtime_error(
+        "[goya::Engine] input queue overflowed while recording.");
+  }
+
+  auto event = InputEvent();
+  while (record_queue_->TryPop(event)) {
+    recorder_->Record(event);
+  }
+
+  return open;
+}
+
+// the same frame deltas run the same steps with the same alpha, which is what
+// makes a replay match its recording
+auto Engine::Advance(TimeType const frame_delta) -> void {
+  if (config_.simulation_mode == SimulationMode::kInline) {
+    Simulate(frame_delta);
+    return;
+  }
+
+  auto const step = 1.f / config_.simulation_rate;
+  accumulator_ += frame_delta;
+  while (accumulator_ >= step) {
+    Simulate(step);
+    accumulator_ -= step;
+  }
+
+  alpha_ = accumulator_ / step;
+}
+
+auto Engine::Simulate(TimeType const delta) -> void {
+  GOYA_PROFILE_ZONE("Engine::Simulate");
+
+  sim_time_ += delta;
+
+  auto& snapshot = snapshots_.Back();
+  snapshot.frame = sim_frames_.load(std::memory_order_relaxed) + 1U;
+  snapshot.sim_time = sim_time_;
+  snapshot.delta = delta;
+
+  sim_delta_ = delta;
+  sim_snapshot_ = &snapshot;
+  simulation_graph_.Run(jobs_);
+
+  if (config_.simulation_mode == SimulationMode::kFixedStep) {
+    snapshot.prev_transforms.assign(last_transforms_.begin(),
+                                    last_transforms_.end());
+    last_transforms_.assign(snapshot.transforms.begin(),
+                            snapshot.transforms.end());
+  }
+
+  snapshots_.Publish();
+  sim_frames_.fetch_add(1U, std::memory_order_relaxed);
+}
+
+auto Engine::Render() -> void {
+  has_snapshot_ = snapshots_.Acquire() || has_snapshot_;
+  if (!has_snapshot_) {
+    return;
+  }
+
+  GOYA_PROFILE_ZONE("Engine::Render");
+
+  auto& snapshot = snapshots_.Front();
+  snapshot.alpha = alpha_;
+  for (auto const& handler : render_handlers_) {
+    handler(snapshot);
+  }
+
+  ++render_frames_;
+}
 
 }  // namespace goya
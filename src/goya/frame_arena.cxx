@@ -0,0 +1,74 @@
+#include "goya/frame_arena.hpp"
+
+#include <algorithm>
+
+namespace goya {
+
+FrameArena::FrameArena(std::size_t const capacity)
+    : block_(std::make_unique<std::byte[]>(capacity)),
+      capacity_(capacity),
+      offset_(0U),
+      overflow_bytes_(0U),
+      high_water_(0U) {}
+
+FrameArena::~FrameArena() { ReleaseOverflow(); }
+
+auto FrameArena::Reset() -> void {
+  high_water_ = std::max(high_water_, Used());
+
+  if (!overflow_.empty()) {
+    ReleaseOverflow();
+
+    // half again as much, alignment padding of the spilled requests is not
+    // part of the high water mark
+    capacity_ = high_water_ + high_water_ / 2U;
+    block_ = std::make_unique<std::byte[]>(capacity_);
+  }
+
+  offset_ = 0U;
+  overflow_bytes_ = 0U;
+}
+
+auto FrameArena::Used() const noexcept -> std::size_t {
+  return offset_ + overflow_bytes_;
+}
+
+auto FrameArena::Capacity() const noexcept -> std::size_t { return capacity_; }
+
+auto FrameArena::HighWater() const noexcept -> std::size_t {
+  return std::max(high_water_, Used());
+}
+
+auto FrameArena::do_allocate(std::size_t const bytes,
+                             std::size_t const alignment) -> void* {
+  auto ptr = static_cast<void*>(block_.get() + offset_);
+  auto space = capacity_ - offset_;
+  if (std::align(alignment, bytes, ptr, space)) {
+    offset_ = capacity_ - space + bytes;
+    return ptr;
+  }
+
+  ptr = std::pmr::new_delete_resource()->allocate(bytes, alignment);
+  overflow_.push_back(OverflowBlock{ptr, bytes, alignment});
+  overflow_bytes_ += bytes;
+
+  return ptr;
+}
+
+auto FrameArena::do_deallocate(void*, std::size_t, std::size_t) -> void {}
+
+auto FrameArena::do_is_equal(
+    std::pmr::memory_resource const& other) const noexcept -> bool {
+  return this == &other;
+}
+
+auto FrameArena::ReleaseOverflow() noexcept -> void {
+  for (auto const& block : overflow_) {
+    std::pmr::new_delete_resource()->deallocate(block.ptr, block.bytes,
+                                                block.alignment);
+  }
+
+  overflow_.clear();
+}
+
+}  // namespace goya
@@ -0,0 +1,348 @@
+#include "goya/frame_capture.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <utility>
+
+#include "goya/gl_state.hpp"
+#include "goya/profiler.hpp"
+
+namespace goya {
+
+namespace detail {
+
+// ns per fence wait, the wait is repeated until the fence signals
+static auto constexpr kCaptureFenceTimeout = GLuint64(1000000U);
+
+// bytes of one stored deflate block
+static auto constexpr kStoredBlock = std::size_t(65535U);
+
+static auto constexpr kPngSignature =
+    std::array<std::uint8_t, 8U>{0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+
+auto CrcTable() -> std::array<std::uint32_t, 256U> const& {
+  static auto const table = []() -> std::array<std::uint32_t, 256U> {
+    auto dst = std::array<std::uint32_t, 256U>();
+    for (auto i = std::uint32_t(0U); i < dst.size(); ++i) {
+      auto crc = i;
+      for (auto bit = 0; bit < 8; ++bit) {
+        crc = (crc & 1U) != 0U ? 0xEDB88320U ^ (crc >> 1U) : crc >> 1U;
+      }
+      dst[i] = crc;
+    }
+
+    return dst;
+  }();
+
+  return table;
+}
+
+auto Crc32(std::uint8_t const* first, std::uint8_t const* last)
+    -> std::uint32_t {
+  auto const& table = CrcTable();
+
+  auto crc = ~std::uint32_t(0U);
+  for (; first != last; ++first) {
+    crc = table[(crc ^ *first) & 0xFFU] ^ (crc >> 8U);
+  }
+
+  return ~crc;
+}
+
+auto AppendBigEndian(std::vector<std::uint8_t>& dst, std::uint32_t const value)
+    -> void {
+  dst.push_back(static_cast<std::uint8_t>(value >> 24U));
+  dst.push_back(static_cast<std::uint8_t>(value >> 16U));
+  dst.push_back(static_cast<std::uint8_t>(value >> 8U));
+  dst.push_back(static_cast<std::uint8_t>(value));
+}
+
+// a chunk is its length, type, data and the crc of type and data
+auto BeginChunk(std::vector<std::uint8_t>& dst, char const* type)
+    -> std::size_t {
+  auto const start = dst.size();
+  AppendBigEndian(dst, 0U);
+  dst.insert(dst.end(), type, type + 4);
+
+  return start;
+}
+
+auto EndChunk(std::vector<std::uint8_t>& dst, std::size_t const start)
+    -> void {
+  auto const length = static_cast<std::uint32_t>(dst.size() - start - 8U);
+  for (auto i = 0U; i < 4U; ++i) {
+    dst[start + i] = static_cast<std::uint8_t>(length >> (24U - 8U * i));
+  }
+
+  AppendBigEndian(dst, Crc32(dst.data() + start + 4U, dst.data() + dst.size()));
+}
+
+auto WaitFence(GLsync const fence) -> bool {
+  auto status = glClientWaitSync(fence, 0U, 0U);
+  if (status == GL_ALREADY_SIGNALED || status == GL_CONDITION_SATISFIED) {
+    return false;
+  }
+
+  while (status == GL_TIMEOUT_EXPIRED) {
+    status = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT,
+                              kCaptureFenceTimeout);
+  }
+
+  if (status == GL_WAIT_FAILED) {
+    throw std::runtime_error("[goya::FrameCapture] fence wait failed.");
+  }
+
+  return true;
+}
+
+}  // namespace detail
+
+// every row is a filter byte and the pixels, the zlib stream around them uses
+// stored blocks only, so the image is copied once and summed with adler32
+auto EncodePng(std::int32_t const width, std::int32_t const height,
+               std::uint8_t const* rgba, std::vector<std::uint8_t>& dst)
+    -> void {
+  auto const row_bytes = static_cast<std::size_t>(width) * 4U;
+  auto const rows = static_cast<std::size_t>(height);
+  auto const raw_bytes = (row_bytes + 1U) * rows;
+  auto const blocks =
+      std::max((raw_bytes + detail::kStoredBlock - 1U) / detail::kStoredBlock,
+               std::size_t(1U));
+
+  dst.clear();
+  dst.reserve(detail::kPngSignature.size() + 25U + 12U + 6U + 5U * blocks +
+              raw_bytes + 12U);
+  dst.insert(dst.end(), detail::kPngSignature.begin(),
+             detail::kPngSignature.end());
+
+  auto chunk = detail::BeginChunk(dst, "IHDR");
+  detail::AppendBigEndian(dst, static_cast<std::uint32_t>(width));
+  detail::AppendBigEndian(dst, static_cast<std::uint32_t>(height));
+  // 8 bit rgba, deflate, adaptive filtering, no interlace
+  dst.insert(dst.end(), {8U, 6U, 0U, 0U, 0U});
+  detail::EndChunk(dst, chunk);
+
+  chunk = detail::BeginChunk(dst, "IDAT");
+  dst.push_back(0x78U);
+  dst.push_back(0x01U);
+
+  auto adler_a = std::uint32_t(1U);
+  auto adler_b = std::uint32_t(0U);
+  auto block_left = std::size_t(0U);
+  auto total_left = raw_bytes;
+
+  // feeds the raw stream, opening a stored block every kStoredBlock bytes
+  auto const feed = [&](std::uint8_t const* first, std::size_t count) -> void {
+    while (count != 0U) {
+      if (block_left == 0U) {
+        block_left = std::min(total_left, detail::kStoredBlock);
+        total_left -= block_left;
+
+        auto const len = static_cast<std::uint16_t>(block_left);
+        auto const nlen = static_cast<std::uint16_t>(~len);
+        dst.push_back(total_left == 0U ? 1U : 0U);
+        dst.push_back(static_cast<std::uint8_t>(len));
+        dst.push_back(static_cast<std::uint8_t>(len >> 8U));
+        dst.push_back(static_cast<std::uint8_t>(nlen));
+        dst.push_back(static_cast<std::uint8_t>(nlen >> 8U));
+      }
+
+      auto const n = std::min(count, block_left);
+      dst.insert(dst.end(), first, first + n);
+
+      // sums stay below 2^32 for 5552 bytes before they need reducing
+      for (auto done = std::size_t(0U); done < n;) {
+        auto const run = std::min(n - done, std::size_t(5552U));
+        for (auto i = done; i < done + run; ++i) {
+          adler_a += first[i];
+          adler_b += adler_a;
+        }
+        adler_a %= 65521U;
+        adler_b %= 65521U;
+        done += run;
+      }
+
+      first += n;
+      count -= n;
+      block_left -= n;
+    }
+  };
+
+  auto constexpr kNoFilter = std::uint8_t(0U);
+  for (auto row = rows; row-- > 0U;) {
+    feed(&kNoFilter, 1U);
+    feed(rgba + row * row_bytes, row_bytes);
+  }
+
+  detail::AppendBigEndian(dst, (adler_b << 16U) | adler_a);
+  detail::EndChunk(dst, chunk);
+
+  chunk = detail::BeginChunk(dst, "IEND");
+  detail::EndChunk(dst, chunk);
+}
+
+FrameCapture::FrameCapture(std::int32_t const width, std::int32_t const height,
+                           CaptureConfig config, JobSystem& jobs)
+    : width_(width),
+      height_(height),
+      frame_bytes_(static_cast<std::size_t>(width) *
+                   static_cast<std::size_t>(height) * 4U),
+      config_(std::move(config)),
+      jobs_(jobs) {
+  if (width_ <= 0 || height_ <= 0 || config_.lag == 0U ||
+      config_.encode_slots == 0U) {
+    throw std::invalid_argument(
+        "[goya::FrameCapture] needs a size, a lag and an encode slot.");
+  }
+
+  std::filesystem::create_directories(config_.directory);
+
+  read_slots_.resize(config_.lag);
+  for (auto& slot : read_slots_) {
+    glGenBuffers(1, &slot.pbo);
+    GlState().BindBuffer(GL_PIXEL_PACK_BUFFER, slot.pbo);
+    glBufferData(GL_PIXEL_PACK_BUFFER,
+                 static_cast<GLsizeiptr>(frame_bytes_), nullptr,
+                 GL_STREAM_READ);
+  }
+  GlState().BindBuffer(GL_PIXEL_PACK_BUFFER, 0U);
+
+  for (auto i = 0U; i < config_.encode_slots; ++i) {
+    encode_slots_.push_back(std::make_unique<EncodeSlot>());
+    encode_slots_.back()->pixels.resize(frame_bytes_);
+  }
+}
+
+// encoders still hold references to this, they have to finish first
+FrameCapture::~FrameCapture() {
+  for (auto& slot : encode_slots_) {
+    try {
+      jobs_.Wait(slot->group);
+    } catch (...) {
+    }
+  }
+
+  for (auto& slot : read_slots_) {
+    if (slot.fence != nullptr) {
+      glDeleteSync(slot.fence);
+    }
+    GlState().DeleteBuffer(slot.pbo);
+  }
+}
+
+auto FrameCapture::Capture() -> void {
+  GOYA_PROFILE_ZONE("FrameCapture::Capture");
+
+  // the frame lag frames back, its copy is usually long done
+  auto& slot = read_slots_[n_frames_ % read_slots_.size()];
+  if (slot.fence != nullptr) {
+    Resolve(slot);
+  }
+
+  GlState().BindBuffer(GL_PIXEL_PACK_BUFFER, slot.pbo);
+  glReadPixels(0, 0, width_, height_, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+  GlState().BindBuffer(GL_PIXEL_PACK_BUFFER, 0U);
+
+  slot.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0U);
+  slot.frame = n_frames_++;
+
+  GOYA_PROFILE_COUNTER("FrameCapture::stalls", n_stalls_);
+}
+
+auto FrameCapture::Finish() -> void {
+  GOYA_PROFILE_ZONE("FrameCapture::Finish");
+
+  // oldest first, so encoders see the frames in order
+  auto const n_slots = read_slots_.size();
+  for (auto i = std::size_t(0U); i < n_slots; ++i) {
+    auto& slot = read_slots_[(n_frames_ + i) % n_slots];
+    if (slot.fence != nullptr) {
+      Resolve(slot);
+    }
+  }
+
+  for (auto& encode : encode_slots_) {
+    jobs_.Wait(encode->group);
+  }
+}
+
+auto FrameCapture::Frames() const noexcept -> std::uint64_t {
+  return n_frames_;
+}
+
+auto FrameCapture::Stalls() const noexcept -> std::uint64_t {
+  return n_stalls_;
+}
+
+auto FrameCapture::Resolve(ReadSlot& slot) -> void {
+  auto stalled = detail::WaitFence(slot.fence);
+  glDeleteSync(slot.fence);
+  slot.fence = nullptr;
+
+  auto& encode = *encode_slots_[next_encode_];
+  next_encode_ = (next_encode_ + 1U) % encode_slots_.size();
+
+  stalled = !encode.group.Done() || stalled;
+  jobs_.Wait(encode.group);
+  if (stalled) {
+    ++n_stalls_;
+  }
+
+  // the mapping is copied out, buffers are not persistently mappable in 4.1
+  GlState().BindBuffer(GL_PIXEL_PACK_BUFFER, slot.pbo);
+  auto const* pixels = glMapBufferRange(
+      GL_PIXEL_PACK_BUFFER, 0, static_cast<GLsizeiptr>(frame_bytes_),
+      GL_MAP_READ_BIT);
+  if (pixels == nullptr) {
+    GlState().BindBuffer(GL_PIXEL_PACK_BUFFER, 0U);
+    throw std::runtime_error("[goya::FrameCapture] failed to map a frame.");
+  }
+
+  std::memcpy(encode.pixels.data(), pixels, frame_bytes_);
+  glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+  GlState().BindBuffer(GL_PIXEL_PACK_BUFFER, 0U);
+
+  encode.frame = slot.frame;
+  jobs_.Spawn(encode.group, [this, &encode]() -> void { Write(encode); });
+}
+
+auto FrameCapture::Write(EncodeSlot& slot) const -> void {
+  GOYA_PROFILE_ZONE("FrameCapture::Write");
+
+  auto const png = config_.format == CaptureFormat::kPng;
+
+  auto name = std::array<char, 32U>();
+  std::snprintf(name.data(), name.size(), "frame_%06llu.%s",
+                static_cast<unsigned long long>(slot.frame),
+                png ? "png" : "rgba");
+  auto const path = (std::filesystem::path(config_.directory) / name.data())
+                        .string();
+
+  if (png) {
+    EncodePng(width_, height_, slot.pixels.data(), slot.bytes);
+  } else {
+    // gl rows are bottom up
+    auto const row_bytes = static_cast<std::size_t>(width_) * 4U;
+    slot.bytes.resize(frame_bytes_);
+    for (auto row = std::size_t(0U); row < static_cast<std::size_t>(height_);
+         ++row) {
+      std::memcpy(slot.bytes.data() + row * row_bytes,
+                  slot.pixels.data() + frame_bytes_ - (row + 1U) * row_bytes,
+                  row_bytes);
+    }
+  }
+
+  auto ofstrm = std::ofstream(path, std::ios::binary);
+  ofstrm.write(reinterpret_cast<char const*>(slot.bytes.data()),
+               static_cast<std::streamsize>(slot.bytes.size()));
+  if (!ofstrm) {
+    throw std::runtime_error("[goya::FrameCapture] failed to write " + path);
+  }
+}
+
+}  // namespace goya
@@ -0,0 +1,332 @@
+#include "goya/geometry_arena.hpp"
+
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+
+#include "GL/glew.h"
+#include "goya/gl_state.hpp"
+#include "goya/render_queue.hpp"
+
+namespace goya {
+
+namespace detail {
+
+auto constexpr kNoBlock = std::numeric_limits<std::size_t>::max();
+auto constexpr kArenaStride = sizeof(Vertex3d);
+
+auto ToGlMode(ArenaPrimitive const primitive) -> GLenum {
+  switch (primitive) {
+    case ArenaPrimitive::kTriangles:
+      return GL_TRIANGLES;
+    case ArenaPrimitive::kLines:
+      return GL_LINES;
+    case ArenaPrimitive::kLineStrip:
+      return GL_LINE_STRIP;
+  }
+
+  return GL_TRIANGLES;
+}
+
+auto ByteSize(std::size_t const n_vertices) -> GLsizeiptr {
+  return static_cast<GLsizeiptr>(n_vertices * kArenaStride);
+}
+
+}  // namespace detail
+
+GeometryArena::GeometryArena(std::size_t const initial_capacity)
+    : capacity_(std::max(initial_capacity, std::size_t(1))), used_(0U) {
+  glGenVertexArrays(1, &vao_);
+  glGenBuffers(1, &vbo_);
+
+  GlState().BindVertexArray(vao_);
+  GlState().BindBuffer(GL_ARRAY_BUFFER, vbo_);
+  glBufferData(GL_ARRAY_BUFFER, detail::ByteSize(capacity_), nullptr,
+               GL_STATIC_DRAW);
+
+  glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, detail::kArenaStride,
+                        nullptr);
+  glEnableVertexAttribArray(0);
+
+  GlState().BindVertexArray(0);
+
+  free_list_.push_back(ArenaRange{0U, capacity_});
+}
+
+GeometryArena::~GeometryArena() {
+  GlState().DeleteVertexArray(vao_);
+  GlState().DeleteBuffer(vbo_);
+}
+
+auto GeometryArena::Allocate(std::vector<Vertex3d> const& vertices)
+    -> MeshId {
+  auto const count = vertices.size();
+  auto first = count == 0U ? std::size_t(0) : FindFree(count);
+  if (first == detail::kNoBlock) {
+    Grow(used_ + count);
+    first = FindFree(count);
+  }
+
+  if (count > 0U) {
+    GlState().BindBuffer(GL_ARRAY_BUFFER, vbo_);
+    glBufferSubData(GL_ARRAY_BUFFER,
+                    static_cast<GLintptr>(first * detail::kArenaStride),
+                    detail::ByteSize(count), vertices.data());
+  }
+
+  used_ += count;
+
+  auto const range = ArenaRange{first, count};
+  if (free_ids_.empty()) {
+    ranges_.push_back(range);
+    return static_cast<MeshId>(ranges_.size() - 1U);
+  }
+
+  auto const id = free_ids_.back();
+  free_ids_.pop_back();
+  ranges_[id] = range;
+
+  return id;
+}
+
+auto GeometryArena::Free(MeshId const id) -> void {
+  auto& range = ranges_.at(id);
+  if (range.count > 0U) {
+    Release(range);
+    used_ -= range.count;
+  }
+
+  range = ArenaRange{0U, 0U};
+  free_ids_.push_back(id);
+}
+
+auto GeometryArena::Range(MeshId const id) const -> ArenaRange {
+  return ranges_.at(id);
+}
+
+auto GeometryArena::Defragment() -> void { Relocate(capacity_); }
+
+auto GeometryArena::Contiguity() const noexcept -> float {
+  auto const total_free = capacity_ - used_;
+  if (total_free == 0U) {
+    return 1.f;
+  }
+
+  auto largest = std::size_t(0);
+  for (auto const& block : free_list_) {
+    largest = std::max(largest, block.count);
+  }
+
+  return static_cast<float>(largest) / static_cast<float>(total_free);
+}
+
+auto GeometryArena::Capacity() const noexcept -> std::size_t {
+  return capacity_;
+}
+
+auto GeometryArena::Used() const noexcept -> std::size_t { return used_; }
+
+auto GeometryArena::VertexArray() const noexcept -> std::uint32_t {
+  return vao_;
+}
+
+auto GeometryArena::Draw(ArenaPrimitive const primitive, MeshId const id)
+    -> void {
+  auto const range = ranges_[id];
+
+  GlState().BindVertexArray(vao_);
+  glDrawArrays(detail::ToGlMode(primitive),
+               static_cast<GLint>(range.first),
+               static_cast<GLsizei>(range.count));
+}
+
+auto GeometryArena::MultiDraw(ArenaPrimitive const primitive,
+                              std::vector<MeshId> const& ids) -> void {
+  draw_firsts_.clear();
+  draw_counts_.clear();
+  for (auto const id : ids) {
+    auto const range = ranges_[id];
+    draw_firsts_.push_back(static_cast<std::int32_t>(range.first));
+    draw_counts_.push_back(static_cast<std::int32_t>(range.count));
+  }
+
+  if (draw_firsts_.empty()) {
+    return;
+  }
+
+  GlState().BindVertexArray(vao_);
+  glMultiDrawArrays(detail::ToGlMode(primitive), draw_firsts_.data(),
+                    draw_counts_.data(),
+                    static_cast<GLsizei>(draw_firsts_.size()));
+}
+
+// first fit, splits the block it lands in
+auto GeometryArena::FindFree(std::size_t const count) -> std::size_t {
+  auto const block = std::find_if(
+      free_list_.begin(), free_list_.end(),
+      [count](ArenaRange const& range) -> bool {
+        return range.count >= count;
+      });
+  if (block == free_list_.end()) {
+    return detail::kNoBlock;
+  }
+
+  auto const first = block->first;
+  block->first += count;
+  block->count -= count;
+  if (block->count == 0U) {
+    free_list_.erase(block);
+  }
+
+  return first;
+}
+
+auto GeometryArena::Release(ArenaRange const range) -> void {
+  auto next = std::lower_bound(
+      free_list_.begin(), free_list_.end(), range,
+      [](ArenaRange const& lhs, ArenaRange const& rhs) -> bool {
+        return lhs.first < rhs.first;
+      });
+  next = free_list_.insert(next, range);
+
+  auto const merge_next = [&](decltype(next) block) -> void {
+    auto const succ = std::next(block);
+    if (succ != free_list_.end() &&
+        block->first + block->count == succ->first) {
+      block->count += succ->count;
+      free_list_.erase(succ);
+    }
+  };
+
+  merge_next(next);
+  if (next != free_list_.begin()) {
+    merge_next(std::prev(next));
+  }
+}
+
+auto GeometryArena::Grow(std::size_t const min_capacity) -> void {
+  Relocate(std::max(capacity_ * 2U, min_capacity));
+}
+
+// copies every live mesh into a fresh buffer, packed from the front; the copy
+// stays on the gpu and a second buffer avoids overlapping copy ranges
+auto GeometryArena::Relocate(std::size_t const capacity) -> void {
+  auto dst_vbo = std::uint32_t();
+  glGenBuffers(1, &dst_vbo);
+  GlState().BindBuffer(GL_COPY_WRITE_BUFFER, dst_vbo);
+  glBufferData(GL_COPY_WRITE_BUFFER, detail::ByteSize(capacity), nullptr,
+               GL_STATIC_DRAW);
+  GlState().BindBuffer(GL_COPY_READ_BUFFER, vbo_);
+
+  auto live = std::vector<MeshId>();
+  for (auto id = MeshId(0); id < ranges_.size(); ++id) {
+    if (ranges_[id].count > 0U) {
+      live.push_back(id);
+    }
+  }
+
+  std::sort(live.begin(), live.end(), [this](MeshId lhs, MeshId rhs) -> bool {
+    return ranges_[lhs].first < ranges_[rhs].first;
+  });
+
+  auto cursor = std::size_t(0);
+  for (auto const id : live) {
+    auto& range = ranges_[id];
+    glCopyBufferSubData(
+        GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER,
+        static_cast<GLintptr>(range.first * detail::kArenaStride),
+        static_cast<GLintptr>(cursor * detail::kArenaStride),
+        detail::ByteSize(range.count));
+
+    range.first = cursor;
+    cursor += range.count;
+  }
+
+  GlState().DeleteBuffer(vbo_);
+  vbo_ = dst_vbo;
+  capacity_ = capacity;
+
+  free_list_.clear();
+  if (cursor < capacity_) {
+    free_list_.push_back(ArenaRange{cursor, capacity_ - cursor});
+  }
+
+  GlState().BindVertexArray(vao_);
+  GlState().BindBuffer(GL_ARRAY_BUFFER, vbo_);
+  glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, detail::kArenaStride,
+                        nullptr);
+  GlState().BindVertexArray(0);
+}
+
+ArenaMesh::ArenaMesh(std::shared_ptr<GeometryArena> arena,
+                     std::vector<Vertex3d> const& vertices,
+                     ArenaPrimitive const primitive)
+    : arena_(std::move(arena)),
+      id_(arena_->Allocate(vertices)),
+      primitive_(primitive),
+      bounds_(BoundsOf(vertices)) {}
+
+ArenaMesh::ArenaMesh(std::shared_ptr<GeometryArena> arena,
+                     MeshObjData const& obj_data)
+    : ArenaMesh(std::move(arena), detail::TransformObjToVertices(obj_data),
+                ArenaPrimitive::kTriangles) {}
+
+ArenaMesh::~ArenaMesh() { arena_->Free(id_); }
+
+auto ArenaMesh::Draw() -> void { arena_->Draw(primitive_, id_); }
+
+auto ArenaMesh::VertexArray() const noexcept -> std::uint32_t {
+  return arena_->VertexArray();
+}
+
+auto ArenaMesh::Bounds() const noexcept -> Aabb { return bounds_; }
+
+auto ArenaMesh::Id() const noexcept -> GeometryArena::MeshId { return id_; }
+
+auto ArenaMesh::Primitive() const noexcept -> ArenaPrimitive {
+  return primitive_;
+}
+
+ArenaBatch::ArenaBatch(std::shared_ptr<Shader> shader,
+                       std::shared_ptr<GeometryArena> arena,
+                       ArenaPrimitive const primitive)
+    : shader_(std::move(shader)),
+      arena_(std::move(arena)),
+      primitive_(primitive) {}
+
+auto ArenaBatch::Add(ArenaMesh const& mesh) -> void {
+  if (mesh.Primitive() != primitive_) {
+    throw std::invalid_argument(
+        "[goya::ArenaBatch] mesh primitive does not match the batch");
+  }
+
+  ids_.push_back(mesh.Id());
+}
+
+auto ArenaBatch::Clear() -> void { ids_.clear(); }
+
+auto ArenaBatch::SetModelMatrix(glm::mat4 model) -> void {
+  model_matrix_ = std::move(model);
+}
+
+auto ArenaBatch::SetColor(glm::vec3 color) -> void { color_ = color; }
+
+auto ArenaBatch::Draw() -> void {
+  GlState().SetDepthTest(true);
+  GlState().SetBlend(false);
+
+  shader_->Use();
+  shader_->SetVec3("color", color_);
+  shader_->SetMat4("model", model_matrix_);
+
+  arena_->MultiDraw(primitive_, ids_);
+}
+
+auto ArenaBatch::Submit(RenderQueue& queue) -> void {
+  auto const depth = queue.Depth(glm::vec3(model_matrix_[3]));
+  queue.Push(MakeDrawKey(RenderPass::kOpaque, shader_->Id(),
+                         arena_->VertexArray(), depth),
+             this);
+}
+
+}  // namespace goya
@@ -0,0 +1,208 @@
+#include "goya/gl_state.hpp"
+
+#include "GL/glew.h"
+
+namespace goya {
+
+namespace detail {
+
+auto constexpr kInvalidSlot = ~0U;
+
+auto BufferSlot(std::uint32_t const target) noexcept -> std::uint32_t {
+  switch (target) {
+    case GL_ARRAY_BUFFER:
+      return 0U;
+    case GL_ELEMENT_ARRAY_BUFFER:
+      return 1U;
+    case GL_COPY_READ_BUFFER:
+      return 2U;
+    case GL_COPY_WRITE_BUFFER:
+      return 3U;
+    case GL_PIXEL_PACK_BUFFER:
+      return 4U;
+    case GL_PIXEL_UNPACK_BUFFER:
+      return 5U;
+    default:
+      return kInvalidSlot;
+  }
+}
+
+auto constexpr kElementSlot = 1U;
+
+}  // namespace detail
+
+GlStateCache::GlStateCache() { Invalidate(); }
+
+auto GlStateCache::UseProgram(std::uint32_t const program) -> void {
+  if (program_ == program) {
+    Skip();
+    return;
+  }
+
+  glUseProgram(program);
+  program_ = program;
+  Issue();
+}
+
+auto GlStateCache::BindVertexArray(std::uint32_t const vao) -> void {
+  if (vao_ == vao) {
+    Skip();
+    return;
+  }
+
+  glBindVertexArray(vao);
+  vao_ = vao;
+  // element array binding is part of the vertex array object
+  buffers_[detail::kElementSlot] = kUnknownName;
+  Issue();
+}
+
+auto GlStateCache::BindBuffer(std::uint32_t const target,
+                              std::uint32_t const buffer) -> void {
+  auto const slot = detail::BufferSlot(target);
+  if (slot == detail::kInvalidSlot) {
+    glBindBuffer(target, buffer);
+    Issue();
+    return;
+  }
+
+  if (buffers_[slot] == buffer) {
+    Skip();
+    return;
+  }
+
+  glBindBuffer(target, buffer);
+  buffers_[slot] = buffer;
+  Issue();
+}
+
+auto GlStateCache::SetBlend(bool const enabled) -> void {
+  SetCapability(GL_BLEND, blend_, enabled);
+}
+
+auto GlStateCache::BlendFunc(std::uint32_t const src_factor,
+                             std::uint32_t const dst_factor) -> void {
+  if (blend_src_ == src_factor && blend_dst_ == dst_factor) {
+    Skip();
+    return;
+  }
+
+  glBlendFunc(src_factor, dst_factor);
+  blend_src_ = src_factor;
+  blend_dst_ = dst_factor;
+  Issue();
+}
+
+auto GlStateCache::SetDepthTest(bool const enabled) -> void {
+  SetCapability(GL_DEPTH_TEST, depth_test_, enabled);
+}
+
+auto GlStateCache::SetDepthWrite(bool const enabled) -> void {
+  auto const state = enabled ? Tristate::kOn : Tristate::kOff;
+  if (depth_write_ == state) {
+    Skip();
+    return;
+  }
+
+  glDepthMask(enabled ? GL_TRUE : GL_FALSE);
+  depth_write_ = state;
+  Issue();
+}
+
+auto GlStateCache::DepthFunc(std::uint32_t const func) -> void {
+  if (depth_func_ == func) {
+    Skip();
+    return;
+  }
+
+  glDepthFunc(func);
+  depth_func_ = func;
+  Issue();
+}
+
+auto GlStateCache::SetCullFace(bool const enabled) -> void {
+  SetCapability(GL_CULL_FACE, cull_face_, enabled);
+}
+
+auto GlStateCache::CullFace(std::uint32_t const mode) -> void {
+  if (cull_mode_ == mode) {
+    Skip();
+    return;
+  }
+
+  glCullFace(mode);
+  cull_mode_ = mode;
+  Issue();
+}
+
+auto GlStateCache::DeleteVertexArray(std::uint32_t const vao) -> void {
+  glDeleteVertexArrays(1, &vao);
+  if (vao_ == vao) {
+    vao_ = 0U;
+    buffers_[detail::kElementSlot] = kUnknownName;
+  }
+}
+
+auto GlStateCache::DeleteBuffer(std::uint32_t const buffer) -> void {
+  glDeleteBuffers(1, &buffer);
+  for (auto& bound : buffers_) {
+    if (bound == buffer) {
+      bound = 0U;
+    }
+  }
+}
+
+auto GlStateCache::Invalidate() -> void {
+  program_ = kUnknownName;
+  vao_ = kUnknownName;
+  buffers_.fill(kUnknownName);
+
+  blend_ = Tristate::kUnknown;
+  blend_src_ = kUnknownName;
+  blend_dst_ = kUnknownName;
+
+  depth_test_ = Tristate::kUnknown;
+  depth_write_ = Tristate::kUnknown;
+  depth_func_ = kUnknownName;
+
+  cull_face_ = Tristate::kUnknown;
+  cull_mode_ = kUnknownName;
+}
+
+auto GlStateCache::BeginFrame() -> void {
+  last_frame_stats_ = frame_stats_;
+  frame_stats_ = GlStateStats();
+}
+
+auto GlStateCache::FrameStats() const noexcept -> GlStateStats {
+  return last_frame_stats_;
+}
+
+auto GlStateCache::SetCapability(std::uint32_t const cap, Tristate& cached,
+                                 bool const enabled) -> void {
+  auto const state = enabled ? Tristate::kOn : Tristate::kOff;
+  if (cached == state) {
+    Skip();
+    return;
+  }
+
+  if (enabled) {
+    glEnable(cap);
+  } else {
+    glDisable(cap);
+  }
+
+  cached = state;
+  Issue();
+}
+
+auto GlStateCache::Issue() noexcept -> void { ++frame_stats_.issued; }
+
+auto GlStateCache::Skip() noexcept -> void { ++frame_stats_.skipped; }
+
+auto GlState() -> GlStateCache& {
+  static auto cache = GlStateCache();
+  return cache;
+}
+
+}  // namespace goya
@@ -0,0 +1,221 @@
+#include "goya/input_log.hpp"
+
+#include <array>
+#include <cstring>
+#include <iterator>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+namespace goya {
+
+namespace detail {
+
+static auto constexpr kKeyTag = std::uint8_t(0U);
+static auto constexpr kCursorTag = std::uint8_t(1U);
+
+// unsigned integer holding the bits of T, floats are written through it so
+// the log is little endian whatever the host
+template <class T>
+using BitsOf = std::conditional_t<
+    sizeof(T) == 1U, std::uint8_t,
+    std::conditional_t<sizeof(T) == 4U, std::uint32_t, std::uint64_t>>;
+
+template <class T>
+auto Append(std::vector<char>& dst, T const value) -> void {
+  static_assert(sizeof(T) == sizeof(BitsOf<T>), "unsupported value size");
+
+  auto bits = BitsOf<T>();
+  std::memcpy(&bits, &value, sizeof(T));
+  for (auto i = std::size_t(0U); i < sizeof(T); ++i) {
+    dst.push_back(static_cast<char>(bits & 0xFFU));
+    bits = static_cast<BitsOf<T>>(bits >> 8U);
+  }
+}
+
+auto AppendVarint(std::vector<char>& dst, std::uint32_t value) -> void {
+  while (value >= 0x80U) {
+    dst.push_back(static_cast<char>((value & 0x7FU) | 0x80U));
+    value >>= 7U;
+  }
+
+  dst.push_back(static_cast<char>(value));
+}
+
+// small negative keys, like GLFW_KEY_UNKNOWN, stay one byte
+auto ZigZag(std::int32_t const value) -> std::uint32_t {
+  return (static_cast<std::uint32_t>(value) << 1U) ^
+         static_cast<std::uint32_t>(value >> 31);
+}
+
+auto UnZigZag(std::uint32_t const value) -> std::int32_t {
+  return static_cast<std::int32_t>(value >> 1U) ^
+         -static_cast<std::int32_t>(value & 1U);
+}
+
+auto Truncated(std::string const& path) -> std::runtime_error {
+  return std::runtime_error("[goya::InputReplay] truncated input log " + path);
+}
+
+template <class T>
+auto Read(std::ifstream& ifstrm, std::string const& path) -> T {
+  static_assert(sizeof(T) == sizeof(BitsOf<T>), "unsupported value size");
+
+  auto bytes = std::array<unsigned char, sizeof(T)>();
+  if (!ifstrm.read(reinterpret_cast<char*>(bytes.data()), sizeof(T))) {
+    throw Truncated(path);
+  }
+
+  auto bits = BitsOf<T>();
+  for (auto i = sizeof(T); i > 0U; --i) {
+    bits = static_cast<BitsOf<T>>((bits << 8U) | bytes[i - 1U]);
+  }
+
+  auto value = T();
+  std::memcpy(&value, &bits, sizeof(T));
+  return value;
+}
+
+auto ReadVarint(std::ifstream& ifstrm, std::string const& path)
+    -> std::uint32_t {
+  auto value = std::uint32_t(0U);
+  for (auto shift = 0U; shift < 32U; shift += 7U) {
+    auto const byte = Read<std::uint8_t>(ifstrm, path);
+    value |= static_cast<std::uint32_t>(byte & 0x7FU) << shift;
+    if ((byte & 0x80U) == 0U) {
+      return value;
+    }
+  }
+
+  throw std::runtime_error("[goya::InputReplay] bad varint in " + path);
+}
+
+}  // namespace detail
+
+InputRecorder::InputRecorder(std::string const& path,
+                             std::vector<std::uint64_t> seeds)
+    : path_(path),
+      ofstrm_(path, std::ios::binary),
+      seeds_(std::move(seeds)) {
+  if (!ofstrm_.is_open()) {
+    throw std::runtime_error("[goya::InputRecorder] failed to open " + path);
+  }
+}
+
+auto InputRecorder::Begin(double const cursor_x, double const cursor_y)
+    -> void {
+  auto header = std::vector<char>(std::begin(kMagic), std::end(kMagic));
+  detail::Append(header, static_cast<std::uint32_t>(seeds_.size()));
+  for (auto const seed : seeds_) {
+    detail::Append(header, seed);
+  }
+  detail::Append(header, cursor_x);
+  detail::Append(header, cursor_y);
+
+  ofstrm_.write(header.data(), static_cast<std::streamsize>(header.size()));
+}
+
+auto InputRecorder::Record(InputEvent const& event) -> void {
+  if (event.type == InputEventType::kKey) {
+    detail::Append(events_, detail::kKeyTag);
+    detail::AppendVarint(events_, detail::ZigZag(event.key));
+    detail::Append(events_, static_cast<std::uint8_t>(event.action));
+  } else {
+    detail::Append(events_, detail::kCursorTag);
+    detail::Append(events_, event.x_pos);
+    detail::Append(events_, event.y_pos);
+  }
+
+  ++n_events_;
+}
+
+auto InputRecorder::EndFrame(TimeType const frame_delta,
+                             TimeType const poll_delta) -> void {
+  header_.clear();
+  detail::Append(header_, frame_delta);
+  detail::Append(header_, poll_delta);
+  detail::AppendVarint(header_, n_events_);
+
+  ofstrm_.write(header_.data(), static_cast<std::streamsize>(header_.size()));
+  ofstrm_.write(events_.data(), static_cast<std::streamsize>(events_.size()));
+  if (!ofstrm_) {
+    throw std::runtime_error("[goya::InputRecorder] failed to write " + path_);
+  }
+
+  events_.clear();
+  n_events_ = 0U;
+  ++n_frames_;
+}
+
+auto InputRecorder::Frames() const noexcept -> std::uint64_t {
+  return n_frames_;
+}
+
+InputReplay::InputReplay(std::string const& path)
+    : path_(path), ifstrm_(path, std::ios::binary) {
+  if (!ifstrm_.is_open()) {
+    throw std::runtime_error("[goya::InputReplay] failed to open " + path);
+  }
+
+  auto magic = std::array<char, sizeof(InputRecorder::kMagic)>();
+  if (!ifstrm_.read(magic.data(), magic.size()) ||
+      std::memcmp(magic.data(), InputRecorder::kMagic, magic.size()) != 0) {
+    throw std::runtime_error("[goya::InputReplay] not an input log " + path);
+  }
+
+  seeds_.resize(detail::Read<std::uint32_t>(ifstrm_, path));
+  for (auto& seed : seeds_) {
+    seed = detail::Read<std::uint64_t>(ifstrm_, path);
+  }
+
+  cursor_x_ = detail::Read<double>(ifstrm_, path);
+  cursor_y_ = detail::Read<double>(ifstrm_, path);
+}
+
+auto InputReplay::Seeds() const noexcept -> std::vector<std::uint64_t> const& {
+  return seeds_;
+}
+
+auto InputReplay::CursorStart() const noexcept -> std::pair<double, double> {
+  return {cursor_x_, cursor_y_};
+}
+
+auto InputReplay::Next(InputLogFrame& dst) -> bool {
+  // a clean end of the log is right before a frame
+  if (ifstrm_.peek() == std::ifstream::traits_type::eof()) {
+    return false;
+  }
+
+  dst.frame_delta = detail::Read<TimeType>(ifstrm_, path_);
+  dst.poll_delta = detail::Read<TimeType>(ifstrm_, path_);
+
+  dst.events.resize(detail::ReadVarint(ifstrm_, path_));
+  for (auto& event : dst.events) {
+    event = InputEvent();
+
+    auto const tag = detail::Read<std::uint8_t>(ifstrm_, path_);
+    if (tag == detail::kKeyTag) {
+      event.type = InputEventType::kKey;
+      event.key = detail::UnZigZag(detail::ReadVarint(ifstrm_, path_));
+      event.action = detail::Read<std::uint8_t>(ifstrm_, path_);
+    } else if (tag == detail::kCursorTag) {
+      event.type = InputEventType::kCursor;
+      event.x_pos = detail::Read<double>(ifstrm_, path_);
+      event.y_pos = detail::Read<double>(ifstrm_, path_);
+    } else {
+      throw std::runtime_error("[goya::InputReplay] bad event in " + path_);
+    }
+  }
+
+  ++n_frames_;
+  duration_ += static_cast<double>(dst.frame_delta);
+  return true;
+}
+
+auto InputReplay::Frames() const noexcept -> std::uint64_t {
+  return n_frames_;
+}
+
+auto InputReplay::Duration() const noexcept -> double { return duration_; }
+
+}  // namespace goya
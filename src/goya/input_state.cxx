@@ -0,0 +1,87 @@
+#include "goya/input_state.hpp"
+
+#include "GLFW/glfw3.h"
+
+namespace goya {
+
+namespace detail {
+
+auto KeyBit(std::int32_t const key) noexcept -> bool {
+  return key >= 0 && static_cast<std::size_t>(key) < InputState::kKeyCount;
+}
+
+}  // namespace detail
+
+auto InputState::BeginFrame() noexcept -> void {
+  pressed_.reset();
+  released_.reset();
+  dx_ = 0.0;
+  dy_ = 0.0;
+  n_events_ = 0U;
+}
+
+auto InputState::Reset() noexcept -> void { *this = InputState(); }
+
+auto InputState::Apply(InputEvent const& event) noexcept -> void {
+  ++n_events_;
+
+  if (event.type == InputEventType::kCursor) {
+    if (has_cursor_) {
+      dx_ += event.x_pos - x_pos_;
+      dy_ += event.y_pos - y_pos_;
+    }
+
+    x_pos_ = event.x_pos;
+    y_pos_ = event.y_pos;
+    has_cursor_ = true;
+    return;
+  }
+
+  // repeats only say the key is still held
+  if (!detail::KeyBit(event.key) || event.action == GLFW_REPEAT) {
+    return;
+  }
+
+  auto const key = static_cast<std::size_t>(event.key);
+  if (event.action == GLFW_PRESS) {
+    pressed_.set(key, !down_.test(key) || pressed_.test(key));
+    down_.set(key);
+  } else if (event.action == GLFW_RELEASE) {
+    released_.set(key, down_.test(key) || released_.test(key));
+    down_.reset(key);
+  }
+}
+
+auto InputState::Drain(InputQueue& queue) noexcept -> void {
+  auto event = InputEvent();
+  while (queue.TryPop(event)) {
+    Apply(event);
+  }
+}
+
+auto InputState::IsDown(std::int32_t key) const noexcept -> bool {
+  return detail::KeyBit(key) && down_.test(static_cast<std::size_t>(key));
+}
+
+auto InputState::WasPressed(std::int32_t key) const noexcept -> bool {
+  return detail::KeyBit(key) && pressed_.test(static_cast<std::size_t>(key));
+}
+
+auto InputState::WasReleased(std::int32_t key) const noexcept -> bool {
+  return detail::KeyBit(key) && released_.test(static_cast<std::size_t>(key));
+}
+
+auto InputState::CursorDelta() const noexcept -> std::pair<double, double> {
+  return {dx_, dy_};
+}
+
+auto InputState::CursorPosition() const noexcept
+    -> std::pair<double, double> {
+  return {x_pos_, y_pos_};
+}
+
+auto InputState::EventCount() const noexcept -> std::uint32_t {
+  return n_events_;
+}
+
+}  // namespace goya
@@ -0,0 +1,199 @@
+#include "goya/instanced_model.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <stdexcept>
+
+#include "GL/glew.h"
+#include "goya/gl_state.hpp"
+#include "goya/render_queue.hpp"
+
+namespace goya {
+
+namespace detail {
+
+auto constexpr kInstanceBlockSize = std::size_t(256);
+
+auto constexpr kModelAttribLoc = 1U;
+auto constexpr kColorAttribLoc = 5U;
+
+auto AttribOffset(std::size_t const offset) -> void const* {
+  return reinterpret_cast<void const*>(offset);
+}
+
+}  // namespace detail
+
+InstancedModel::InstancedModel(std::shared_ptr<Shader> shader,
+                               std::shared_ptr<MeshTriangle> mesh)
+    : shader_(std::move(shader)),
+      mesh_(std::move(mesh)),
+      any_dirty_(false),
+      gpu_capacity_(0U) {
+  glGenVertexArrays(1, &vao_);
+  glGenBuffers(1, &vbo_instances_);
+
+  GlState().BindVertexArray(vao_);
+
+  GlState().BindBuffer(GL_ARRAY_BUFFER, mesh_->VertexBuffer());
+  glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex3d), nullptr);
+  glEnableVertexAttribArray(0);
+
+  GlState().BindBuffer(GL_ARRAY_BUFFER, vbo_instances_);
+  for (auto col = 0U; col < 4U; ++col) {
+    auto const loc = detail::kModelAttribLoc + col;
+    glVertexAttribPointer(
+        loc, 4, GL_FLOAT, GL_FALSE, sizeof(InstanceData),
+        detail::AttribOffset(offsetof(InstanceData, model) +
+                             col * sizeof(glm::vec4)));
+    glEnableVertexAttribArray(loc);
+    glVertexAttribDivisor(loc, 1);
+  }
+
+  glVertexAttribPointer(detail::kColorAttribLoc, 3, GL_FLOAT, GL_FALSE,
+                        sizeof(InstanceData),
+                        detail::AttribOffset(offsetof(InstanceData, color)));
+  glEnableVertexAttribArray(detail::kColorAttribLoc);
+  glVertexAttribDivisor(detail::kColorAttribLoc, 1);
+
+  GlState().BindVertexArray(0);
+}
+
+InstancedModel::~InstancedModel() {
+  GlState().DeleteVertexArray(vao_);
+  GlState().DeleteBuffer(vbo_instances_);
+}
+
+auto InstancedModel::AddInstance(glm::mat4 const& model, glm::vec3 color)
+    -> std::size_t {
+  auto const idx = instances_.size();
+  instances_.push_back(InstanceData{model, color});
+  MarkDirty(idx, 1U);
+
+  return idx;
+}
+
+auto InstancedModel::Resize(std::size_t const n_instances) -> void {
+  auto const prev_size = instances_.size();
+  instances_.resize(n_instances,
+                    InstanceData{glm::mat4(1.f), glm::vec3(0.88f)});
+  if (n_instances > prev_size) {
+    MarkDirty(prev_size, n_instances - prev_size);
+  }
+}
+
+auto InstancedModel::Size() const noexcept -> std::size_t {
+  return instances_.size();
+}
+
+auto InstancedModel::SetModelMatrix(std::size_t const idx,
+                                    glm::mat4 const& model) -> void {
+  instances_[idx].model = model;
+  MarkDirty(idx, 1U);
+}
+
+auto InstancedModel::SetColor(std::size_t const idx, glm::vec3 const color)
+    -> void {
+  instances_[idx].color = color;
+  MarkDirty(idx, 1U);
+}
+
+auto InstancedModel::MapInstances(std::size_t const first,
+                                  std::size_t const count) -> InstanceData* {
+  if (first + count > instances_.size()) {
+    throw std::out_of_range(
+        "[goya::InstancedModel] mapped range exceeds instance count");
+  }
+
+  MarkDirty(first, count);
+  return instances_.data() + first;
+}
+
+auto InstancedModel::Draw() -> void {
+  if (instances_.empty()) {
+    return;
+  }
+
+  Upload();
+
+  GlState().SetDepthTest(true);
+  GlState().SetBlend(false);
+
+  shader_->Use();
+  GlState().BindVertexArray(vao_);
+  glDrawArraysInstanced(GL_TRIANGLES, 0,
+                        static_cast<GLsizei>(mesh_->VertexCount()),
+                        static_cast<GLsizei>(instances_.size()));
+}
+
+auto InstancedModel::Submit(RenderQueue& queue) -> void {
+  queue.Push(MakeDrawKey(RenderPass::kOpaque, shader_->Id(), vao_, 0.f), this);
+}
+
+auto InstancedModel::MarkDirty(std::size_t const first,
+                               std::size_t const count) -> void {
+  if (count == 0U) {
+    return;
+  }
+
+  auto const n_blocks =
+      (instances_.size() + detail::kInstanceBlockSize - 1U) /
+      detail::kInstanceBlockSize;
+  dirty_blocks_.resize(n_blocks, 0U);
+
+  auto const first_block = first / detail::kInstanceBlockSize;
+  auto const last_block = (first + count - 1U) / detail::kInstanceBlockSize;
+  std::fill(dirty_blocks_.begin() + static_cast<std::ptrdiff_t>(first_block),
+            dirty_blocks_.begin() + static_cast<std::ptrdiff_t>(last_block) + 1,
+            std::uint8_t(1));
+
+  any_dirty_ = true;
+}
+
+auto InstancedModel::Upload() -> void {
+  if (!any_dirty_) {
+    return;
+  }
+
+  auto const n_blocks =
+      (instances_.size() + detail::kInstanceBlockSize - 1U) /
+      detail::kInstanceBlockSize;
+  dirty_blocks_.resize(n_blocks);
+
+  GlState().BindBuffer(GL_ARRAY_BUFFER, vbo_instances_);
+  if (instances_.size() > gpu_capacity_) {
+    gpu_capacity_ = instances_.capacity();
+    glBufferData(
+        GL_ARRAY_BUFFER,
+        static_cast<GLsizeiptr>(gpu_capacity_ * sizeof(InstanceData)),
+        nullptr, GL_DYNAMIC_DRAW);
+    std::fill(dirty_blocks_.begin(), dirty_blocks_.end(), std::uint8_t(1));
+  }
+
+  // upload runs of consecutive dirty blocks with one call each
+  for (auto block = std::size_t(0); block < dirty_blocks_.size();) {
+    if (!dirty_blocks_[block]) {
+      ++block;
+      continue;
+    }
+
+    auto run_end = block;
+    while (run_end < dirty_blocks_.size() && dirty_blocks_[run_end]) {
+      dirty_blocks_[run_end++] = 0U;
+    }
+
+    auto const first = block * detail::kInstanceBlockSize;
+    auto const last =
+        std::min(run_end * detail::kInstanceBlockSize, instances_.size());
+    glBufferSubData(GL_ARRAY_BUFFER,
+                    static_cast<GLintptr>(first * sizeof(InstanceData)),
+                    static_cast<GLsizeiptr>((last - first) *
+                                            sizeof(InstanceData)),
+                    instances_.data() + first);
+
+    block = run_end;
+  }
+
+  any_dirty_ = false;
+}
+
+}  // namespace goya
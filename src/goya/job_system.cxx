@@ -0,0 +1,485 @@
+#include "goya/job_system.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+#include "goya/alloc_tracker.hpp"
+#include "goya/profiler.hpp"
+
+namespace goya {
+
+namespace detail {
+
+using JobClock = std::chrono::steady_clock;
+
+static auto constexpr kDequeCapacity = std::size_t(4096U);
+static auto constexpr kJobCacheSize = std::size_t(128U);
+static auto constexpr kJobBatch = std::size_t(64U);
+static auto constexpr kSpinsBeforeSleep = 64;
+
+// index of the worker the current thread is, or kNotAWorker
+static auto constexpr kNotAWorker = ~std::size_t(0U);
+thread_local std::size_t tls_worker_idx = kNotAWorker;
+thread_local JobSystem const* tls_job_system = nullptr;
+
+// cheap xorshift for picking steal victims
+thread_local std::uint32_t tls_steal_seed = 0x9E3779B9U;
+
+auto NextVictim(std::size_t const n) -> std::size_t {
+  tls_steal_seed ^= tls_steal_seed << 13U;
+  tls_steal_seed ^= tls_steal_seed >> 17U;
+  tls_steal_seed ^= tls_steal_seed << 5U;
+  return tls_steal_seed % n;
+}
+
+auto NextPowerOfTwo(std::size_t const val) -> std::size_t {
+  auto dst = std::size_t(1U);
+  while (dst < val) {
+    dst <<= 1U;
+  }
+
+  return dst;
+}
+
+}  // namespace detail
+
+auto TaskGroup::Done() const noexcept -> bool {
+  return pending_.load(std::memory_order_acquire) == 0U;
+}
+
+auto TaskGroup::Fail(std::exception_ptr error) -> void {
+  auto lock = std::lock_guard(error_mtx_);
+  if (!error_) {
+    error_ = std::move(error);
+  }
+}
+
+// Chase-Lev deque with the C11 orderings from Le et al. 2013, the buffer has a
+// fixed size and a full deque makes the owner run the job inline instead.
+JobSystem::WorkStealingDeque::WorkStealingDeque(std::size_t const capacity)
+    : mask_(static_cast<std::int64_t>(detail::NextPowerOfTwo(capacity)) - 1),
+      buffer_(std::make_unique<std::atomic<Job*>[]>(
+          static_cast<std::size_t>(mask_ + 1))),
+      top_(0),
+      bottom_(0) {}
+
+auto JobSystem::WorkStealingDeque::Push(Job* job) noexcept -> bool {
+  auto const b = bottom_.load(std::memory_order_relaxed);
+  auto const t = top_.load(std::memory_order_acquire);
+  if (b - t > mask_) {
+    return false;
+  }
+
+  buffer_[static_cast<std::size_t>(b & mask_)].store(
+      job, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+  bottom_.store(b + 1, std::memory_order_relaxed);
+
+  return true;
+}
+
+auto JobSystem::WorkStealingDeque::Pop() noexcept -> Job* {
+  auto const b = bottom_.load(std::memory_order_relaxed) - 1;
+  bottom_.store(b, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  auto t = top_.load(std::memory_order_relaxed);
+
+  if (t > b) {
+    bottom_.store(b + 1, std::memory_order_relaxed);
+    return nullptr;
+  }
+
+  auto job = buffer_[static_cast<std::size_t>(b & mask_)].load(
+      std::memory_order_relaxed);
+  if (t == b) {
+    // last element, race against thieves
+    if (!top_.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst,
+                                      std::memory_order_relaxed)) {
+      job = nullptr;
+    }
+
+    bottom_.store(b + 1, std::memory_order_relaxed);
+  }
+
+  return job;
+}
+
+auto JobSystem::WorkStealingDeque::Steal() noexcept -> Job* {
+  auto t = top_.load(std::memory_order_acquire);
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  auto const b = bottom_.load(std::memory_order_acquire);
+
+  if (t >= b) {
+    return nullptr;
+  }
+
+  auto job = buffer_[static_cast<std::size_t>(t & mask_)].load(
+      std::memory_order_relaxed);
+  if (!top_.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst,
+                                    std::memory_order_relaxed)) {
+    return nullptr;
+  }
+
+  return job;
+}
+
+JobSystem::JobSystem(std::size_t n_workers)
+    : injection_head_(0U), queued_(0U), sleeping_(0U), stop_(false) {
+  if (n_workers == 0U) {
+    auto const hw =
+        static_cast<std::size_t>(std::thread::hardware_concurrency());
+    n_workers = std::max(hw, std::size_t(2U)) - 1U;
+  }
+
+  workers_.reserve(n_workers);
+  for (auto i = std::size_t(0U); i < n_workers; ++i) {
+    workers_.push_back(std::make_unique<Worker>(detail::kDequeCapacity));
+  }
+
+  // deques have to exist before any worker starts stealing
+  for (auto i = std::size_t(0U); i < n_workers; ++i) {
+    workers_[i]->thread = std::thread(&JobSystem::WorkerLoop, this, i);
+  }
+}
+
+JobSystem::~JobSystem() {
+  {
+    auto lock = std::lock_guard(sleep_mtx_);
+    stop_.store(true);
+  }
+
+  sleep_cv_.notify_all();
+  for (auto& worker : workers_) {
+    worker->thread.join();
+  }
+
+  for (auto i = injection_head_; i < injection_.size(); ++i) {
+    RecycleJob(injection_[i]);
+  }
+}
+
+auto JobSystem::Spawn(TaskGroup& group, std::function<void()> fn) -> void {
+  auto job = AllocateJob();
+  job->fn = std::move(fn);
+  job->group = &group;
+
+  group.pending_.fetch_add(1U, std::memory_order_relaxed);
+  Enqueue(job);
+}
+
+auto JobSystem::Wait(TaskGroup& group) -> void {
+  auto const self = detail::tls_job_system == this ? detail::tls_worker_idx
+                                                   : detail::kNotAWorker;
+
+  // help instead of blocking, waiting inside a job must not deadlock
+  while (!group.Done()) {
+    if (auto job = FindJob(self); job) {
+      Execute(job, self);
+    } else {
+      std::this_thread::yield();
+    }
+  }
+
+  if (group.error_) {
+    std::rethrow_exception(std::exchange(group.error_, nullptr));
+  }
+}
+
+auto JobSystem::ParallelFor(
+    std::size_t const begin, std::size_t const end, std::size_t grain,
+    std::function<void(std::size_t, std::size_t)> const& fn) -> void {
+  if (begin >= end) {
+    return;
+  }
+
+  grain = std::max(grain, std::size_t(1U));
+  if (end - begin <= grain) {
+    fn(begin, end);
+    return;
+  }
+
+  struct Range {
+    std::size_t begin;
+    std::size_t end;
+    std::size_t grain;
+    std::function<void(std::size_t, std::size_t)> const* fn;
+  };
+
+  auto const range = Range{begin, end, grain, &fn};
+  auto const n_chunks = (end - begin + grain - 1U) / grain;
+
+  // captures stay within the small buffer of std::function, the calling
+  // thread picks up chunks itself while waiting
+  auto group = TaskGroup();
+  for (auto chunk = std::size_t(0U); chunk < n_chunks; ++chunk) {
+    Spawn(group, [r = &range, chunk]() -> void {
+      auto const first = r->begin + chunk * r->grain;
+      (*r->fn)(first, std::min(first + r->grain, r->end));
+    });
+  }
+
+  Wait(group);
+}
+
+auto JobSystem::WorkerCount() const noexcept -> std::size_t {
+  return workers_.size();
+}
+
+auto JobSystem::Stats() const -> std::vector<WorkerStats> {
+  auto dst = std::vector<WorkerStats>();
+  dst.reserve(workers_.size());
+  for (auto const& worker : workers_) {
+    auto& stats = dst.emplace_back();
+    stats.jobs_executed = worker->jobs_executed.load(std::memory_order_relaxed);
+    stats.steals = worker->steals.load(std::memory_order_relaxed);
+    stats.busy_seconds =
+        static_cast<double>(worker->busy_ns.load(std::memory_order_relaxed)) *
+        1e-9;
+  }
+
+  return dst;
+}
+
+auto JobSystem::ResetStats() -> void {
+  for (auto& worker : workers_) {
+    worker->jobs_executed.store(0U, std::memory_order_relaxed);
+    worker->steals.store(0U, std::memory_order_relaxed);
+    worker->busy_ns.store(0U, std::memory_order_relaxed);
+  }
+}
+
+auto JobSystem::WorkerLoop(std::size_t const idx) -> void {
+  detail::tls_worker_idx = idx;
+  detail::tls_job_system = this;
+  detail::tls_steal_seed ^= static_cast<std::uint32_t>(idx + 1U) * 0x85EBCA6BU;
+  GOYA_PROFILE_THREAD_NAME("worker " + std::to_string(idx));
+
+  auto spins = 0;
+  while (!stop_.load(std::memory_order_relaxed)) {
+    if (auto job = FindJob(idx); job) {
+      Execute(job, idx);
+      spins = 0;
+      continue;
+    }
+
+    if (++spins < detail::kSpinsBeforeSleep) {
+      std::this_thread::yield();
+      continue;
+    }
+
+    // announce before checking so a concurrent Enqueue either sees the
+    // sleeper or this thread sees the queued job
+    auto lock = std::unique_lock(sleep_mtx_);
+    sleeping_.fetch_add(1U);
+    sleep_cv_.wait(lock, [this]() -> bool {
+      return stop_.load() || queued_.load() > 0U;
+    });
+    sleeping_.fetch_sub(1U);
+    spins = 0;
+  }
+}
+
+auto JobSystem::FindJob(std::size_t const self) -> Job* {
+  if (queued_.load(std::memory_order_relaxed) == 0U) {
+    return nullptr;
+  }
+
+  auto job = static_cast<Job*>(nullptr);
+  if (self != detail::kNotAWorker) {
+    job = workers_[self]->deque.Pop();
+  }
+
+  if (!job) {
+    auto lock = std::lock_guard(injection_mtx_);
+    if (injection_head_ < injection_.size()) {
+      job = injection_[injection_head_++];
+      if (injection_head_ == injection_.size()) {
+        injection_.clear();
+        injection_head_ = 0U;
+      }
+    }
+  }
+
+  if (!job && !workers_.empty()) {
+    auto const first = detail::NextVictim(workers_.size());
+    for (auto i = std::size_t(0U); i < workers_.size() && !job; ++i) {
+      auto const victim = (first + i) % workers_.size();
+      if (victim != self) {
+        job = workers_[victim]->deque.Steal();
+      }
+    }
+
+    if (job && self != detail::kNotAWorker) {
+      workers_[self]->steals.fetch_add(1U, std::memory_order_relaxed);
+    }
+  }
+
+  if (job) {
+    queued_.fetch_sub(1U);
+  }
+
+  return job;
+}
+
+auto JobSystem::Execute(Job* job, std::size_t const self) -> void {
+  auto const start = detail::JobClock::now();
+
+  auto group = job->group;
+  try {
+    GOYA_PROFILE_ZONE("JobSystem::Execute");
+    job->fn();
+  } catch (...) {
+    group->Fail(std::current_exception());
+  }
+
+  RecycleJob(job);
+
+  if (self != detail::kNotAWorker) {
+    auto const busy = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        detail::JobClock::now() - start);
+    auto& worker = *workers_[self];
+    worker.jobs_executed.fetch_add(1U, std::memory_order_relaxed);
+    worker.busy_ns.fetch_add(static_cast<std::uint64_t>(busy.count()),
+                             std::memory_order_relaxed);
+  }
+
+  // last, the group may be destroyed as soon as it reads zero
+  group->pending_.fetch_sub(1U, std::memory_order_release);
+}
+
+auto JobSystem::Enqueue(Job* job) -> void {
+  queued_.fetch_add(1U);
+
+  auto const self = detail::tls_job_system == this ? detail::tls_worker_idx
+                                                   : detail::kNotAWorker;
+  if (self != detail::kNotAWorker) {
+    if (!workers_[self]->deque.Push(job)) {
+      queued_.fetch_sub(1U);
+      Execute(job, self);
+      return;
+    }
+  } else if (workers_.empty()) {
+    queued_.fetch_sub(1U);
+    Execute(job, self);
+    return;
+  } else {
+    auto lock = std::lock_guard(injection_mtx_);
+    injection_.push_back(job);
+  }
+
+  if (sleeping_.load() > 0U) {
+    { auto lock = std::lock_guard(sleep_mtx_); }
+    sleep_cv_.notify_one();
+  }
+}
+
+// Jobs are recycled through a per thread cache. A job freed on another thread
+// than it was allocated on migrates to that thread's cache, full caches spill
+// batches into the shared pool so a thread that only spawns, e.g. the render
+// thread, stops allocating once the pool is warm.
+auto JobSystem::JobCache() -> std::vector<std::unique_ptr<Job>>& {
+  thread_local auto cache = [] {
+    auto dst = std::vector<std::unique_ptr<Job>>();
+    dst.reserve(detail::kJobCacheSize);
+    return dst;
+  }();
+  return cache;
+}
+
+auto JobSystem::AllocateJob() -> Job* {
+  auto& cache = JobCache();
+  if (cache.empty()) {
+    auto lock = std::lock_guard(job_pool_mtx_);
+    auto const n_jobs = std::min(job_pool_.size(), detail::kJobBatch);
+    std::move(job_pool_.end() - static_cast<std::ptrdiff_t>(n_jobs),
+              job_pool_.end(), std::back_inserter(cache));
+    job_pool_.resize(job_pool_.size() - n_jobs);
+  }
+
+  if (cache.empty()) {
+    auto const alloc_scope = AllocScope(AllocSubsystem::kJobs);
+    return new Job();
+  }
+
+  auto job = cache.back().release();
+  cache.pop_back();
+  return job;
+}
+
+auto JobSystem::RecycleJob(Job* job) -> void {
+  job->fn = nullptr;
+  job->group = nullptr;
+
+  auto& cache = JobCache();
+  if (cache.size() >= detail::kJobCacheSize) {
+    auto lock = std::lock_guard(job_pool_mtx_);
+    std::move(cache.end() - static_cast<std::ptrdiff_t>(detail::kJobBatch),
+              cache.end(), std::back_inserter(job_pool_));
+    cache.resize(cache.size() - detail::kJobBatch);
+  }
+
+  cache.emplace_back(job);
+}
+
+auto TaskGraph::Add(std::function<void()> fn,
+                    std::vector<NodeId> const& deps) -> NodeId {
+  auto const id = static_cast<NodeId>(nodes_.size());
+  for (auto const dep : deps) {
+    if (dep >= id) {
+      throw std::invalid_argument(
+          "[goya::TaskGraph::Add] dependency on an unknown node");
+    }
+  }
+
+  auto& node = nodes_.emplace_back();
+  node.fn = std::move(fn);
+  node.n_deps = static_cast<std::uint32_t>(deps.size());
+  for (auto const dep : deps) {
+    nodes_[dep].successors.push_back(id);
+  }
+
+  return id;
+}
+
+auto TaskGraph::Size() const noexcept -> std::size_t { return nodes_.size(); }
+
+auto TaskGraph::Run(JobSystem& jobs) -> void {
+  auto group = TaskGroup();
+  run_jobs_ = &jobs;
+  run_group_ = &group;
+
+  for (auto& node : nodes_) {
+    node.remaining.store(node.n_deps, std::memory_order_relaxed);
+  }
+
+  for (auto id = NodeId(0U); id < nodes_.size(); ++id) {
+    if (nodes_[id].n_deps == 0U) {
+      SpawnNode(id);
+    }
+  }
+
+  jobs.Wait(group);
+  run_jobs_ = nullptr;
+  run_group_ = nullptr;
+}
+
+auto TaskGraph::SpawnNode(NodeId const id) -> void {
+  // successors are spawned before this job retires, so the group never
+  // drops to zero while work is still reachable
+  run_jobs_->Spawn(*run_group_, [this, id]() -> void {
+    auto& node = nodes_[id];
+    node.fn();
+    for (auto const succ : node.successors) {
+      if (nodes_[succ].remaining.fetch_sub(1U, std::memory_order_acq_rel) ==
+          1U) {
+        SpawnNode(succ);
+      }
+    }
+  });
+}
+
+}  // namespace goya
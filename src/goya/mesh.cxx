@@ -1,8 +1,12 @@
 #include "goya/mesh.hpp"
 
+#include <algorithm>
 #include <iostream>
+#include <stdexcept>
 
 #include "GL/glew.h"
+#include "goya/gl_state.hpp"
+#include "goya/render_queue.hpp"
 
 namespace goya {
 
@@ -18,19 +22,34 @@ auto TransformObjToVertices(MeshObjData const& obj) -> std::vector<Vertex3d> {
   }
 
   return dst;
-};
+}
+
+auto BoundsOf(Vertex3d const* points, std::size_t count) -> Aabb {
+  auto dst = Aabb();
+  for (auto i = std::size_t(0U); i < count; ++i) {
+    dst.lo = glm::min(dst.lo, points[i]);
+    dst.hi = glm::max(dst.hi, points[i]);
+  }
+
+  return dst;
+}
 
 }  // namespace detail
 
+auto IMesh::Submit(RenderQueue& queue) -> void {
+  queue.Push(MakeDrawKey(RenderPass::kOpaque, 0U, VertexArray(), 0.f), this);
+}
+
 MeshTriangle::MeshTriangle(MeshObjData obj_data) {
   auto const vertices = detail::TransformObjToVertices(obj_data);
   n_vertices_ = vertices.size();
+  bounds_ = BoundsOf(vertices);
 
   glGenVertexArrays(1, &vao_);
   glGenBuffers(1, &vbo_);
 
-  glBindVertexArray(vao_);
-  glBindBuffer(GL_ARRAY_BUFFER, vbo_);
+  GlState().BindVertexArray(vao_);
+  GlState().BindBuffer(GL_ARRAY_BUFFER, vbo_);
 
   glBufferData(GL_ARRAY_BUFFER,
                static_cast<GLsizei>(sizeof(decltype(vertices)::value_type) *
@@ -42,29 +61,44 @@ MeshTriangle::MeshTriangle(MeshObjData obj_data) {
   glEnableVertexAttribArray(0);
 
   // clean up
-  glBindBuffer(GL_ARRAY_BUFFER, 0);
-  glBindVertexArray(0);
+  GlState().BindBuffer(GL_ARRAY_BUFFER, 0);
+  GlState().BindVertexArray(0);
 }
 
 MeshTriangle::~MeshTriangle() {
-  glDeleteVertexArrays(1, &vao_);
-  glDeleteBuffers(1, &vbo_);
+  GlState().DeleteVertexArray(vao_);
+  GlState().DeleteBuffer(vbo_);
 }
 
 auto MeshTriangle::Draw() -> void {
-  glBindVertexArray(vao_);
+  GlState().BindVertexArray(vao_);
   glDrawArrays(GL_TRIANGLES, 0, static_cast<std::int32_t>(n_vertices_));
-  glBindVertexArray(0);
+}
+
+auto MeshTriangle::VertexArray() const noexcept -> std::uint32_t {
+  return vao_;
+}
+
+auto MeshTriangle::Bounds() const noexcept -> Aabb { return bounds_; }
+
+auto MeshTriangle::VertexBuffer() const noexcept -> std::uint32_t {
+  return vbo_;
+}
+
+auto MeshTriangle::VertexCount() const noexcept -> std::size_t {
+  return n_vertices_;
 }
 
 MeshLines::MeshLines(std::vector<Vertex3d> const& points) {
   n_points_ = points.size();
+  capacity_ = points.size();
+  bounds_ = BoundsOf(points);
 
   glGenVertexArrays(1, &vao_);
   glGenBuffers(1, &vbo_);
 
-  glBindVertexArray(vao_);
-  glBindBuffer(GL_ARRAY_BUFFER, vbo_);
+  GlState().BindVertexArray(vao_);
+  GlState().BindBuffer(GL_ARRAY_BUFFER, vbo_);
 
   glBufferData(
       GL_ARRAY_BUFFER,
@@ -77,19 +111,208 @@ MeshLines::MeshLines(std::vector<Vertex3d> const& points) {
                         nullptr);
   glEnableVertexAttribArray(0);
 
-  glBindBuffer(GL_ARRAY_BUFFER, 0);
-  glBindVertexArray(0);
+  GlState().BindBuffer(GL_ARRAY_BUFFER, 0);
+  GlState().BindVertexArray(0);
 }
 
 MeshLines::~MeshLines() {
-  glDeleteVertexArrays(1, &vao_);
-  glDeleteBuffers(1, &vbo_);
+  GlState().DeleteVertexArray(vao_);
+  GlState().DeleteBuffer(vbo_);
+}
+
+auto MeshLines::Update(std::vector<Vertex3d> const& points, std::size_t first,
+                       std::size_t last) -> void {
+  n_points_ = points.size();
+  last = std::min(last, points.size());
+
+  GlState().BindBuffer(GL_ARRAY_BUFFER, vbo_);
+  if (points.size() > capacity_) {
+    capacity_ = std::max(points.size(), capacity_ * 2U);
+    glBufferData(GL_ARRAY_BUFFER,
+                 static_cast<GLsizeiptr>(capacity_ * sizeof(Vertex3d)),
+                 nullptr, GL_DYNAMIC_DRAW);
+    first = 0U;
+    last = points.size();
+  }
+
+  if (first >= last) {
+    return;
+  }
+
+  glBufferSubData(GL_ARRAY_BUFFER,
+                  static_cast<GLintptr>(first * sizeof(Vertex3d)),
+                  static_cast<GLsizeiptr>((last - first) * sizeof(Vertex3d)),
+                  points.data() + first);
+
+  // grows only, removed points may leave the box a bit loose
+  bounds_ =
+      Union(bounds_, detail::BoundsOf(points.data() + first, last - first));
 }
 
 auto MeshLines::Draw() -> void {
-  glBindVertexArray(vao_);
+  GlState().BindVertexArray(vao_);
   glDrawArrays(GL_LINE_STRIP, 0, static_cast<std::int32_t>(n_points_));
-  glBindVertexArray(0);
+}
+
+auto MeshLines::VertexArray() const noexcept -> std::uint32_t { return vao_; }
+
+auto MeshLines::Bounds() const noexcept -> Aabb { return bounds_; }
+
+MeshLineSlots::MeshLineSlots(std::size_t slot_size)
+    : slot_size_(slot_size),
+      capacity_(0U),
+      n_vertices_(0U),
+      draw_dirty_(false) {
+  if (slot_size_ == 0U) {
+    throw std::invalid_argument(
+        "[goya::MeshLineSlots] slots need room for a vertex.");
+  }
+
+  glGenVertexArrays(1, &vao_);
+  glGenBuffers(1, &vbo_);
+
+  GlState().BindVertexArray(vao_);
+  GlState().BindBuffer(GL_ARRAY_BUFFER, vbo_);
+  glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex3d), nullptr);
+  glEnableVertexAttribArray(0);
+
+  GlState().BindBuffer(GL_ARRAY_BUFFER, 0);
+  GlState().BindVertexArray(0);
+}
+
+MeshLineSlots::~MeshLineSlots() {
+  GlState().DeleteVertexArray(vao_);
+  GlState().DeleteBuffer(vbo_);
+}
+
+auto MeshLineSlots::Assign(std::vector<Vertex3d> const& points,
+                           std::vector<std::uint32_t> const& counts) -> void {
+  if (points.size() < counts.size() * slot_size_) {
+    throw std::invalid_argument(
+        "[goya::MeshLineSlots] points have to fill every slot.");
+  }
+
+  auto const bytes =
+      static_cast<GLsizeiptr>(counts.size() * slot_size_ * sizeof(Vertex3d));
+  GlState().BindBuffer(GL_ARRAY_BUFFER, vbo_);
+  if (counts.size() > capacity_) {
+    capacity_ = counts.size();
+    glBufferData(GL_ARRAY_BUFFER, bytes, points.data(), GL_DYNAMIC_DRAW);
+  } else if (bytes > 0) {
+    glBufferSubData(GL_ARRAY_BUFFER, 0, bytes, points.data());
+  }
+
+  counts_ = counts;
+  counts_.resize(capacity_, 0U);
+
+  n_vertices_ = 0U;
+  bounds_ = Aabb();
+  for (auto slot = std::size_t(0U); slot < counts.size(); ++slot) {
+    n_vertices_ += counts[slot];
+    bounds_ = Union(bounds_, detail::BoundsOf(points.data() + slot * slot_size_,
+                                              counts[slot]));
+  }
+
+  draw_dirty_ = true;
+}
+
+auto MeshLineSlots::Write(std::uint32_t slot, Vertex3d const* points,
+                          std::size_t count) -> void {
+  if (count > slot_size_) {
+    throw std::invalid_argument(
+        "[goya::MeshLineSlots] strip does not fit into a slot.");
+  }
+
+  Reserve(std::size_t(slot) + 1U);
+
+  if (count > 0U) {
+    GlState().BindBuffer(GL_ARRAY_BUFFER, vbo_);
+    glBufferSubData(GL_ARRAY_BUFFER,
+                    static_cast<GLintptr>(std::size_t(slot) * slot_size_ *
+                                          sizeof(Vertex3d)),
+                    static_cast<GLsizeiptr>(count * sizeof(Vertex3d)), points);
+  }
+
+  n_vertices_ = n_vertices_ - counts_[slot] + count;
+  counts_[slot] = static_cast<std::uint32_t>(count);
+  bounds_ = Union(bounds_, detail::BoundsOf(points, count));
+  draw_dirty_ = true;
+}
+
+auto MeshLineSlots::SetOrder(std::vector<std::uint32_t> const& slots)
+    -> void {
+  order_ = slots;
+  draw_dirty_ = true;
+}
+
+auto MeshLineSlots::SlotSize() const noexcept -> std::size_t {
+  return slot_size_;
+}
+
+auto MeshLineSlots::VertexCount() const noexcept -> std::size_t {
+  return n_vertices_;
+}
+
+auto MeshLineSlots::Draw() -> void {
+  if (draw_dirty_) {
+    draw_firsts_.resize(order_.size());
+    draw_counts_.resize(order_.size());
+    for (auto i = std::size_t(0U); i < order_.size(); ++i) {
+      auto const slot = order_[i];
+      draw_firsts_[i] = static_cast<std::int32_t>(slot * slot_size_);
+      draw_counts_[i] = static_cast<std::int32_t>(
+          slot < counts_.size() ? counts_[slot] : 0U);
+    }
+    draw_dirty_ = false;
+  }
+
+  if (draw_counts_.empty()) {
+    return;
+  }
+
+  GlState().BindVertexArray(vao_);
+  glMultiDrawArrays(GL_LINE_STRIP, draw_firsts_.data(), draw_counts_.data(),
+                    static_cast<GLsizei>(draw_counts_.size()));
+}
+
+auto MeshLineSlots::VertexArray() const noexcept -> std::uint32_t {
+  return vao_;
+}
+
+auto MeshLineSlots::Bounds() const noexcept -> Aabb { return bounds_; }
+
+// the old slots are copied on the gpu into a buffer twice as large, so a
+// run of writes past the end reallocates only a few times
+auto MeshLineSlots::Reserve(std::size_t slots) -> void {
+  if (slots <= capacity_) {
+    return;
+  }
+
+  auto const capacity = std::max(slots, capacity_ * 2U);
+  auto dst_vbo = std::uint32_t();
+  glGenBuffers(1, &dst_vbo);
+  GlState().BindBuffer(GL_COPY_WRITE_BUFFER, dst_vbo);
+  glBufferData(GL_COPY_WRITE_BUFFER,
+               static_cast<GLsizeiptr>(capacity * slot_size_ *
+                                       sizeof(Vertex3d)),
+               nullptr, GL_DYNAMIC_DRAW);
+
+  if (capacity_ > 0U) {
+    GlState().BindBuffer(GL_COPY_READ_BUFFER, vbo_);
+    glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0,
+                        static_cast<GLsizeiptr>(capacity_ * slot_size_ *
+                                                sizeof(Vertex3d)));
+  }
+
+  GlState().DeleteBuffer(vbo_);
+  vbo_ = dst_vbo;
+  capacity_ = capacity;
+  counts_.resize(capacity_, 0U);
+
+  GlState().BindVertexArray(vao_);
+  GlState().BindBuffer(GL_ARRAY_BUFFER, vbo_);
+  glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex3d), nullptr);
+  GlState().BindVertexArray(0);
 }
 
 }  // namespace goya
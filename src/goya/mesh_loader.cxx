@@ -1,9 +1,12 @@
 #include "goya/mesh_loader.hpp"
 
 #include <algorithm>
+#include <charconv>
 #include <fstream>
 #include <limits>
-#include <sstream>
+
+#include "goya/alloc_tracker.hpp"
+#include "goya/profiler.hpp"
 
 namespace goya {
 
@@ -65,6 +68,9 @@ auto LoadMeshObjData(std::string const& path) -> MeshObjData {
 }
 
 auto LoadMeshObjData(char const* path) -> MeshObjData {
+  GOYA_PROFILE_ZONE("LoadMeshObjData");
+  auto const alloc_scope = AllocScope(AllocSubsystem::kMesh);
+
   auto ifstrm = std::ifstream(path);
 
   auto vertices = std::vector<Vertex3d>();
@@ -80,18 +86,28 @@ auto LoadMeshObjData(char const* path) -> MeshObjData {
     return dst;
   };
 
+  // the line buffer is reused, only the face itself allocates
+  auto line = std::string();
   auto const parse_face_line = [&]() -> Face {
-    auto line = std::string();
     std::getline(ifstrm, line);
 
-    auto istrm = std::istringstream(std::move(line));
     auto dst = Face();
 
-    auto index = IndexType();
-    istrm.ignore(std::numeric_limits<std::streamsize>::max(), ' ');
-    while (istrm >> index) {
+    // "f 1 2 3" or "f 1/1/1 2/2/2 3/3/3", only the vertex index is kept
+    auto first = static_cast<char const*>(line.data());
+    auto const last = first + line.size();
+    for (first = std::find(first, last, ' '); first != last;
+         first = std::find(first, last, ' ')) {
+      ++first;
+
+      auto index = IndexType();
+      auto const [ptr, ec] = std::from_chars(first, last, index);
+      if (ec != std::errc()) {
+        continue;
+      }
+
       dst.push_back(index);
-      istrm.ignore(std::numeric_limits<std::streamsize>::max(), ' ');
+      first = ptr;
     }
 
     return dst;
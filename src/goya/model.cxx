@@ -1,34 +1,82 @@
 #include "goya/model.hpp"
 
+#include "goya/gl_state.hpp"
+#include "goya/profiler.hpp"
+#include "goya/render_queue.hpp"
+
 namespace goya {
 
+namespace detail {
+
+// stands in for drawables without bounds so they are never culled
+auto constexpr kUnboundedExtent = 1e18f;
+
+}  // namespace detail
+
 Model::Model(std::shared_ptr<Shader> shader,
              std::shared_ptr<IDrawable> drawable)
-    : shader_(std::move(shader)), drawable_(std::move(drawable)) {}
+    : shader_(std::move(shader)),
+      drawable_(std::move(drawable)),
+      vao_hint_(0U),
+      local_bounds_{glm::vec3(-detail::kUnboundedExtent),
+                    glm::vec3(detail::kUnboundedExtent)} {
+  if (auto const mesh = dynamic_cast<IMesh const*>(drawable_.get())) {
+    vao_hint_ = mesh->VertexArray();
+    local_bounds_ = mesh->Bounds();
+  }
+}
 
 auto Model::Rotate(float const degrees, glm::vec3 const axis) -> void {
   model_matrix_ = glm::rotate(model_matrix_, glm::radians(degrees), axis);
+  ++transform_version_;
 }
 
 auto Model::Translate(glm::vec3 const vec) -> void {
   model_matrix_ = glm::translate(model_matrix_, vec);
+  ++transform_version_;
 }
 
 auto Model::Scale(glm::vec3 const vec) -> void {
   model_matrix_ = glm::scale(model_matrix_, vec);
+  ++transform_version_;
 }
 
 auto Model::SetModelMatrix(glm::mat4 model) -> void {
   model_matrix_ = std::move(model);
+  ++transform_version_;
 }
 
 auto Model::SetColor(glm::vec3 color) -> void { color_ = color; }
 
+auto Model::ModelMatrix() const noexcept -> glm::mat4 const& {
+  return model_matrix_;
+}
+
+auto Model::Bounds() const noexcept -> Aabb {
+  return Transform(local_bounds_, model_matrix_);
+}
+
+auto Model::TransformVersion() const noexcept -> std::uint32_t {
+  return transform_version_;
+}
+
 auto Model::Draw() -> void {
+  GOYA_PROFILE_ZONE("Model::Draw");
+  GOYA_PROFILE_GPU_ZONE("Model::Draw");
+
+  GlState().SetDepthTest(true);
+  GlState().SetBlend(false);
+
   UpdateUniforms();
   drawable_->Draw();
 }
 
+auto Model::Submit(RenderQueue& queue) -> void {
+  auto const depth = queue.Depth(glm::vec3(model_matrix_[3]));
+  queue.Push(MakeDrawKey(RenderPass::kOpaque, shader_->Id(), vao_hint_, depth),
+             this);
+}
+
 auto Model::UpdateUniforms() -> void {
   shader_->Use();
   shader_->SetVec3("color", color_);
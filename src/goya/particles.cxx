@@ -9,8 +9,13 @@
 #include <random>
 #include <stdexcept>
 #include <type_traits>
+#include <utility>
 
 #include "GL/glew.h"
+#include "goya/alloc_tracker.hpp"
+#include "goya/gl_state.hpp"
+#include "goya/profiler.hpp"
+#include "goya/render_queue.hpp"
 
 namespace goya {
 
@@ -25,6 +30,8 @@ auto constexpr kParticleMesh = std::array<float, 12>{
 };
 /* clang-format on */
 
+auto constexpr kParticleGrain = std::size_t(4096U);
+
 }  // namespace detail
 
 ParticleEffect::ParticleEffect(std::shared_ptr<Shader> shader,
@@ -38,106 +45,153 @@ ParticleEffect::ParticleEffect(std::shared_ptr<Shader> shader,
       particles_(size),
       live_particles_end_(particles_.begin()),
       pos_buffer_(),
-      color_buffer_() {
+      color_buffer_(),
+      n_uploaded_(0U),
+      uploaded_anchor_(0.f),
+      scale_matrix_(1.f),
+      scale_dirty_(true),
+      vao_(0U),
+      vbo_vertex_(0U),
+      vbo_pos_(0U),
+      vbo_color_(0U) {
   pos_buffer_.reserve(size);
   color_buffer_.reserve(size);
+}
 
-  glGenVertexArrays(1, &vao_);
-  glBindVertexArray(vao_);
-
-  glGenBuffers(1, &vbo_vertex_);
-  glBindBuffer(GL_ARRAY_BUFFER, vbo_vertex_);
-  glBufferData(GL_ARRAY_BUFFER, sizeof(detail::kParticleMesh),
-               detail::kParticleMesh.data(), GL_STATIC_DRAW);
+ParticleEffect::~ParticleEffect() {
+  if (vao_ == 0U) {
+    return;
+  }
 
-  glGenBuffers(1, &vbo_pos_);
-  glBindBuffer(GL_ARRAY_BUFFER, vbo_pos_);
-  glBufferData(
-      GL_ARRAY_BUFFER,
-      pos_buffer_.capacity() * sizeof(decltype(pos_buffer_)::value_type),
-      nullptr, GL_STREAM_DRAW);
+  GlState().DeleteVertexArray(vao_);
+  GlState().DeleteBuffer(vbo_vertex_);
+  GlState().DeleteBuffer(vbo_pos_);
+  GlState().DeleteBuffer(vbo_color_);
+}
 
-  glGenBuffers(1, &vbo_color_);
-  glBindBuffer(GL_ARRAY_BUFFER, vbo_color_);
-  glBufferData(
-      GL_ARRAY_BUFFER,
-      color_buffer_.capacity() * sizeof(decltype(color_buffer_)::value_type),
-      nullptr, GL_STREAM_DRAW);
+auto ParticleEffect::Update(TimeType const delta) -> void {
+  GOYA_PROFILE_ZONE("ParticleEffect::Update");
+  auto const alloc_scope = AllocScope(AllocSubsystem::kParticles);
 
-  glEnableVertexAttribArray(0);
-  glBindBuffer(GL_ARRAY_BUFFER, vbo_vertex_);
-  glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 0, nullptr);
+  UpdateLife(delta);
+  Respawn(delta);
 
-  glEnableVertexAttribArray(1);
-  glBindBuffer(GL_ARRAY_BUFFER, vbo_pos_);
-  glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 0, nullptr);
+  ResizeBuffers();
+  FillBuffers(0U, pos_buffer_.size());
+}
 
-  glEnableVertexAttribArray(2);
-  glBindBuffer(GL_ARRAY_BUFFER, vbo_color_);
-  glVertexAttribPointer(2, 4, GL_FLOAT, GL_FALSE, 0, nullptr);
+auto ParticleEffect::Update(TimeType const delta, JobSystem& jobs) -> void {
+  GOYA_PROFILE_ZONE("ParticleEffect::Update");
+  auto const alloc_scope = AllocScope(AllocSubsystem::kParticles);
 
-  glVertexAttribDivisor(0, 0);
-  glVertexAttribDivisor(1, 1);
-  glVertexAttribDivisor(2, 1);
+  // life and respawn reorder particles and call into the user's source, only
+  // the per particle buffer fill is split across workers
+  UpdateLife(delta);
+  Respawn(delta);
 
-  glBindVertexArray(0);
+  ResizeBuffers();
+  jobs.ParallelFor(0U, pos_buffer_.size(), detail::kParticleGrain,
+                   [this](std::size_t first, std::size_t last) -> void {
+                     FillBuffers(first, last);
+                   });
+}
 
-  SetScale(glm::mat4(1.f));
+auto ParticleEffect::Capture(ParticleSnapshot& dst) const -> void {
+  dst.positions.assign(pos_buffer_.begin(), pos_buffer_.end());
+  dst.colors.assign(color_buffer_.begin(), color_buffer_.end());
 }
 
-ParticleEffect::~ParticleEffect() {
-  glDeleteVertexArrays(1, &vao_);
-  glDeleteBuffers(1, &vbo_vertex_);
-  glDeleteBuffers(1, &vbo_pos_);
-  glDeleteBuffers(1, &vbo_color_);
+auto ParticleEffect::Upload() -> void {
+  UploadBuffers(pos_buffer_, color_buffer_);
 }
 
-auto ParticleEffect::Update(TimeType const delta) -> void {
-  UpdateLife(delta);
-  Respawn(delta);
-  UpdateBuffers();
+auto ParticleEffect::Upload(ParticleSnapshot const& src) -> void {
+  UploadBuffers(src.positions, src.colors);
 }
 
 auto ParticleEffect::Draw() -> void {
-  if (particles_.begin() == live_particles_end_) {
+  if (n_uploaded_ == 0U) {
     return;
   }
 
+  GOYA_PROFILE_ZONE("ParticleEffect::Draw");
+  GOYA_PROFILE_GPU_ZONE("ParticleEffect::Draw");
+
   shader_->Use();
+  if (std::exchange(scale_dirty_, false)) {
+    shader_->SetMat4("systemScale", scale_matrix_);
+  }
 
-  glEnable(GL_DEPTH_TEST);
-  glEnable(GL_BLEND);
-  glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+  GlState().SetDepthTest(true);
+  GlState().SetBlend(true);
+  GlState().BlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 
-  glBindBuffer(GL_ARRAY_BUFFER, vbo_pos_);
+  GlState().BindVertexArray(vao_);
+  glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4,
+                        static_cast<GLsizei>(n_uploaded_));
+}
+
+auto ParticleEffect::Submit(RenderQueue& queue) -> void {
+  if (n_uploaded_ == 0U) {
+    return;
+  }
+
+  // the oldest live particle stands in for the whole effect
+  auto const depth = queue.Depth(uploaded_anchor_);
+  queue.Push(MakeDrawKey(RenderPass::kTransparent, shader_->Id(), vao_, depth),
+             this);
+}
+
+auto ParticleEffect::SetScale(glm::mat4 const scale_matrix) -> void {
+  scale_matrix_ = scale_matrix;
+  scale_dirty_ = true;
+}
+
+// gl objects are created on first use, so simulating needs no context
+auto ParticleEffect::InitGl() -> void {
+  if (vao_ != 0U) {
+    return;
+  }
+
+  glGenVertexArrays(1, &vao_);
+  GlState().BindVertexArray(vao_);
+
+  glGenBuffers(1, &vbo_vertex_);
+  GlState().BindBuffer(GL_ARRAY_BUFFER, vbo_vertex_);
+  glBufferData(GL_ARRAY_BUFFER, sizeof(detail::kParticleMesh),
+               detail::kParticleMesh.data(), GL_STATIC_DRAW);
+
+  glGenBuffers(1, &vbo_pos_);
+  GlState().BindBuffer(GL_ARRAY_BUFFER, vbo_pos_);
   glBufferData(
       GL_ARRAY_BUFFER,
-      pos_buffer_.capacity() * sizeof(decltype(pos_buffer_)::value_type),
+      particles_.size() * sizeof(decltype(pos_buffer_)::value_type),
       nullptr, GL_STREAM_DRAW);
-  glBufferSubData(
-      GL_ARRAY_BUFFER, 0,
-      pos_buffer_.size() * sizeof(decltype(pos_buffer_)::value_type),
-      pos_buffer_.data());
 
-  glBindBuffer(GL_ARRAY_BUFFER, vbo_color_);
+  glGenBuffers(1, &vbo_color_);
+  GlState().BindBuffer(GL_ARRAY_BUFFER, vbo_color_);
   glBufferData(
       GL_ARRAY_BUFFER,
-      color_buffer_.capacity() * sizeof(decltype(color_buffer_)::value_type),
+      particles_.size() * sizeof(decltype(color_buffer_)::value_type),
       nullptr, GL_STREAM_DRAW);
-  glBufferSubData(
-      GL_ARRAY_BUFFER, 0,
-      color_buffer_.size() * sizeof(decltype(color_buffer_)::value_type),
-      color_buffer_.data());
 
-  glBindVertexArray(vao_);
-  glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4,
-                        std::distance(particles_.begin(), live_particles_end_));
-  glBindVertexArray(0);
-}
+  glEnableVertexAttribArray(0);
+  GlState().BindBuffer(GL_ARRAY_BUFFER, vbo_vertex_);
+  glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 0, nullptr);
 
-auto ParticleEffect::SetScale(glm::mat4 const scale_matrix) -> void {
-  shader_->Use();
-  shader_->SetMat4("systemScale", scale_matrix);
+  glEnableVertexAttribArray(1);
+  GlState().BindBuffer(GL_ARRAY_BUFFER, vbo_pos_);
+  glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 0, nullptr);
+
+  glEnableVertexAttribArray(2);
+  GlState().BindBuffer(GL_ARRAY_BUFFER, vbo_color_);
+  glVertexAttribPointer(2, 4, GL_FLOAT, GL_FALSE, 0, nullptr);
+
+  glVertexAttribDivisor(0, 0);
+  glVertexAttribDivisor(1, 1);
+  glVertexAttribDivisor(2, 1);
+
+  GlState().BindVertexArray(0);
 }
 
 auto ParticleEffect::UpdateLife(TimeType const delta) -> void {
@@ -150,21 +204,25 @@ auto ParticleEffect::UpdateLife(TimeType const delta) -> void {
   }
 }
 
-auto ParticleEffect::UpdatePositionsBuffer() -> void {
-  pos_buffer_.clear();
-  for (auto iter = particles_.begin(); iter != live_particles_end_; ++iter) {
-    pos_buffer_.push_back(
-        iter->position + iter->velocity * iter->life_len +
-        (glm::vec3(0.f, -9.81, 0.f) * iter->life_len * iter->life_len));
-  }
-};
+auto ParticleEffect::ResizeBuffers() -> void {
+  auto const n_live = static_cast<std::size_t>(
+      std::distance(particles_.begin(), live_particles_end_));
 
-auto ParticleEffect::UpdateColorBuffer() -> void {
-  color_buffer_.clear();
-  for (auto iter = particles_.begin(); iter != live_particles_end_; ++iter) {
-    color_buffer_.push_back(iter->color +
-                            glm::vec4(1.f, 0.08f, 0.12f, 1.f) *
-                                (1.f - (iter->life_len / particle_life_span_)));
+  pos_buffer_.resize(n_live);
+  color_buffer_.resize(n_live);
+}
+
+auto ParticleEffect::FillBuffers(std::size_t const first,
+                                 std::size_t const last) -> void {
+  for (auto i = first; i < last; ++i) {
+    auto const& particle = particles_[i];
+    pos_buffer_[i] = particle.position + particle.velocity * particle.life_len +
+                     (glm::vec3(0.f, -9.81f, 0.f) * particle.life_len *
+                      particle.life_len);
+
+    color_buffer_[i] = particle.color +
+                       glm::vec4(1.f, 0.08f, 0.12f, 1.f) *
+                           (1.f - (particle.life_len / particle_life_span_));
   }
 }
 
@@ -185,9 +243,30 @@ auto ParticleEffect::Respawn(TimeType const delta) -> void {
   }
 }
 
-auto ParticleEffect::UpdateBuffers() -> void {
-  UpdatePositionsBuffer();
-  UpdateColorBuffer();
+auto ParticleEffect::UploadBuffers(std::vector<glm::vec3> const& positions,
+                                   std::vector<glm::vec4> const& colors)
+    -> void {
+  InitGl();
+
+  n_uploaded_ = std::min(positions.size(), particles_.size());
+  if (n_uploaded_ == 0U) {
+    return;
+  }
+
+  uploaded_anchor_ = positions.front();
+
+  // orphan the previous storage so the driver does not wait on the last draw
+  GlState().BindBuffer(GL_ARRAY_BUFFER, vbo_pos_);
+  glBufferData(GL_ARRAY_BUFFER,
+               particles_.size() * sizeof(glm::vec3), nullptr, GL_STREAM_DRAW);
+  glBufferSubData(GL_ARRAY_BUFFER, 0, n_uploaded_ * sizeof(glm::vec3),
+                  positions.data());
+
+  GlState().BindBuffer(GL_ARRAY_BUFFER, vbo_color_);
+  glBufferData(GL_ARRAY_BUFFER,
+               particles_.size() * sizeof(glm::vec4), nullptr, GL_STREAM_DRAW);
+  glBufferSubData(GL_ARRAY_BUFFER, 0, n_uploaded_ * sizeof(glm::vec4),
+                  colors.data());
 }
 
 }  // namespace goya
@@ -0,0 +1,464 @@
+#include "goya/profiler.hpp"
+
+#include <algorithm>
+#include <array>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <map>
+#include <stdexcept>
+#include <utility>
+
+#include "GL/glew.h"
+
+namespace goya {
+
+namespace detail {
+
+static auto constexpr kGpuThread = std::numeric_limits<std::uint32_t>::max();
+static auto constexpr kMaxCapturedEvents = std::size_t(1U) << 20U;
+static auto constexpr kNsPerMs = 1e6;
+
+auto KindLabel(ProfileEventKind const kind) -> char const* {
+  switch (kind) {
+    case ProfileEventKind::kCpuZone:
+      return "cpu";
+    case ProfileEventKind::kGpuZone:
+      return "gpu";
+    case ProfileEventKind::kCounter:
+      return "counter";
+  }
+
+  return "";
+}
+
+auto WriteJsonString(std::ostream& ostrm, char const* str) -> void {
+  ostrm << '"';
+  for (; *str != '\0'; ++str) {
+    if (*str == '"' || *str == '\\') {
+      ostrm << '\\';
+    }
+
+    ostrm << *str;
+  }
+
+  ostrm << '"';
+}
+
+}  // namespace detail
+
+struct Profiler::ThreadBuffer {
+  static auto constexpr kCapacity = std::uint64_t(1U) << 14U;
+
+  // fields are atomic so a lapping writer never races with the reader
+  struct Slot {
+    std::atomic<char const*> name{nullptr};
+    std::atomic<ProfileEventKind> kind{ProfileEventKind::kCpuZone};
+    std::atomic<std::uint64_t> start_ns{0U};
+    std::atomic<std::uint64_t> end_ns{0U};
+    std::atomic<double> value{0.0};
+  };
+
+  explicit ThreadBuffer(std::uint32_t buffer_id)
+      : slots(std::make_unique<Slot[]>(kCapacity)),
+        head(0U),
+        cursor(0U),
+        id(buffer_id),
+        name("thread " + std::to_string(buffer_id)) {}
+
+  std::unique_ptr<Slot[]> slots;
+  std::atomic<std::uint64_t> head;
+
+  // render thread only
+  std::uint64_t cursor;
+
+  std::uint32_t id;
+  std::string name;
+};
+
+struct Profiler::GpuFrame {
+  static auto constexpr kMaxZones = std::size_t(64U);
+
+  std::array<GLuint, kMaxZones> queries{};
+  std::array<char const*, kMaxZones> names{};
+  std::array<std::uint64_t, kMaxZones> cpu_start_ns{};
+
+  std::size_t used = 0U;
+  bool generated = false;
+};
+
+Profiler::Profiler()
+    : epoch_(Clock::now()),
+      enabled_(false),
+      gpu_frame_idx_(0U),
+      gpu_zone_open_(false),
+      gpu_dropped_(0U),
+      capture_(false),
+      summary_interval_(0.0),
+      summary_start_ns_(0U),
+      summary_frames_(0U) {
+  gpu_frames_.push_back(std::make_unique<GpuFrame>());
+  gpu_frames_.push_back(std::make_unique<GpuFrame>());
+}
+
+Profiler::~Profiler() = default;
+
+auto Profiler::SetEnabled(bool const enabled) noexcept -> void {
+  enabled_.store(enabled, std::memory_order_relaxed);
+}
+
+auto Profiler::Enabled() const noexcept -> bool {
+  return enabled_.load(std::memory_order_relaxed);
+}
+
+auto Profiler::SetCapture(bool const capture) -> void { capture_ = capture; }
+
+auto Profiler::SetSummaryInterval(double const seconds) -> void {
+  summary_interval_ = seconds;
+  ResetSummary();
+}
+
+auto Profiler::SetThreadName(std::string name) -> void {
+  auto& buffer = LocalBuffer();
+
+  auto lock = std::lock_guard(buffers_mtx_);
+  buffer.name = std::move(name);
+}
+
+auto Profiler::Now() const noexcept -> std::uint64_t {
+  return static_cast<std::uint64_t>(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() -
+                                                           epoch_)
+          .count());
+}
+
+auto Profiler::RecordZone(char const* name, std::uint64_t const start_ns,
+                          std::uint64_t const end_ns) -> void {
+  Push(ProfileEvent{name, ProfileEventKind::kCpuZone, 0U, start_ns, end_ns,
+                    0.0});
+}
+
+auto Profiler::Counter(char const* name, double const value) -> void {
+  if (!Enabled()) {
+    return;
+  }
+
+  auto const now = Now();
+  Push(ProfileEvent{name, ProfileEventKind::kCounter, 0U, now, now, value});
+}
+
+auto Profiler::BeginGpuZone(char const* name) -> bool {
+  if (!Enabled()) {
+    return false;
+  }
+
+  // nested zones are expected, e.g. models drawn by a spline, the outer
+  // zone already covers them
+  if (gpu_zone_open_) {
+    return false;
+  }
+
+  auto& frame = *gpu_frames_[gpu_frame_idx_];
+  if (frame.used == GpuFrame::kMaxZones) {
+    ++gpu_dropped_;
+    return false;
+  }
+
+  if (!frame.generated) {
+    glGenQueries(static_cast<GLsizei>(frame.queries.size()),
+                 frame.queries.data());
+    frame.generated = true;
+  }
+
+  frame.names[frame.used] = name;
+  frame.cpu_start_ns[frame.used] = Now();
+  glBeginQuery(GL_TIME_ELAPSED, frame.queries[frame.used]);
+
+  gpu_zone_open_ = true;
+  return true;
+}
+
+auto Profiler::EndGpuZone() -> void {
+  glEndQuery(GL_TIME_ELAPSED);
+
+  ++gpu_frames_[gpu_frame_idx_]->used;
+  gpu_zone_open_ = false;
+}
+
+auto Profiler::BeginFrame() -> void {
+  if (!Enabled()) {
+    return;
+  }
+
+  // the set about to be reused was issued a whole frame ago
+  gpu_frame_idx_ = (gpu_frame_idx_ + 1U) % gpu_frames_.size();
+  CollectGpu(*gpu_frames_[gpu_frame_idx_]);
+  Collect();
+
+  ++summary_frames_;
+  if (summary_interval_ > 0.0 &&
+      static_cast<double>(Now() - summary_start_ns_) * 1e-9 >=
+          summary_interval_) {
+    PrintSummary(std::cout);
+  }
+}
+
+auto Profiler::ReleaseGpu() -> void {
+  for (auto& frame : gpu_frames_) {
+    if (frame->generated) {
+      glDeleteQueries(static_cast<GLsizei>(frame->queries.size()),
+                      frame->queries.data());
+    }
+
+    *frame = GpuFrame();
+  }
+
+  gpu_zone_open_ = false;
+}
+
+auto Profiler::SummaryTotals() const -> std::vector<ProfileTotals> {
+  // literals with equal text may still have different addresses
+  using MergedKey = std::pair<ProfileEventKind, std::string>;
+  auto merged = std::map<MergedKey, ProfileTotals>();
+  for (auto const& [name, stats] : summary_) {
+    auto& dst = merged[{stats.kind, name}];
+    dst.kind = stats.kind;
+    dst.calls += stats.calls;
+    dst.total_ns += stats.total_ns;
+    dst.max_ns = std::max(dst.max_ns, stats.max_ns);
+    dst.counter_sum += stats.counter_sum;
+    dst.counter_last = stats.counter_last;
+  }
+
+  auto dst = std::vector<ProfileTotals>();
+  dst.reserve(merged.size());
+  for (auto& [key, totals] : merged) {
+    totals.name = key.second;
+    dst.push_back(std::move(totals));
+  }
+
+  return dst;
+}
+
+auto Profiler::SummaryFrames() const noexcept -> std::uint64_t {
+  return summary_frames_;
+}
+
+auto Profiler::ResetSummary() -> void {
+  summary_.clear();
+  summary_frames_ = 0U;
+  summary_start_ns_ = Now();
+  gpu_dropped_ = 0U;
+}
+
+auto Profiler::PrintSummary(std::ostream& ostrm) -> void {
+  auto const frames = std::max(summary_frames_, std::uint64_t(1U));
+  auto const elapsed_ms =
+      static_cast<double>(Now() - summary_start_ns_) / detail::kNsPerMs;
+
+  ostrm << "[goya::Profiler] " << summary_frames_ << " frames, " << std::fixed
+        << std::setprecision(3)
+        << elapsed_ms / static_cast<double>(frames) << " ms/frame\n";
+
+  for (auto const& stats : SummaryTotals()) {
+    auto const calls =
+        static_cast<double>(std::max(stats.calls, std::uint64_t(1U)));
+    ostrm << "  " << std::left << std::setw(8)
+          << detail::KindLabel(stats.kind) << std::setw(32) << stats.name
+          << std::right;
+
+    if (stats.kind == ProfileEventKind::kCounter) {
+      ostrm << " avg " << std::setw(12) << stats.counter_sum / calls
+            << " last " << std::setw(12) << stats.counter_last << '\n';
+    } else {
+      ostrm << std::setw(10)
+            << static_cast<double>(stats.total_ns) / detail::kNsPerMs /
+                   static_cast<double>(frames)
+            << " ms/frame " << std::setw(8)
+            << static_cast<double>(stats.calls) / static_cast<double>(frames)
+            << " calls/frame " << std::setw(10)
+            << static_cast<double>(stats.max_ns) / detail::kNsPerMs
+            << " ms max\n";
+    }
+  }
+
+  if (gpu_dropped_ != 0U) {
+    ostrm << "  " << gpu_dropped_
+          << " gpu zones dropped (overflowing or late)\n";
+  }
+
+  ostrm.flush();
+
+  ResetSummary();
+}
+
+auto Profiler::WriteChromeTrace(std::string const& path) -> void {
+  Collect();
+
+  auto ofstrm = std::ofstream(path);
+  if (!ofstrm.is_open()) {
+    throw std::runtime_error("[goya::Profiler] failed to open " + path);
+  }
+
+  ofstrm << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+  ofstrm << std::fixed << std::setprecision(3);
+
+  auto first = true;
+  auto const separator = [&]() -> void {
+    ofstrm << (first ? "\n" : ",\n");
+    first = false;
+  };
+
+  {
+    auto lock = std::lock_guard(buffers_mtx_);
+    for (auto const& buffer : buffers_) {
+      separator();
+      ofstrm << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":"
+             << buffer->id << ",\"args\":{\"name\":";
+      detail::WriteJsonString(ofstrm, buffer->name.c_str());
+      ofstrm << "}}";
+    }
+  }
+
+  separator();
+  ofstrm << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":"
+         << detail::kGpuThread << ",\"args\":{\"name\":\"gpu\"}}";
+
+  for (auto const& event : captured_) {
+    separator();
+    ofstrm << "{\"name\":";
+    detail::WriteJsonString(ofstrm, event.name);
+    ofstrm << ",\"cat\":\"" << detail::KindLabel(event.kind)
+           << "\",\"pid\":1,\"tid\":" << event.thread
+           << ",\"ts\":" << static_cast<double>(event.start_ns) * 1e-3;
+
+    if (event.kind == ProfileEventKind::kCounter) {
+      ofstrm << ",\"ph\":\"C\",\"args\":{\"value\":" << event.value << "}}";
+    } else {
+      ofstrm << ",\"ph\":\"X\",\"dur\":"
+             << static_cast<double>(event.end_ns - event.start_ns) * 1e-3
+             << '}';
+    }
+  }
+
+  ofstrm << "\n]}\n";
+}
+
+auto Profiler::LocalBuffer() -> ThreadBuffer& {
+  // buffers are owned by the profiler, so events of exited threads survive
+  thread_local auto buffer = static_cast<ThreadBuffer*>(nullptr);
+  if (!buffer) {
+    auto lock = std::lock_guard(buffers_mtx_);
+    buffers_.push_back(std::make_unique<ThreadBuffer>(
+        static_cast<std::uint32_t>(buffers_.size())));
+    buffer = buffers_.back().get();
+  }
+
+  return *buffer;
+}
+
+auto Profiler::Push(ProfileEvent const& event) -> void {
+  auto& buffer = LocalBuffer();
+
+  auto const head = buffer.head.load(std::memory_order_relaxed);
+  auto& slot = buffer.slots[head & (ThreadBuffer::kCapacity - 1U)];
+  slot.name.store(event.name, std::memory_order_relaxed);
+  slot.kind.store(event.kind, std::memory_order_relaxed);
+  slot.start_ns.store(event.start_ns, std::memory_order_relaxed);
+  slot.end_ns.store(event.end_ns, std::memory_order_relaxed);
+  slot.value.store(event.value, std::memory_order_relaxed);
+
+  buffer.head.store(head + 1U, std::memory_order_release);
+}
+
+auto Profiler::Collect() -> void {
+  auto lock = std::lock_guard(buffers_mtx_);
+  for (auto& buffer : buffers_) {
+    auto const head = buffer->head.load(std::memory_order_acquire);
+
+    // events older than one ring are lost
+    if (head - buffer->cursor > ThreadBuffer::kCapacity) {
+      buffer->cursor = head - ThreadBuffer::kCapacity;
+    }
+
+    for (; buffer->cursor < head; ++buffer->cursor) {
+      auto const& slot =
+          buffer->slots[buffer->cursor & (ThreadBuffer::kCapacity - 1U)];
+      Accumulate(ProfileEvent{slot.name.load(std::memory_order_relaxed),
+                              slot.kind.load(std::memory_order_relaxed),
+                              buffer->id,
+                              slot.start_ns.load(std::memory_order_relaxed),
+                              slot.end_ns.load(std::memory_order_relaxed),
+                              slot.value.load(std::memory_order_relaxed)});
+    }
+  }
+}
+
+auto Profiler::CollectGpu(GpuFrame& frame) -> void {
+  for (auto i = std::size_t(0U); i < frame.used; ++i) {
+    auto available = GLint(0);
+    glGetQueryObjectiv(frame.queries[i], GL_QUERY_RESULT_AVAILABLE,
+                       &available);
+    if (!available) {
+      ++gpu_dropped_;
+      continue;
+    }
+
+    auto elapsed_ns = GLuint64(0U);
+    glGetQueryObjectui64v(frame.queries[i], GL_QUERY_RESULT, &elapsed_ns);
+
+    // only durations are known, the zone is placed at its cpu submit time
+    Accumulate(ProfileEvent{frame.names[i], ProfileEventKind::kGpuZone,
+                            detail::kGpuThread, frame.cpu_start_ns[i],
+                            frame.cpu_start_ns[i] + elapsed_ns, 0.0});
+  }
+
+  frame.used = 0U;
+}
+
+auto Profiler::Accumulate(ProfileEvent const& event) -> void {
+  auto& stats = summary_[event.name];
+  stats.kind = event.kind;
+  ++stats.calls;
+
+  if (event.kind == ProfileEventKind::kCounter) {
+    stats.counter_sum += event.value;
+    stats.counter_last = event.value;
+  } else {
+    auto const duration = event.end_ns - event.start_ns;
+    stats.total_ns += duration;
+    stats.max_ns = std::max(stats.max_ns, duration);
+  }
+
+  if (capture_ && captured_.size() < detail::kMaxCapturedEvents) {
+    captured_.push_back(event);
+  }
+}
+
+auto GlobalProfiler() -> Profiler& {
+  static auto profiler = Profiler();
+  return profiler;
+}
+
+ScopedZone::ScopedZone(char const* name) noexcept
+    : name_(GlobalProfiler().Enabled() ? name : nullptr),
+      start_ns_(name_ ? GlobalProfiler().Now() : 0U) {}
+
+ScopedZone::~ScopedZone() {
+  if (name_) {
+    auto& profiler = GlobalProfiler();
+    profiler.RecordZone(name_, start_ns_, profiler.Now());
+  }
+}
+
+ScopedGpuZone::ScopedGpuZone(char const* name)
+    : active_(GlobalProfiler().BeginGpuZone(name)) {}
+
+ScopedGpuZone::~ScopedGpuZone() {
+  if (active_) {
+    GlobalProfiler().EndGpuZone();
+  }
+}
+
+}  // namespace goya
@@ -0,0 +1,143 @@
+#include "goya/render_queue.hpp"
+
+#include <algorithm>
+#include <array>
+#include <utility>
+
+#include "goya/alloc_tracker.hpp"
+#include "goya/profiler.hpp"
+
+namespace goya {
+
+namespace detail {
+
+auto constexpr kPassShift = 60U;
+
+auto constexpr kProgramBits = 12U;
+auto constexpr kVaoBits = 16U;
+auto constexpr kDepthBits = 24U;
+
+auto constexpr kRadixBits = 8U;
+auto constexpr kRadixBuckets = 1U << kRadixBits;
+
+auto Mask(std::uint64_t const val, std::uint32_t const bits) noexcept
+    -> std::uint64_t {
+  return val & ((std::uint64_t(1) << bits) - 1U);
+}
+
+auto QuantizeDepth(float const depth) noexcept -> std::uint64_t {
+  auto const clamped = std::min(std::max(depth, 0.f), 1.f);
+  auto const max_val = static_cast<float>((1U << kDepthBits) - 1U);
+  return static_cast<std::uint64_t>(clamped * max_val);
+}
+
+}  // namespace detail
+
+auto MakeDrawKey(RenderPass const pass, std::uint32_t const program,
+                 std::uint32_t const vao, float const depth) noexcept
+    -> std::uint64_t {
+  auto const pass_bits = static_cast<std::uint64_t>(pass) << detail::kPassShift;
+  auto const program_bits = detail::Mask(program, detail::kProgramBits);
+  auto const vao_bits = detail::Mask(vao, detail::kVaoBits);
+  auto const depth_bits = detail::QuantizeDepth(depth);
+
+  if (pass == RenderPass::kTransparent) {
+    auto const far_to_near =
+        detail::Mask(~depth_bits, detail::kDepthBits);
+    return pass_bits | (far_to_near << 36U) | (program_bits << 16U) |
+           vao_bits;
+  }
+
+  return pass_bits | (program_bits << 48U) | (vao_bits << 32U) |
+         (depth_bits << 8U);
+}
+
+auto DrawKeyPass(std::uint64_t const key) noexcept -> RenderPass {
+  return static_cast<RenderPass>(key >> detail::kPassShift);
+}
+
+auto DrawList::Push(std::uint64_t const key, IDrawable* const drawable)
+    -> void {
+  packets_.push_back(DrawPacket{key, drawable});
+}
+
+auto DrawList::Size() const noexcept -> std::size_t { return packets_.size(); }
+
+auto DrawList::Clear() noexcept -> void { packets_.clear(); }
+
+auto RenderQueue::SetView(glm::vec3 const eye, glm::vec3 const front,
+                          float const far_plane) -> void {
+  eye_ = eye;
+  front_ = glm::normalize(front);
+  far_plane_ = far_plane;
+}
+
+auto RenderQueue::Depth(glm::vec3 const pos) const noexcept -> float {
+  return glm::dot(pos - eye_, front_) / far_plane_;
+}
+
+auto RenderQueue::Push(std::uint64_t const key, IDrawable* const drawable)
+    -> void {
+  packets_.push_back(DrawPacket{key, drawable});
+}
+
+auto RenderQueue::Merge(DrawList& list) -> void {
+  {
+    auto const lock = std::lock_guard<std::mutex>(merge_mtx_);
+    packets_.insert(packets_.end(), list.packets_.begin(),
+                    list.packets_.end());
+  }
+
+  list.Clear();
+}
+
+auto RenderQueue::Size() const noexcept -> std::size_t {
+  return packets_.size();
+}
+
+// lsd radix sort over 8 bit digits, digits shared by every key are skipped
+auto RenderQueue::Sort() -> void {
+  if (packets_.size() < 2U) {
+    return;
+  }
+
+  scratch_.resize(packets_.size());
+  for (auto shift = 0U; shift < 64U; shift += detail::kRadixBits) {
+    auto counts = std::array<std::size_t, detail::kRadixBuckets>{};
+    for (auto const& packet : packets_) {
+      ++counts[detail::Mask(packet.key >> shift, detail::kRadixBits)];
+    }
+
+    auto const digit =
+        detail::Mask(packets_.front().key >> shift, detail::kRadixBits);
+    if (counts[digit] == packets_.size()) {
+      continue;
+    }
+
+    auto offset = std::size_t(0);
+    for (auto& count : counts) {
+      offset += std::exchange(count, offset);
+    }
+
+    for (auto const& packet : packets_) {
+      scratch_[counts[detail::Mask(packet.key >> shift,
+                                   detail::kRadixBits)]++] = packet;
+    }
+
+    packets_.swap(scratch_);
+  }
+}
+
+auto RenderQueue::Execute() -> void {
+  GOYA_PROFILE_ZONE("RenderQueue::Execute");
+  auto const alloc_scope = AllocScope(AllocSubsystem::kRender);
+
+  Sort();
+  for (auto const& packet : packets_) {
+    packet.drawable->Draw();
+  }
+
+  packets_.clear();
+}
+
+}  // namespace goya
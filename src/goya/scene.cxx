@@ -0,0 +1,104 @@
+#include "goya/scene.hpp"
+
+#include <chrono>
+
+#include "goya/alloc_tracker.hpp"
+#include "goya/profiler.hpp"
+
+namespace goya {
+
+namespace detail {
+
+using SceneClock = std::chrono::steady_clock;
+
+auto ElapsedMs(SceneClock::time_point const since) -> float {
+  return std::chrono::duration<float, std::milli>(SceneClock::now() - since)
+      .count();
+}
+
+}  // namespace detail
+
+auto Scene::Add(std::shared_ptr<Model> model) -> ObjectId {
+  auto id = static_cast<ObjectId>(entries_.size());
+  if (!free_ids_.empty()) {
+    id = free_ids_.back();
+    free_ids_.pop_back();
+  } else {
+    entries_.emplace_back();
+  }
+
+  auto& entry = entries_[id];
+  entry.proxy = bvh_.CreateProxy(model->Bounds(), id);
+  entry.version = model->TransformVersion();
+  entry.model = std::move(model);
+
+  ++stats_.objects;
+  return id;
+}
+
+auto Scene::Remove(ObjectId const id) -> void {
+  auto& entry = entries_.at(id);
+  bvh_.DestroyProxy(entry.proxy);
+
+  entry.model.reset();
+  entry.proxy = DynamicBvh::kNullNode;
+  free_ids_.push_back(id);
+
+  --stats_.objects;
+}
+
+auto Scene::Update() -> void {
+  GOYA_PROFILE_ZONE("Scene::Update");
+  auto const alloc_scope = AllocScope(AllocSubsystem::kScene);
+
+  auto const start = detail::SceneClock::now();
+
+  stats_.reinserted = 0U;
+  for (auto& entry : entries_) {
+    if (!entry.model || entry.model->TransformVersion() == entry.version) {
+      continue;
+    }
+
+    entry.version = entry.model->TransformVersion();
+    if (bvh_.MoveProxy(entry.proxy, entry.model->Bounds())) {
+      ++stats_.reinserted;
+    }
+  }
+
+  stats_.update_ms = detail::ElapsedMs(start);
+}
+
+auto Scene::Cull(Camera const& camera) -> std::vector<Model*> const& {
+  GOYA_PROFILE_ZONE("Scene::Cull");
+  auto const alloc_scope = AllocScope(AllocSubsystem::kScene);
+
+  auto const start = detail::SceneClock::now();
+
+  visible_ids_.clear();
+  auto const query_stats =
+      bvh_.Query(ExtractFrustum(camera.ViewProjection()), visible_ids_);
+
+  visible_.clear();
+  for (auto const id : visible_ids_) {
+    visible_.push_back(entries_[id].model.get());
+  }
+
+  stats_.visible = visible_.size();
+  stats_.nodes_visited = query_stats.nodes_visited;
+  stats_.cull_ms = detail::ElapsedMs(start);
+
+  GOYA_PROFILE_COUNTER("Scene::visible", stats_.visible);
+  GOYA_PROFILE_COUNTER("Scene::nodes_visited", stats_.nodes_visited);
+
+  return visible_;
+}
+
+auto Scene::Submit(RenderQueue& queue) -> void {
+  for (auto const model : visible_) {
+    model->Submit(queue);
+  }
+}
+
+auto Scene::Stats() const noexcept -> CullStats const& { return stats_; }
+
+}  // namespace goya
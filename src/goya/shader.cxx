@@ -1,5 +1,6 @@
 #include "goya/shader.hpp"
 
+#include <array>
 #include <fstream>
 #include <sstream>
 #include <stdexcept>
@@ -7,6 +8,7 @@
 #include <utility>
 
 #include "GL/glew.h"
+#include "goya/gl_state.hpp"
 #include "goya/meta.hpp"
 
 namespace goya {
@@ -15,9 +17,16 @@ namespace detail {
 
 enum class ShaderType : std::uint32_t {
   kVertex = GL_VERTEX_SHADER,
+  kTessControl = GL_TESS_CONTROL_SHADER,
+  kTessEvaluation = GL_TESS_EVALUATION_SHADER,
   kFragment = GL_FRAGMENT_SHADER
 };
 
+struct ShaderStage {
+  char const* src_path;
+  ShaderType type;
+};
+
 constexpr auto kErrorBuffSize = 1024UL;
 
 auto LoadShaderSource(char const* path) -> std::string {
@@ -50,7 +59,7 @@ auto CheckShaderLinking(std::uint32_t const program_id) {
 
   glGetProgramiv(program_id, GL_LINK_STATUS, &is_ok);
   if (!is_ok) {
-    glGetShaderInfoLog(program_id, kErrorBuffSize, nullptr, buff);
+    glGetProgramInfoLog(program_id, kErrorBuffSize, nullptr, buff);
 
     using namespace std::string_literals;
     throw std::runtime_error("[goya::Shader] failed to link shader program: "s +
@@ -70,33 +79,52 @@ auto CompileShader(std::string const& shader_src, ShaderType const type)
   return shader_id;
 }
 
-}  // namespace detail
+template <std::size_t N>
+auto LinkProgram(std::array<ShaderStage, N> const& stages) -> std::uint32_t {
+  auto shader_ids = std::array<std::uint32_t, N>();
+  for (auto i = std::size_t(0U); i < N; ++i) {
+    shader_ids[i] = CompileShader(LoadShaderSource(stages[i].src_path),
+                                  stages[i].type);
+    CheckShaderCompilation(shader_ids[i]);
+  }
 
-Shader::Shader(char const* vertex_src_path, char const* fragment_src_path) {
-  auto const vertex_src = detail::LoadShaderSource(vertex_src_path);
-  auto const fragment_src = detail::LoadShaderSource(fragment_src_path);
+  auto const program_id = glCreateProgram();
+  for (auto const shader_id : shader_ids) {
+    glAttachShader(program_id, shader_id);
+  }
 
-  auto const vertex_id =
-      detail::CompileShader(vertex_src, detail::ShaderType::kVertex);
-  detail::CheckShaderCompilation(vertex_id);
+  glLinkProgram(program_id);
+  CheckShaderLinking(program_id);
 
-  auto const fragment_id =
-      detail::CompileShader(fragment_src, detail::ShaderType::kFragment);
-  detail::CheckShaderCompilation(fragment_id);
+  for (auto const shader_id : shader_ids) {
+    glDeleteShader(shader_id);
+  }
 
-  id_ = glCreateProgram();
-  glAttachShader(id_, vertex_id);
-  glAttachShader(id_, fragment_id);
+  return program_id;
+}
 
-  glLinkProgram(id_);
-  detail::CheckShaderLinking(id_);
+}  // namespace detail
 
-  glDeleteShader(vertex_id);
-  glDeleteShader(fragment_id);
-}
+Shader::Shader(char const* vertex_src_path, char const* fragment_src_path)
+    : id_(detail::LinkProgram(std::array<detail::ShaderStage, 2U>{
+          detail::ShaderStage{vertex_src_path, detail::ShaderType::kVertex},
+          detail::ShaderStage{fragment_src_path,
+                              detail::ShaderType::kFragment}})) {}
+
+Shader::Shader(char const* vertex_src_path, char const* tess_control_src_path,
+               char const* tess_evaluation_src_path,
+               char const* fragment_src_path)
+    : id_(detail::LinkProgram(std::array<detail::ShaderStage, 4U>{
+          detail::ShaderStage{vertex_src_path, detail::ShaderType::kVertex},
+          detail::ShaderStage{tess_control_src_path,
+                              detail::ShaderType::kTessControl},
+          detail::ShaderStage{tess_evaluation_src_path,
+                              detail::ShaderType::kTessEvaluation},
+          detail::ShaderStage{fragment_src_path,
+                              detail::ShaderType::kFragment}})) {}
 
 auto Shader::Id() const noexcept -> std::uint32_t { return id_; }
-auto Shader::Use() const noexcept -> void { glUseProgram(id_); }
+auto Shader::Use() const noexcept -> void { GlState().UseProgram(id_); }
 
 auto Shader::SetBool(std::string const& name, bool const val) const -> void {
   glUniform1i(glGetUniformLocation(id_, name.c_str()),
@@ -0,0 +1,219 @@
+#include "goya/spline_followers.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+#include "goya/alloc_tracker.hpp"
+#include "goya/profiler.hpp"
+
+namespace goya {
+
+namespace detail {
+
+// followers per job
+static auto constexpr kFollowerGrain = std::size_t(512U);
+
+// followers evaluated side by side, every pass below is a plain loop over
+// them so the compiler can keep them in vector registers
+static auto constexpr kFollowerLanes = std::size_t(8U);
+
+// one vector component of every lane
+struct FollowerLanes {
+  alignas(32) float x[kFollowerLanes];
+  alignas(32) float y[kFollowerLanes];
+  alignas(32) float z[kFollowerLanes];
+};
+
+auto GatherLane(FollowerLanes& dst, std::size_t const lane,
+                glm::vec3 const& val) noexcept -> void {
+  dst.x[lane] = val.x;
+  dst.y[lane] = val.y;
+  dst.z[lane] = val.z;
+}
+
+}  // namespace detail
+
+auto SplineFollowers::AddPath(CubeBSpline const& path) -> std::uint32_t {
+  if (path.SegmentCount() == 0U || path.Length() <= 0.f) {
+    throw std::invalid_argument(
+        "[goya::SplineFollowers] a path needs at least one segment.");
+  }
+
+  paths_.push_back(&path);
+  return static_cast<std::uint32_t>(paths_.size() - 1U);
+}
+
+auto SplineFollowers::AddFollower(std::uint32_t path, float distance,
+                                  float speed, glm::vec3 offset)
+    -> std::size_t {
+  if (path >= paths_.size()) {
+    throw std::out_of_range("[goya::SplineFollowers] unknown path.");
+  }
+
+  auto const alloc_scope = AllocScope(AllocSubsystem::kSpline);
+
+  path_.push_back(path);
+  distance_.push_back(distance);
+  speed_.push_back(speed);
+  offset_.push_back(offset);
+
+  return path_.size() - 1U;
+}
+
+auto SplineFollowers::Size() const noexcept -> std::size_t {
+  return path_.size();
+}
+
+auto SplineFollowers::Distance(std::size_t follower) const -> float {
+  return distance_.at(follower);
+}
+
+auto SplineFollowers::SetScale(float scale) noexcept -> void {
+  scale_ = scale;
+}
+
+auto SplineFollowers::Update(TimeType delta, JobSystem& jobs, glm::mat4* dst)
+    -> void {
+  GOYA_PROFILE_ZONE("SplineFollowers::Update");
+
+  auto const store = [dst](std::size_t idx, glm::mat4 const& model) -> void {
+    dst[idx] = model;
+  };
+
+  jobs.ParallelFor(0U, Size(), detail::kFollowerGrain,
+                   [&](std::size_t begin, std::size_t end) -> void {
+                     UpdateBatch(delta, begin, end, store);
+                   });
+}
+
+auto SplineFollowers::Update(TimeType delta, JobSystem& jobs,
+                             InstancedModel& dst, std::size_t first) -> void {
+  GOYA_PROFILE_ZONE("SplineFollowers::Update");
+
+  if (Size() == 0U) {
+    return;
+  }
+
+  // mapped up front, marking blocks dirty is not thread safe
+  auto const instances = dst.MapInstances(first, Size());
+  auto const store = [instances](std::size_t idx,
+                                 glm::mat4 const& model) -> void {
+    instances[idx].model = model;
+  };
+
+  jobs.ParallelFor(0U, Size(), detail::kFollowerGrain,
+                   [&](std::size_t begin, std::size_t end) -> void {
+                     UpdateBatch(delta, begin, end, store);
+                   });
+}
+
+template <class Store>
+auto SplineFollowers::UpdateBatch(TimeType delta, std::size_t first,
+                                  std::size_t last, Store const& store)
+    -> void {
+  auto constexpr kLanes = detail::kFollowerLanes;
+
+  // gathered per lane, then every pass is a float loop over the lanes
+  alignas(32) float ts[kLanes] = {};
+  alignas(32) float qw[kLanes] = {};
+  alignas(32) float qx[kLanes] = {};
+  alignas(32) float qy[kLanes] = {};
+  alignas(32) float qz[kLanes] = {};
+  auto a = detail::FollowerLanes();
+  auto b = detail::FollowerLanes();
+  auto c = detail::FollowerLanes();
+  auto d = detail::FollowerLanes();
+  auto offsets = detail::FollowerLanes();
+
+  // positions and the three frame axes
+  auto pos = detail::FollowerLanes();
+  auto side = detail::FollowerLanes();
+  auto normal = detail::FollowerLanes();
+  auto tangent = detail::FollowerLanes();
+
+  for (auto base = first; base < last; base += kLanes) {
+    auto const n = std::min(kLanes, last - base);
+
+    // advance, wraps around in both directions
+    for (auto i = std::size_t(0U); i < n; ++i) {
+      auto const length = paths_[path_[base + i]]->Length();
+      auto const distance = distance_[base + i] + speed_[base + i] * delta;
+      distance_[base + i] = distance - std::floor(distance / length) * length;
+    }
+
+    // the lookups are the only branchy pass, they gather every lane's
+    // segment and rotation minimizing frame. idle lanes keep stale values,
+    // they are computed and never stored
+    for (auto i = std::size_t(0U); i < n; ++i) {
+      auto const& path = *paths_[path_[base + i]];
+      auto const param = path.ArcParameter(distance_[base + i]);
+      auto const& seg = path.Segment(param.idx);
+      auto const orientation = path.Orientation(param.t, param.idx);
+
+      ts[i] = param.t;
+      detail::GatherLane(a, i, seg.a);
+      detail::GatherLane(b, i, seg.b);
+      detail::GatherLane(c, i, seg.c);
+      detail::GatherLane(d, i, seg.d);
+      qw[i] = orientation.w;
+      qx[i] = orientation.x;
+      qy[i] = orientation.y;
+      qz[i] = orientation.z;
+      detail::GatherLane(offsets, i, offset_[base + i]);
+    }
+
+    for (auto i = std::size_t(0U); i < kLanes; ++i) {
+      auto const t = ts[i];
+      pos.x[i] = ((a.x[i] * t + b.x[i]) * t + c.x[i]) * t + d.x[i];
+      pos.y[i] = ((a.y[i] * t + b.y[i]) * t + c.y[i]) * t + d.y[i];
+      pos.z[i] = ((a.z[i] * t + b.z[i]) * t + c.z[i]) * t + d.z[i];
+    }
+
+    // columns of glm::mat3_cast, the same axes as CubeBSpline::ModelMatrix()
+    for (auto i = std::size_t(0U); i < kLanes; ++i) {
+      auto const xx = qx[i] * qx[i];
+      auto const yy = qy[i] * qy[i];
+      auto const zz = qz[i] * qz[i];
+      auto const xy = qx[i] * qy[i];
+      auto const xz = qx[i] * qz[i];
+      auto const yz = qy[i] * qz[i];
+      auto const wx = qw[i] * qx[i];
+      auto const wy = qw[i] * qy[i];
+      auto const wz = qw[i] * qz[i];
+
+      side.x[i] = 1.f - 2.f * (yy + zz);
+      side.y[i] = 2.f * (xy + wz);
+      side.z[i] = 2.f * (xz - wy);
+
+      normal.x[i] = 2.f * (xy - wz);
+      normal.y[i] = 1.f - 2.f * (xx + zz);
+      normal.z[i] = 2.f * (yz + wx);
+
+      tangent.x[i] = 2.f * (xz + wy);
+      tangent.y[i] = 2.f * (yz - wx);
+      tangent.z[i] = 1.f - 2.f * (xx + yy);
+    }
+
+    for (auto i = std::size_t(0U); i < kLanes; ++i) {
+      auto const ox = offsets.x[i];
+      auto const oy = offsets.y[i];
+      auto const oz = offsets.z[i];
+      pos.x[i] += ox * side.x[i] + oy * normal.x[i] + oz * tangent.x[i];
+      pos.y[i] += ox * side.y[i] + oy * normal.y[i] + oz * tangent.y[i];
+      pos.z[i] += ox * side.z[i] + oy * normal.z[i] + oz * tangent.z[i];
+    }
+
+    for (auto i = std::size_t(0U); i < n; ++i) {
+      auto const model = glm::mat4(
+          scale_ * side.x[i], scale_ * side.y[i], scale_ * side.z[i], 0.f,
+          scale_ * normal.x[i], scale_ * normal.y[i], scale_ * normal.z[i],
+          0.f, scale_ * tangent.x[i], scale_ * tangent.y[i],
+          scale_ * tangent.z[i], 0.f, pos.x[i], pos.y[i], pos.z[i], 1.f);
+
+      store(base + i, model);
+    }
+  }
+}
+
+}  // namespace goya
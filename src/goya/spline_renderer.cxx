@@ -0,0 +1,212 @@
+#include "goya/spline_renderer.hpp"
+
+#include <algorithm>
+#include <array>
+#include <limits>
+#include <stdexcept>
+
+#include "GL/glew.h"
+#include "goya/alloc_tracker.hpp"
+#include "goya/gl_state.hpp"
+#include "goya/profiler.hpp"
+#include "goya/render_queue.hpp"
+
+namespace goya {
+
+namespace detail {
+
+static auto constexpr kPatchVertices = 4U;
+
+// no dirty points
+static auto constexpr kCleanFirst = std::numeric_limits<std::size_t>::max();
+
+}  // namespace detail
+
+SplineRenderer::SplineRenderer(std::shared_ptr<Shader> shader)
+    : shader_(std::move(shader)),
+      dirty_first_(detail::kCleanFirst),
+      dirty_last_(0U),
+      indices_dirty_(false),
+      gpu_points_(0U),
+      gpu_indices_(0U) {
+  glGenVertexArrays(1, &vao_);
+  glGenBuffers(1, &vbo_);
+  glGenBuffers(1, &ebo_);
+
+  GlState().BindVertexArray(vao_);
+
+  GlState().BindBuffer(GL_ARRAY_BUFFER, vbo_);
+  glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex3d), nullptr);
+  glEnableVertexAttribArray(0);
+
+  GlState().BindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo_);
+
+  GlState().BindVertexArray(0);
+}
+
+SplineRenderer::~SplineRenderer() {
+  GlState().DeleteVertexArray(vao_);
+  GlState().DeleteBuffer(vbo_);
+  GlState().DeleteBuffer(ebo_);
+}
+
+auto SplineRenderer::AddCurve(std::vector<Vertex3d> const& control_points)
+    -> std::size_t {
+  if (control_points.size() < detail::kPatchVertices) {
+    throw std::invalid_argument(
+        "[goya::SplineRenderer] a curve needs at least four control points.");
+  }
+
+  auto const alloc_scope = AllocScope(AllocSubsystem::kSpline);
+
+  auto const first = points_.size();
+  curves_.push_back(Curve{first, control_points.size()});
+  points_.insert(points_.end(), control_points.begin(), control_points.end());
+
+  // segment i of the curve is the patch of points i to i + 3
+  auto const n_segments = control_points.size() - 3U;
+  for (auto seg = std::size_t(0U); seg < n_segments; ++seg) {
+    for (auto i = 0U; i < detail::kPatchVertices; ++i) {
+      indices_.push_back(static_cast<std::uint32_t>(first + seg + i));
+    }
+  }
+
+  MarkDirty(first, control_points.size());
+  indices_dirty_ = true;
+
+  return curves_.size() - 1U;
+}
+
+auto SplineRenderer::SetControlPoints(
+    std::size_t const curve, std::vector<Vertex3d> const& control_points)
+    -> void {
+  auto const& dst = curves_.at(curve);
+  if (control_points.size() != dst.count) {
+    throw std::invalid_argument(
+        "[goya::SplineRenderer] control point count of a curve is fixed.");
+  }
+
+  std::copy(control_points.begin(), control_points.end(),
+            points_.begin() + static_cast<std::ptrdiff_t>(dst.first));
+  MarkDirty(dst.first, dst.count);
+}
+
+auto SplineRenderer::SetControlPoint(std::size_t const curve,
+                                     std::size_t const idx,
+                                     Vertex3d const point) -> void {
+  auto const& dst = curves_.at(curve);
+  if (idx >= dst.count) {
+    throw std::out_of_range(
+        "[goya::SplineRenderer] control point index exceeds the curve.");
+  }
+
+  points_[dst.first + idx] = point;
+  MarkDirty(dst.first + idx, 1U);
+}
+
+auto SplineRenderer::CurveCount() const noexcept -> std::size_t {
+  return curves_.size();
+}
+
+auto SplineRenderer::PatchCount() const noexcept -> std::size_t {
+  return indices_.size() / detail::kPatchVertices;
+}
+
+auto SplineRenderer::SetColor(glm::vec3 const color) -> void {
+  color_ = color;
+}
+
+auto SplineRenderer::SetPixelsPerLine(float const pixels) -> void {
+  if (pixels <= 0.f) {
+    throw std::invalid_argument(
+        "[goya::SplineRenderer] pixels per line has to be positive.");
+  }
+
+  pixels_per_line_ = pixels;
+}
+
+auto SplineRenderer::Draw() -> void {
+  if (indices_.empty()) {
+    return;
+  }
+
+  GOYA_PROFILE_ZONE("SplineRenderer::Draw");
+  GOYA_PROFILE_GPU_ZONE("SplineRenderer::Draw");
+
+  Upload();
+
+  GlState().SetDepthTest(true);
+  GlState().SetBlend(false);
+
+  // the viewport is current state, querying it does not sync
+  auto viewport = std::array<GLint, 4U>();
+  glGetIntegerv(GL_VIEWPORT, viewport.data());
+
+  shader_->Use();
+  shader_->SetVec3("color", color_);
+  shader_->SetVec2("viewport", glm::vec2(static_cast<float>(viewport[2]),
+                                         static_cast<float>(viewport[3])));
+  shader_->SetFloat("pixelsPerLine", pixels_per_line_);
+
+  GlState().BindVertexArray(vao_);
+  glPatchParameteri(GL_PATCH_VERTICES,
+                    static_cast<GLint>(detail::kPatchVertices));
+  glDrawElements(GL_PATCHES, static_cast<GLsizei>(indices_.size()),
+                 GL_UNSIGNED_INT, nullptr);
+}
+
+auto SplineRenderer::Submit(RenderQueue& queue) -> void {
+  queue.Push(MakeDrawKey(RenderPass::kOpaque, shader_->Id(), vao_, 0.f), this);
+}
+
+auto SplineRenderer::MarkDirty(std::size_t const first,
+                               std::size_t const count) -> void {
+  dirty_first_ = std::min(dirty_first_, first);
+  dirty_last_ = std::max(dirty_last_, first + count);
+}
+
+auto SplineRenderer::Upload() -> void {
+  GlState().BindVertexArray(vao_);
+
+  if (indices_dirty_) {
+    GlState().BindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo_);
+    if (indices_.size() > gpu_indices_) {
+      gpu_indices_ = indices_.capacity();
+      glBufferData(
+          GL_ELEMENT_ARRAY_BUFFER,
+          static_cast<GLsizeiptr>(gpu_indices_ * sizeof(std::uint32_t)),
+          nullptr, GL_STATIC_DRAW);
+    }
+
+    glBufferSubData(
+        GL_ELEMENT_ARRAY_BUFFER, 0,
+        static_cast<GLsizeiptr>(indices_.size() * sizeof(std::uint32_t)),
+        indices_.data());
+    indices_dirty_ = false;
+  }
+
+  if (dirty_first_ >= dirty_last_) {
+    return;
+  }
+
+  GlState().BindBuffer(GL_ARRAY_BUFFER, vbo_);
+  if (points_.size() > gpu_points_) {
+    gpu_points_ = points_.capacity();
+    glBufferData(GL_ARRAY_BUFFER,
+                 static_cast<GLsizeiptr>(gpu_points_ * sizeof(Vertex3d)),
+                 nullptr, GL_DYNAMIC_DRAW);
+    dirty_first_ = 0U;
+    dirty_last_ = points_.size();
+  }
+
+  // one range covers every edit since the last draw
+  glBufferSubData(
+      GL_ARRAY_BUFFER, static_cast<GLintptr>(dirty_first_ * sizeof(Vertex3d)),
+      static_cast<GLsizeiptr>((dirty_last_ - dirty_first_) * sizeof(Vertex3d)),
+      points_.data() + dirty_first_);
+
+  dirty_first_ = detail::kCleanFirst;
+  dirty_last_ = 0U;
+}
+
+}  // namespace goya
@@ -0,0 +1,139 @@
+#include "goya/spline_stream.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+#include <utility>
+
+#include "goya/alloc_tracker.hpp"
+#include "goya/profiler.hpp"
+
+namespace goya {
+
+namespace detail {
+
+// points moved per slide, their segments are built right away
+static auto constexpr kSlideStep = std::size_t(32U);
+
+}  // namespace detail
+
+SplineStream::SplineStream(std::shared_ptr<TrajectorySource const> source,
+                           std::shared_ptr<Shader> shader, std::size_t window,
+                           std::size_t chunk)
+    : source_(std::move(source)),
+      spline_(source_->Read(0U, window), std::move(shader)),
+      window_(window),
+      chunk_(chunk) {
+  if (window_ < 4U * detail::kSlideStep || chunk_ == 0U) {
+    throw std::invalid_argument(
+        "[goya::SplineStream] window or chunk too small to stream.");
+  }
+}
+
+SplineStream::~SplineStream() {
+  // a failed read is of no interest anymore
+  try {
+    WaitPrefetch();
+  } catch (...) {
+  }
+}
+
+auto SplineStream::TimeUpdate(TimeType delta, JobSystem& jobs) -> void {
+  GOYA_PROFILE_ZONE("SplineStream::TimeUpdate");
+
+  auto const before = spline_.CurrentParam().idx;
+  spline_.TimeUpdate(delta);
+  if (!IsStreaming()) {
+    return;
+  }
+
+  // the window only wraps around at the end of the trajectory
+  if (spline_.CurrentParam().idx < before) {
+    Restart(jobs);
+    return;
+  }
+
+  if (prefetch_jobs_ == nullptr) {
+    Prefetch(jobs);
+  }
+
+  while (spline_.CurrentParam().idx >= window_ / 2U && Slide(jobs)) {
+  }
+}
+
+auto SplineStream::Spline() noexcept -> CubeBSpline& { return spline_; }
+
+auto SplineStream::Spline() const noexcept -> CubeBSpline const& {
+  return spline_;
+}
+
+auto SplineStream::FirstPoint() const noexcept -> std::size_t {
+  return first_;
+}
+
+auto SplineStream::IsStreaming() const noexcept -> bool {
+  return source_->Size() > window_;
+}
+
+// the next chunk is usually read long before ready_ runs out. the slots of
+// the dropped segments are reused by the new ones
+auto SplineStream::Slide(JobSystem& jobs) -> bool {
+  GOYA_PROFILE_ZONE("SplineStream::Slide");
+
+  if (ready_used_ == ready_.size()) {
+    WaitPrefetch();
+    if (next_.empty()) {
+      return false;
+    }
+
+    std::swap(ready_, next_);
+    ready_used_ = 0U;
+    Prefetch(jobs);
+  }
+
+  auto const count = std::min(detail::kSlideStep, ready_.size() - ready_used_);
+  auto const step = ready_.begin() + static_cast<std::ptrdiff_t>(ready_used_);
+  step_.assign(step, step + static_cast<std::ptrdiff_t>(count));
+  ready_used_ += count;
+
+  spline_.RemoveControlPoints(0U, count);
+  spline_.InsertControlPoints(spline_.ControlPoints().size(), step_);
+  first_ += count;
+
+  return true;
+}
+
+// reads the points behind the window and ready_
+auto SplineStream::Prefetch(JobSystem& jobs) -> void {
+  auto const alloc_scope = AllocScope(AllocSubsystem::kSpline);
+
+  next_first_ = first_ + spline_.ControlPoints().size() +
+                (ready_.size() - ready_used_);
+  next_.resize(std::min(chunk_, source_->Size() - next_first_));
+  prefetch_jobs_ = &jobs;
+  if (next_.empty()) {
+    return;
+  }
+
+  jobs.Spawn(prefetch_, [this]() -> void {
+    source_->Read(next_first_, next_.size(), next_.data());
+  });
+}
+
+auto SplineStream::Restart(JobSystem& jobs) -> void {
+  GOYA_PROFILE_ZONE("SplineStream::Restart");
+
+  WaitPrefetch();
+  first_ = 0U;
+  spline_.SetControlPoints(source_->Read(0U, window_));
+  ready_.clear();
+  ready_used_ = 0U;
+  Prefetch(jobs);
+}
+
+auto SplineStream::WaitPrefetch() -> void {
+  if (prefetch_jobs_ != nullptr) {
+    prefetch_jobs_->Wait(prefetch_);
+  }
+}
+
+}  // namespace goya
@@ -0,0 +1,311 @@
+#include "goya/stress_scene.hpp"
+
+#include <algorithm>
+#include <random>
+#include <stdexcept>
+#include <utility>
+
+#include "glm/gtc/matrix_transform.hpp"
+#include "goya/profiler.hpp"
+
+namespace goya {
+
+namespace detail {
+
+// splines of many models are advanced in chunks of this many paths
+static auto constexpr kPathGrain = std::size_t(256U);
+static auto constexpr kModelScale = 0.5f;
+static auto constexpr kParticleScale = 0.05f;
+
+// followers spread around their path and move at different speeds
+static auto constexpr kFollowerSpread = 2.f;
+static auto constexpr kFollowerMinSpeed = 2.f;
+static auto constexpr kFollowerMaxSpeed = 8.f;
+
+auto RandomControlPoints(std::minstd_rand& rng, std::size_t const n_points,
+                         float const extent) -> std::vector<Vertex3d> {
+  auto dis = std::uniform_real_distribution<float>(-extent, extent);
+
+  auto dst = std::vector<Vertex3d>();
+  dst.reserve(n_points);
+  for (auto i = std::size_t(0U); i < n_points; ++i) {
+    dst.emplace_back(dis(rng), dis(rng), dis(rng));
+  }
+
+  return dst;
+}
+
+}  // namespace detail
+
+StressScene::StressScene(StressConfig const& config,
+                         std::vector<MeshObjData> const& meshes,
+                         StressShaders const& shaders)
+    : config_(config) {
+  if (meshes.empty() && (config_.models != 0U || config_.followers != 0U ||
+                         config_.props != 0U)) {
+    throw std::invalid_argument("[goya::StressScene] no meshes to spawn.");
+  }
+
+  // sized for every mesh and baked prop up front, so it never has to grow
+  auto soups = std::vector<std::vector<Vertex3d>>();
+  auto n_vertices = std::size_t(0U);
+  for (auto const& mesh : meshes) {
+    n_vertices +=
+        soups.emplace_back(detail::TransformObjToVertices(mesh)).size();
+  }
+  for (auto i = std::size_t(0U); i < config_.props; ++i) {
+    n_vertices += soups[i % soups.size()].size();
+  }
+
+  arena_ = std::make_shared<GeometryArena>(n_vertices);
+  meshes_.reserve(soups.size());
+  for (auto const& soup : soups) {
+    meshes_.push_back(
+        std::make_shared<ArenaMesh>(arena_, soup, ArenaPrimitive::kTriangles));
+  }
+
+  // a uniform cubic b-spline needs four points for its first segment
+  config_.control_points = std::max(config_.control_points, std::size_t(4U));
+
+  auto rng = std::minstd_rand(config_.seed);
+  auto color_dis = std::uniform_real_distribution<float>(0.1f, 0.9f);
+
+  paths_.reserve(config_.models);
+  models_.reserve(config_.models);
+  for (auto i = std::size_t(0U); i < config_.models; ++i) {
+    paths_.emplace_back(detail::RandomControlPoints(rng, config_.control_points,
+                                                    config_.extent),
+                        nullptr);
+
+    // spread the models along their paths instead of starting in lockstep
+    paths_.back().TimeUpdate(color_dis(rng));
+
+    auto& model = models_.emplace_back(
+        std::make_shared<Model>(shaders.model, meshes_[i % meshes_.size()]));
+    model->SetColor(glm::vec3(color_dis(rng), color_dis(rng), color_dis(rng)));
+    scene_.Add(model);
+  }
+
+  // particle sources point into emitter_paths_, it must never reallocate
+  emitter_paths_.reserve(config_.effects);
+  effects_.reserve(config_.effects);
+  for (auto i = std::size_t(0U); i < config_.effects; ++i) {
+    auto& emitter = emitter_paths_.emplace_back(
+        detail::RandomControlPoints(rng, config_.control_points,
+                                    config_.extent),
+        nullptr);
+
+    auto const particle_seed =
+        config_.seed + 1U + static_cast<std::uint32_t>(i);
+    auto source = [&emitter, particle_rng = std::minstd_rand(particle_seed),
+                   dis = std::uniform_real_distribution<float>(-1.f, 1.f)]()
+        mutable -> Particle {
+      auto dst = Particle();
+      dst.position = emitter.SplineCoord();
+      dst.velocity = glm::vec3(dis(particle_rng), 2.f + dis(particle_rng),
+                               dis(particle_rng));
+      dst.color = glm::vec4(0.f, 0.22f, 0.33f, 1.f);
+      dst.life_len = 0.f;
+
+      return dst;
+    };
+
+    auto& effect = effects_.emplace_back(std::make_shared<ParticleEffect>(
+        shaders.particle, std::move(source), 1.f,
+        config_.particles_per_effect));
+    effect->SetScale(
+        glm::scale(glm::mat4(1.f), glm::vec3(detail::kParticleScale)));
+  }
+
+  if (shaders.path) {
+    path_renderer_ = std::make_unique<SplineRenderer>(shaders.path);
+    for (auto const& path : paths_) {
+      path_renderer_->AddCurve(path.ControlPoints());
+    }
+  }
+
+  if (config_.followers != 0U) {
+    SpawnFollowers(rng, meshes.front(), shaders.instanced);
+  }
+
+  if (config_.props != 0U) {
+    SpawnProps(rng, soups, shaders.model);
+  }
+}
+
+auto StressScene::Attach(Engine& engine, Camera const& camera,
+                         float const far_plane) -> void {
+  auto& jobs = engine.Jobs();
+
+  auto const paths_task = engine.AddSimulationHandler(
+      [this, &jobs](TimeType delta, FrameSnapshot& snapshot) -> void {
+        SimulatePaths(delta, snapshot, jobs);
+      });
+
+  engine.AddSimulationHandler(
+      [this, &jobs](TimeType delta, FrameSnapshot& snapshot) -> void {
+        SimulateEffects(delta, snapshot, jobs);
+      },
+      {paths_task});
+
+  engine.AddRenderHandler(
+      [this, &camera, far_plane,
+       &jobs](FrameSnapshot const& snapshot) -> void {
+        Render(snapshot, camera, far_plane, jobs);
+      });
+}
+
+auto StressScene::Config() const noexcept -> StressConfig const& {
+  return config_;
+}
+
+auto StressScene::SpawnFollowers(std::minstd_rand& rng,
+                                 MeshObjData const& mesh,
+                                 std::shared_ptr<Shader> instanced_shader)
+    -> void {
+  if (!instanced_shader) {
+    throw std::invalid_argument(
+        "[goya::StressScene] followers need an instanced shader.");
+  }
+
+  // instancing binds the vertex buffer of its own mesh, not the arena's
+  auto triangles = std::make_shared<MeshTriangle>(mesh);
+
+  auto const n_paths = std::max(config_.follower_paths, std::size_t(1U));
+  follower_paths_.reserve(n_paths);
+  for (auto i = std::size_t(0U); i < n_paths; ++i) {
+    followers_.AddPath(follower_paths_.emplace_back(
+        detail::RandomControlPoints(rng, config_.control_points,
+                                    config_.extent),
+        nullptr));
+  }
+
+  auto spread_dis = std::uniform_real_distribution<float>(
+      -detail::kFollowerSpread, detail::kFollowerSpread);
+  auto speed_dis = std::uniform_real_distribution<float>(
+      detail::kFollowerMinSpeed, detail::kFollowerMaxSpeed);
+  auto color_dis = std::uniform_real_distribution<float>(0.1f, 0.9f);
+
+  follower_instances_ = std::make_unique<InstancedModel>(
+      std::move(instanced_shader), std::move(triangles));
+  for (auto i = std::size_t(0U); i < config_.followers; ++i) {
+    auto const path = static_cast<std::uint32_t>(i % n_paths);
+    auto const start = std::uniform_real_distribution<float>(
+        0.f, follower_paths_[path].Length())(rng);
+    followers_.AddFollower(
+        path, start, speed_dis(rng),
+        glm::vec3(spread_dis(rng), spread_dis(rng), 0.f));
+    follower_instances_->AddInstance(
+        glm::mat4(1.f),
+        glm::vec3(color_dis(rng), color_dis(rng), color_dis(rng)));
+  }
+
+  followers_.SetScale(detail::kModelScale);
+}
+
+auto StressScene::SpawnProps(std::minstd_rand& rng,
+                             std::vector<std::vector<Vertex3d>> const& soups,
+                             std::shared_ptr<Shader> shader) -> void {
+  auto pos_dis =
+      std::uniform_real_distribution<float>(-config_.extent, config_.extent);
+  auto angle_dis = std::uniform_real_distribution<float>(0.f, 360.f);
+
+  prop_batch_ = std::make_unique<ArenaBatch>(std::move(shader), arena_,
+                                             ArenaPrimitive::kTriangles);
+  props_.reserve(config_.props);
+  auto baked = std::vector<Vertex3d>();
+  for (auto i = std::size_t(0U); i < config_.props; ++i) {
+    auto transform = glm::translate(
+        glm::mat4(1.f), glm::vec3(pos_dis(rng), pos_dis(rng), pos_dis(rng)));
+    transform = glm::rotate(transform, glm::radians(angle_dis(rng)),
+                            glm::vec3(0.f, 1.f, 0.f));
+    transform = glm::scale(transform, glm::vec3(detail::kModelScale));
+
+    auto const& soup = soups[i % soups.size()];
+    baked.resize(soup.size());
+    std::transform(soup.begin(), soup.end(), baked.begin(),
+                   [&transform](Vertex3d const& vertex) -> Vertex3d {
+                     return glm::vec3(transform * glm::vec4(vertex, 1.f));
+                   });
+
+    prop_batch_->Add(*props_.emplace_back(std::make_unique<ArenaMesh>(
+        arena_, baked, ArenaPrimitive::kTriangles)));
+  }
+}
+
+auto StressScene::SimulatePaths(TimeType const delta, FrameSnapshot& snapshot,
+                                JobSystem& jobs) -> void {
+  GOYA_PROFILE_ZONE("StressScene::SimulatePaths");
+
+  snapshot.transforms.resize(paths_.size());
+  jobs.ParallelFor(
+      0U, paths_.size(), detail::kPathGrain,
+      [&](std::size_t first, std::size_t last) -> void {
+        for (auto i = first; i < last; ++i) {
+          paths_[i].TimeUpdate(delta);
+          snapshot.transforms[i] =
+              glm::scale(paths_[i].ModelMatrix(),
+                         glm::vec3(detail::kModelScale));
+        }
+      });
+
+  // emitters only move, the effects read them in the dependent task
+  for (auto& emitter : emitter_paths_) {
+    emitter.TimeUpdate(delta);
+  }
+}
+
+auto StressScene::SimulateEffects(TimeType const delta,
+                                  FrameSnapshot& snapshot, JobSystem& jobs)
+    -> void {
+  GOYA_PROFILE_ZONE("StressScene::SimulateEffects");
+
+  snapshot.particles.resize(effects_.size());
+  for (auto i = std::size_t(0U); i < effects_.size(); ++i) {
+    effects_[i]->Update(delta, jobs);
+    effects_[i]->Capture(snapshot.particles[i]);
+  }
+}
+
+auto StressScene::Render(FrameSnapshot const& snapshot, Camera const& camera,
+                         float const far_plane, JobSystem& jobs) -> void {
+  GOYA_PROFILE_ZONE("StressScene::Render");
+
+  // written straight into the instance buffer, so it runs next to the draw
+  if (follower_instances_) {
+    followers_.Update(snapshot.delta, jobs, *follower_instances_);
+  }
+
+  for (auto i = std::size_t(0U); i < models_.size(); ++i) {
+    models_[i]->SetModelMatrix(snapshot.transforms[i]);
+  }
+
+  for (auto i = std::size_t(0U); i < effects_.size(); ++i) {
+    effects_[i]->Upload(snapshot.particles[i]);
+  }
+
+  scene_.Update();
+  scene_.Cull(camera);
+
+  queue_.SetView(camera.Position(), camera.Front(), far_plane);
+  scene_.Submit(queue_);
+  for (auto& effect : effects_) {
+    effect->Submit(queue_);
+  }
+
+  if (path_renderer_) {
+    path_renderer_->Submit(queue_);
+  }
+
+  if (follower_instances_) {
+    follower_instances_->Submit(queue_);
+  }
+
+  if (prop_batch_) {
+    prop_batch_->Submit(queue_);
+  }
+
+  queue_.Execute();
+}
+
+}  // namespace goya
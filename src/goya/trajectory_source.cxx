@@ -0,0 +1,226 @@
+#include "goya/trajectory_source.hpp"
+
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "goya/alloc_tracker.hpp"
+#include "goya/profiler.hpp"
+
+namespace goya {
+
+namespace detail {
+
+// points per entry of the text index
+static auto constexpr kIndexStride = std::size_t(1024U);
+
+static auto constexpr kBinaryHeader =
+    sizeof(TrajectorySource::kBinaryMagic) + sizeof(std::uint64_t);
+
+static_assert(sizeof(Vertex3d) == 3U * sizeof(float),
+              "binary trajectories are copied point by point");
+
+// the characters operator>> skips
+auto IsSpace(char const c) -> bool {
+  return c == ' ' || (c >= '\t' && c <= '\r');
+}
+
+auto SkipSpace(char const* first, char const* last) -> char const* {
+  while (first != last && IsSpace(*first)) {
+    ++first;
+  }
+  return first;
+}
+
+auto SkipToken(char const* first, char const* last) -> char const* {
+  while (first != last && !IsSpace(*first)) {
+    ++first;
+  }
+  return first;
+}
+
+// from_chars rejects the leading plus operator>> takes
+auto ParseFloat(char const*& first, char const* last) -> float {
+  if (first != last && *first == '+') {
+    ++first;
+  }
+
+  auto value = 0.f;
+  auto const [ptr, ec] = std::from_chars(first, last, value);
+  if (ec != std::errc()) {
+    throw std::runtime_error("[goya::TrajectorySource] malformed number.");
+  }
+
+  first = ptr;
+  return value;
+}
+
+}  // namespace detail
+
+TrajectorySource::TrajectorySource(std::string const& path) {
+  GOYA_PROFILE_ZONE("TrajectorySource::Open");
+  auto const alloc_scope = AllocScope(AllocSubsystem::kSpline);
+
+#if defined(__unix__) || defined(__APPLE__)
+  auto const fd = ::open(path.c_str(), O_RDONLY);
+  if (fd < 0) {
+    throw std::runtime_error("[goya::TrajectorySource] failed to open " +
+                             path);
+  }
+
+  struct stat info {};
+  if (::fstat(fd, &info) != 0) {
+    ::close(fd);
+    throw std::runtime_error("[goya::TrajectorySource] failed to stat " +
+                             path);
+  }
+
+  size_ = static_cast<std::size_t>(info.st_size);
+  if (size_ != 0U) {
+    auto const mapped = ::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (mapped == MAP_FAILED) {
+      ::close(fd);
+      throw std::runtime_error("[goya::TrajectorySource] failed to map " +
+                               path);
+    }
+    data_ = static_cast<char const*>(mapped);
+  }
+
+  // the mapping keeps its own reference to the file
+  ::close(fd);
+#else
+  auto ifstrm = std::ifstream(path, std::ios::binary);
+  if (!ifstrm) {
+    throw std::runtime_error("[goya::TrajectorySource] failed to open " +
+                             path);
+  }
+
+  buffer_.assign(std::istreambuf_iterator<char>(ifstrm),
+                 std::istreambuf_iterator<char>());
+  data_ = buffer_.data();
+  size_ = buffer_.size();
+#endif
+
+  binary_ = size_ >= detail::kBinaryHeader &&
+            std::memcmp(data_, kBinaryMagic, sizeof(kBinaryMagic)) == 0;
+  if (!binary_) {
+    IndexText();
+    return;
+  }
+
+  auto count = std::uint64_t(0U);
+  std::memcpy(&count, data_ + sizeof(kBinaryMagic), sizeof(count));
+  if (count > (size_ - detail::kBinaryHeader) / sizeof(Vertex3d)) {
+    Unmap();
+    throw std::runtime_error(
+        "[goya::TrajectorySource] truncated binary trajectory " + path);
+  }
+  n_points_ = static_cast<std::size_t>(count);
+}
+
+TrajectorySource::~TrajectorySource() { Unmap(); }
+
+auto TrajectorySource::Size() const noexcept -> std::size_t {
+  return n_points_;
+}
+
+auto TrajectorySource::IsBinary() const noexcept -> bool { return binary_; }
+
+auto TrajectorySource::Read(std::size_t first, std::size_t count,
+                            Vertex3d* dst) const -> std::size_t {
+  GOYA_PROFILE_ZONE("TrajectorySource::Read");
+
+  first = std::min(first, n_points_);
+  count = std::min(count, n_points_ - first);
+  if (count == 0U) {
+    return 0U;
+  }
+
+  if (binary_) {
+    std::memcpy(dst, data_ + detail::kBinaryHeader + first * sizeof(Vertex3d),
+                count * sizeof(Vertex3d));
+    return count;
+  }
+
+  auto const last = data_ + size_;
+  auto it = data_ + index_[first / detail::kIndexStride];
+  for (auto skip = first % detail::kIndexStride * 3U; skip != 0U; --skip) {
+    it = detail::SkipToken(detail::SkipSpace(it, last), last);
+  }
+
+  for (auto i = std::size_t(0U); i < count; ++i) {
+    for (auto axis = 0; axis < 3; ++axis) {
+      it = detail::SkipSpace(it, last);
+      dst[i][axis] = detail::ParseFloat(it, last);
+    }
+  }
+
+  return count;
+}
+
+auto TrajectorySource::Read(std::size_t first, std::size_t count) const
+    -> std::vector<Vertex3d> {
+  auto const alloc_scope = AllocScope(AllocSubsystem::kSpline);
+
+  first = std::min(first, n_points_);
+  auto dst = std::vector<Vertex3d>(std::min(count, n_points_ - first));
+  Read(first, dst.size(), dst.data());
+
+  return dst;
+}
+
+auto TrajectorySource::WriteBinary(std::string const& path,
+                                   std::vector<Vertex3d> const& points)
+    -> void {
+  auto ofstrm = std::ofstream(path, std::ios::binary);
+  auto const count = static_cast<std::uint64_t>(points.size());
+  ofstrm.write(kBinaryMagic, sizeof(kBinaryMagic));
+  ofstrm.write(reinterpret_cast<char const*>(&count), sizeof(count));
+  ofstrm.write(reinterpret_cast<char const*>(points.data()),
+               static_cast<std::streamsize>(points.size() * sizeof(Vertex3d)));
+
+  if (!ofstrm) {
+    throw std::runtime_error("[goya::TrajectorySource] failed to write " +
+                             path);
+  }
+}
+
+auto TrajectorySource::Unmap() noexcept -> void {
+#if defined(__unix__) || defined(__APPLE__)
+  if (data_ != nullptr) {
+    ::munmap(const_cast<char*>(data_), size_);
+  }
+#endif
+  data_ = nullptr;
+}
+
+// a single pass over the tokens counts the points and remembers where every
+// kIndexStride-th one starts, nothing is parsed yet
+auto TrajectorySource::IndexText() -> void {
+  auto constexpr kTokens = detail::kIndexStride * 3U;
+
+  auto const last = data_ + size_;
+  auto n_tokens = std::size_t(0U);
+  for (auto it = detail::SkipSpace(data_, last); it != last;
+       it = detail::SkipSpace(it, last)) {
+    if (n_tokens % kTokens == 0U) {
+      index_.push_back(static_cast<std::uint64_t>(it - data_));
+    }
+    ++n_tokens;
+    it = detail::SkipToken(it, last);
+  }
+
+  n_points_ = n_tokens / 3U;
+}
+
+}  // namespace goya
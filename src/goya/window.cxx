@@ -1,15 +1,47 @@
 #include "goya/window.hpp"
 
+#include <cstdlib>
 #include <stdexcept>
 #include <type_traits>
 
+#include "goya/alloc_tracker.hpp"
+#include "goya/gl_state.hpp"
+#include "goya/profiler.hpp"
+
 namespace goya {
 
-Window::Window(std::int32_t width, std::int32_t height, std::string title)
-    : title_(std::move(title)) {
+namespace detail {
+
+auto HasDisplay() -> bool {
+  return std::getenv("DISPLAY") != nullptr ||
+         std::getenv("WAYLAND_DISPLAY") != nullptr;
+}
+
+// ns per fence wait, the wait is repeated until the fence signals
+static auto constexpr kFenceTimeout = GLuint64(1000000U);
+
+}  // namespace detail
+
+Window::Window(std::int32_t width, std::int32_t height, std::string title,
+               WindowMode mode)
+    : title_(std::move(title)),
+      mode_(mode),
+      fbo_(0U),
+      rbo_color_(0U),
+      rbo_depth_(0U),
+      frame_limit_(FrameLimit::kNone),
+      max_queued_(1U),
+      poll_delta_(0.f) {
   gb_.width_ = width;
   gb_.height_ = height;
 
+#ifdef GLFW_PLATFORM_NULL
+  // without a display glfw 3.4 can still create an OSMesa context
+  if (mode_ == WindowMode::kHeadless && !detail::HasDisplay()) {
+    glfwInitHint(GLFW_PLATFORM, GLFW_PLATFORM_NULL);
+  }
+#endif
+
   glewExperimental = true;  // core profile
   if (!glfwInit()) {
     throw std::runtime_error("[goya::Window] failed to initialize glfw");
@@ -23,6 +55,15 @@ Window::Window(std::int32_t width, std::int32_t height, std::string title)
   glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
 #endif
 
+  if (mode_ == WindowMode::kHeadless) {
+    glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+#ifdef GLFW_PLATFORM_NULL
+    if (!detail::HasDisplay()) {
+      glfwWindowHint(GLFW_CONTEXT_CREATION_API, GLFW_OSMESA_CONTEXT_API);
+    }
+#endif
+  }
+
   win_ptr_ = glfwCreateWindow(width, height, title_.c_str(), nullptr, nullptr);
 
   if (win_ptr_ == nullptr) {
@@ -30,12 +71,19 @@ Window::Window(std::int32_t width, std::int32_t height, std::string title)
   }
 
   glfwMakeContextCurrent(win_ptr_);
+  // the cache is global, what it knows belongs to an earlier context
+  GlState().Invalidate();
   if (glewInit()) {
     throw std::runtime_error("[goya::Window] failed to initialize glew.");
   }
 
-  glfwSetInputMode(win_ptr_, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
-  glEnable(GL_DEPTH_TEST);
+  if (mode_ == WindowMode::kHeadless) {
+    CreateOffscreenTarget();
+  } else {
+    glfwSetInputMode(win_ptr_, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
+  }
+
+  GlState().SetDepthTest(true);
 
   // set callbacks
   glfwSetWindowUserPointer(win_ptr_, &gb_);
@@ -49,42 +97,164 @@ Window::Window(std::int32_t width, std::int32_t height, std::string title)
   auto const key_callback_lambda =
       [](GLFWwindow* win_ptr, std::int32_t key, std::int32_t scancode,
          std::int32_t action, std::int32_t mods) -> void {
-    static_cast<GlfwBridge*>(glfwGetWindowUserPointer(win_ptr))
-        ->key_events_.push_back(KeyEvent(key, action));
+    auto& gb = *static_cast<GlfwBridge*>(glfwGetWindowUserPointer(win_ptr));
+
+    auto event = InputEvent();
+    event.type = InputEventType::kKey;
+    event.key = key;
+    event.action = action;
+    gb.Push(event);
   };
 
   auto const cursor_callback_lambda = [](GLFWwindow* win_ptr, double xpos,
                                          double ypos) -> void {
-    static_cast<GlfwBridge*>(glfwGetWindowUserPointer(win_ptr))
-        ->cursor_events_.push_back(CursorEvent(xpos, ypos));
+    auto& gb = *static_cast<GlfwBridge*>(glfwGetWindowUserPointer(win_ptr));
+
+    auto event = InputEvent();
+    event.type = InputEventType::kCursor;
+    event.x_pos = xpos;
+    event.y_pos = ypos;
+    gb.Push(event);
   };
 
   glfwSetFramebufferSizeCallback(win_ptr_, resize_callback_lambda);
   glfwSetKeyCallback(win_ptr_, key_callback_lambda);
   glfwSetCursorPosCallback(win_ptr_, cursor_callback_lambda);
 
-  prev_refresh_ = glfwGetTime();
+  // the first cursor event moves relative to where the cursor starts
+  auto const [x_pos, y_pos] = CursorPosition();
+  ResetInput(x_pos, y_pos);
+
+  prev_poll_ = glfwGetTime();
+  present_time_ = prev_poll_;
 }
 
 auto Window::Refresh() -> bool {
-  glfwSwapBuffers(win_ptr_);
-  glfwPollEvents();
+  GOYA_PROFILE_ZONE("Window::Refresh");
+
+  Present();
+  BeginFrame();
+  return PollInput();
+}
+
+auto Window::Present() -> void {
+  GOYA_PROFILE_ZONE("Window::Present");
+
+  if (mode_ == WindowMode::kHeadless) {
+    // nothing presents, finishing keeps the cpu from queueing frames ahead
+    // and makes frame times include the gpu work
+    glFinish();
+  } else {
+    glfwSwapBuffers(win_ptr_);
+    LimitFrames();
+  }
+
+  present_time_ = glfwGetTime();
+}
+
+auto Window::BeginFrame() -> void {
+  auto const alloc_scope = AllocScope(AllocSubsystem::kWindow);
+
+  gb_.BeginFrame();
+
+  GlobalProfiler().BeginFrame();
+  GlState().BeginFrame();
+  GOYA_PROFILE_COUNTER("GlState::issued", GlState().FrameStats().issued);
+  GOYA_PROFILE_COUNTER("GlState::skipped", GlState().FrameStats().skipped);
+
+  GlobalAllocTracker().BeginFrame();
+  GOYA_PROFILE_COUNTER("Alloc::allocations",
+                       GlobalAllocTracker().FrameStats().allocations);
+  GOYA_PROFILE_COUNTER("Alloc::bytes", GlobalAllocTracker().FrameStats().bytes);
+  GOYA_PROFILE_COUNTER("Alloc::frame_arena", gb_.frame_arena_.HighWater());
 
   glClearColor(1.0f, 1.0f, 1.0f, 1.0f);
   glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+}
+
+// events are stored in frame memory, so they are only taken between one
+// BeginFrame() and the next
+auto Window::PollInput() -> bool {
+  GOYA_PROFILE_ZONE("Window::PollInput");
+  auto const alloc_scope = AllocScope(AllocSubsystem::kWindow);
+
+  gb_.input_.BeginFrame();
+  gb_.poll_time_ = glfwGetTime();
+  glfwPollEvents();
 
   auto const curr_time = glfwGetTime();
-  auto const delta = static_cast<float>(curr_time - prev_refresh_);
+  auto const delta = static_cast<float>(curr_time - prev_poll_);
 
   gb_.CallKeyEventHandlers(delta);
   gb_.CallCursorEventHandlers(delta);
   gb_.CallAnimationHandlers(delta);
 
-  prev_refresh_ = curr_time;
+  prev_poll_ = curr_time;
+  poll_delta_ = delta;
+  GOYA_PROFILE_COUNTER("Window::input_events", gb_.input_.EventCount());
+
+  return !glfwWindowShouldClose(win_ptr_);
+}
+
+auto Window::ReplayInput(std::vector<InputEvent> const& events,
+                         TimeType const poll_delta) -> bool {
+  GOYA_PROFILE_ZONE("Window::ReplayInput");
+  auto const alloc_scope = AllocScope(AllocSubsystem::kWindow);
+
+  // live events still arrive, so the window can be closed, but are dropped
+  gb_.replaying_ = true;
+  glfwPollEvents();
+  gb_.replaying_ = false;
+
+  gb_.input_.BeginFrame();
+  gb_.poll_time_ = glfwGetTime();
+  for (auto const& event : events) {
+    gb_.Deliver(event);
+  }
+
+  gb_.CallKeyEventHandlers(poll_delta);
+  gb_.CallCursorEventHandlers(poll_delta);
+  gb_.CallAnimationHandlers(poll_delta);
+
+  prev_poll_ = glfwGetTime();
+  poll_delta_ = poll_delta;
+  GOYA_PROFILE_COUNTER("Window::input_events", gb_.input_.EventCount());
 
   return !glfwWindowShouldClose(win_ptr_);
 }
 
+auto Window::ResetInput(double const x_pos, double const y_pos) -> void {
+  gb_.input_.Reset();
+
+  auto start = InputEvent();
+  start.type = InputEventType::kCursor;
+  start.x_pos = x_pos;
+  start.y_pos = y_pos;
+  gb_.input_.Apply(start);
+}
+
+auto Window::SetFrameLimit(FrameLimit limit, std::uint32_t max_queued)
+    -> void {
+  frame_limit_ = limit;
+  max_queued_ = max_queued;
+}
+
+auto Window::PollTime() const noexcept -> double { return prev_poll_; }
+
+auto Window::PresentTime() const noexcept -> double { return present_time_; }
+
+auto Window::Input() const noexcept -> InputState const& { return gb_.input_; }
+
+auto Window::PollDelta() const noexcept -> TimeType { return poll_delta_; }
+
+auto Window::SetInputQueue(InputQueue* queue) noexcept -> void {
+  gb_.input_queue_ = queue;
+}
+
+auto Window::DroppedInputEvents() const noexcept -> std::uint64_t {
+  return gb_.dropped_events_;
+}
+
 auto Window::Width() const noexcept -> std::int32_t { return gb_.width_; }
 
 auto Window::Height() const noexcept -> std::int32_t { return gb_.height_; }
@@ -104,6 +274,14 @@ auto Window::Title() const -> std::string const& { return title_; }
 
 auto Window::WinPtr() -> GLFWwindow* { return win_ptr_; }
 
+auto Window::Mode() const noexcept -> WindowMode { return mode_; }
+
+auto Window::Framebuffer() const noexcept -> std::uint32_t { return fbo_; }
+
+auto Window::FrameMemory() noexcept -> FrameArena& {
+  return gb_.frame_arena_;
+}
+
 auto Window::AddKeyHandler(KeyEventHandler key_handler) -> void {
   gb_.key_handlers_.push_back(std::move(key_handler));
 }
@@ -122,8 +300,105 @@ auto Window::AddAnimationHandler(AnimationHandler animation_handler) -> void {
 }
 
 Window::~Window() {
+  GlobalProfiler().ReleaseGpu();
+
+  for (auto const fence : fences_) {
+    glDeleteSync(fence);
+  }
+
+  if (fbo_ != 0U) {
+    glDeleteFramebuffers(1, &fbo_);
+    glDeleteRenderbuffers(1, &rbo_color_);
+    glDeleteRenderbuffers(1, &rbo_depth_);
+  }
+
   glfwDestroyWindow(win_ptr_);
   glfwTerminate();
+  GlState().Invalidate();
+}
+
+auto Window::CreateOffscreenTarget() -> void {
+  glfwSwapInterval(0);
+
+  glGenRenderbuffers(1, &rbo_color_);
+  glBindRenderbuffer(GL_RENDERBUFFER, rbo_color_);
+  glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, gb_.width_, gb_.height_);
+
+  glGenRenderbuffers(1, &rbo_depth_);
+  glBindRenderbuffer(GL_RENDERBUFFER, rbo_depth_);
+  glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, gb_.width_,
+                        gb_.height_);
+
+  glGenFramebuffers(1, &fbo_);
+  glBindFramebuffer(GL_FRAMEBUFFER, fbo_);
+  glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0,
+                            GL_RENDERBUFFER, rbo_color_);
+  glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT,
+                            GL_RENDERBUFFER, rbo_depth_);
+
+  if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+    throw std::runtime_error(
+        "[goya::Window] incomplete offscreen framebuffer.");
+  }
+
+  // stays bound for the lifetime of the window
+  glViewport(0, 0, gb_.width_, gb_.height_);
+}
+
+// the fence of a frame follows its swap, so once it signaled the gpu is done
+// with everything up to that present
+auto Window::LimitFrames() -> void {
+  if (frame_limit_ == FrameLimit::kFinish) {
+    glFinish();
+    return;
+  }
+
+  if (frame_limit_ != FrameLimit::kFence) {
+    return;
+  }
+
+  fences_.push_back(glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0U));
+  while (fences_.size() > max_queued_) {
+    auto const fence = fences_.front();
+    while (glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT,
+                            detail::kFenceTimeout) == GL_TIMEOUT_EXPIRED) {
+    }
+    glDeleteSync(fence);
+    fences_.erase(fences_.begin());
+  }
+}
+
+auto Window::GlfwBridge::BeginFrame() -> void {
+  // drop the storage of the last frame's events before it is reused
+  key_events_ = std::pmr::vector<KeyEvent>(&frame_arena_);
+  cursor_events_ = std::pmr::vector<CursorEvent>(&frame_arena_);
+
+  frame_arena_.Reset();
+}
+
+auto Window::GlfwBridge::Push(InputEvent const& event) -> void {
+  if (replaying_) {
+    return;
+  }
+
+  auto stamped = event;
+  stamped.time = poll_time_;
+  Deliver(stamped);
+
+  if (input_queue_ != nullptr && !input_queue_->TryPush(stamped)) {
+    ++dropped_events_;
+  }
+}
+
+auto Window::GlfwBridge::Deliver(InputEvent const& event) -> void {
+  input_.Apply(event);
+
+  if (event.type == InputEventType::kKey && !key_handlers_.empty()) {
+    key_events_.push_back(KeyEvent(event.key, event.action));
+  } else if (event.type == InputEventType::kCursor &&
+             !cursor_handlers_.empty()) {
+    cursor_events_.push_back(CursorEvent(event.x_pos, event.y_pos));
+  }
 }
 
 auto Window::GlfwBridge::ResizeCallback(std::int32_t const width,
@@ -1,44 +1,556 @@
+#include <algorithm>
+#include <array>
+#include <chrono>
 #include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
 #include <iostream>
 #include <memory>
+#include <numeric>
 #include <random>
 #include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
 
+#ifdef __linux__
+#include <unistd.h>
+#endif
+
+#include "goya/alloc_tracker.hpp"
 #include "goya/b_spline.hpp"
 #include "goya/camera.hpp"
-#include "goya/mesh.hpp"
+#include "goya/camera_path.hpp"
+#include "goya/engine.hpp"
+#include "goya/frame_capture.hpp"
+#include "goya/geometry_arena.hpp"
+#include "goya/input_log.hpp"
 #include "goya/mesh_loader.hpp"
 #include "goya/model.hpp"
 #include "goya/particles.hpp"
+#include "goya/profiler.hpp"
+#include "goya/render_queue.hpp"
+#include "goya/scene.hpp"
 #include "goya/shader.hpp"
+#include "goya/spline_stream.hpp"
+#include "goya/stress_scene.hpp"
+#include "goya/trajectory_source.hpp"
 #include "goya/window.hpp"
 
+namespace detail {
+
+struct Options {
+  std::string model_path;
+  std::string spline_path;
+
+  bool headless = false;
+  std::uint64_t frames = 0U;
+  goya::TimeType dt = 0.f;
+
+  // world units per second along the spline, 0 keeps the per segment pace
+  float speed = 0.f;
+
+  // keep only a window of the spline resident, for long trajectories
+  bool stream = false;
+
+  // control points of a camera path, the run flies along it once
+  std::string flythrough_path;
+
+  // every rendered frame is written to capture_dir when set
+  std::string capture_dir;
+  goya::CaptureFormat capture_format = goya::CaptureFormat::kPng;
+  std::uint32_t capture_lag = 3U;
+
+  // simulate in fixed steps and interpolate, implied by record and replay
+  bool fixed_step = false;
+  std::uint64_t seed = 42U;
+  std::string record_path;
+  std::string replay_path;
+
+  goya::InputSampling input_sampling = goya::InputSampling::kLate;
+  goya::FrameLimit frame_limit = goya::FrameLimit::kNone;
+  std::uint32_t max_queued = 1U;
+
+  bool profile = false;
+  std::string trace_path;
+
+  // stress mode sweeps models x effects up to these counts
+  bool stress = false;
+  std::size_t stress_models = 1000U;
+  std::size_t stress_effects = 16U;
+  std::size_t stress_particles = 1000U;
+  std::size_t stress_followers = 0U;
+  std::size_t stress_props = 0U;
+  bool stress_paths = false;
+  std::string csv_path = "stress.csv";
+  std::string resources_dir = "resources";
+};
+
+auto constexpr kUsage =
+    "[goya] usage: goya <model path> <spline control points path> "
+    "[--headless] [--frames N] [--dt seconds] [--speed units] [--stream] "
+    "[--flythrough path] [--fixed-step] [--seed N] [--record path] "
+    "[--replay path] [--capture dir] [--capture-format png|raw] "
+    "[--capture-lag N] [--input start|late] "
+    "[--frame-limit none|finish|fence] [--max-queued N] [--profile] "
+    "[--trace path]\n"
+    "       goya --stress [--models N] [--effects N] [--particles N] "
+    "[--followers N] [--props N] [--paths] [--csv path] [--resources dir] "
+    "[--headless] [--frames N] [--dt seconds]";
+
+// threads encoding captured frames
+auto constexpr kCaptureWorkers = std::size_t(2U);
+
+// frames rendered before a stress step starts measuring
+auto constexpr kStressWarmUpFrames = std::uint64_t(60U);
+
+auto ParseOptions(int argc, char** argv) -> Options {
+  auto dst = Options();
+  auto positional = std::vector<std::string>();
+
+  for (auto i = 1; i < argc; ++i) {
+    auto const arg = std::string(argv[i]);
+    auto const value = [&]() -> std::string {
+      if (i + 1 >= argc) {
+        throw std::runtime_error(kUsage);
+      }
+
+      return argv[++i];
+    };
+
+    if (arg == "--headless") {
+      dst.headless = true;
+    } else if (arg == "--frames") {
+      dst.frames = std::stoull(value());
+    } else if (arg == "--dt") {
+      dst.dt = std::stof(value());
+    } else if (arg == "--speed") {
+      dst.speed = std::stof(value());
+    } else if (arg == "--stream") {
+      dst.stream = true;
+    } else if (arg == "--flythrough") {
+      dst.flythrough_path = value();
+    } else if (arg == "--capture") {
+      dst.capture_dir = value();
+    } else if (arg == "--capture-format") {
+      auto const format = value();
+      if (format != "png" && format != "raw") {
+        throw std::runtime_error(kUsage);
+      }
+      dst.capture_format = format == "png" ? goya::CaptureFormat::kPng
+                                           : goya::CaptureFormat::kRaw;
+    } else if (arg == "--capture-lag") {
+      dst.capture_lag = static_cast<std::uint32_t>(std::stoul(value()));
+    } else if (arg == "--fixed-step") {
+      dst.fixed_step = true;
+    } else if (arg == "--seed") {
+      dst.seed = std::stoull(value());
+    } else if (arg == "--record") {
+      dst.record_path = value();
+    } else if (arg == "--replay") {
+      dst.replay_path = value();
+    } else if (arg == "--input") {
+      auto const mode = value();
+      if (mode != "start" && mode != "late") {
+        throw std::runtime_error(kUsage);
+      }
+      dst.input_sampling = mode == "start" ? goya::InputSampling::kFrameStart
+                                           : goya::InputSampling::kLate;
+    } else if (arg == "--frame-limit") {
+      auto const limit = value();
+      if (limit == "none") {
+        dst.frame_limit = goya::FrameLimit::kNone;
+      } else if (limit == "finish") {
+        dst.frame_limit = goya::FrameLimit::kFinish;
+      } else if (limit == "fence") {
+        dst.frame_limit = goya::FrameLimit::kFence;
+      } else {
+        throw std::runtime_error(kUsage);
+      }
+    } else if (arg == "--max-queued") {
+      dst.max_queued = static_cast<std::uint32_t>(std::stoul(value()));
+    } else if (arg == "--profile") {
+      dst.profile = true;
+    } else if (arg == "--trace") {
+      dst.trace_path = value();
+    } else if (arg == "--stress") {
+      dst.stress = true;
+    } else if (arg == "--models") {
+      dst.stress_models = std::stoull(value());
+    } else if (arg == "--effects") {
+      dst.stress_effects = std::stoull(value());
+    } else if (arg == "--particles") {
+      dst.stress_particles = std::stoull(value());
+    } else if (arg == "--followers") {
+      dst.stress_followers = std::stoull(value());
+    } else if (arg == "--props") {
+      dst.stress_props = std::stoull(value());
+    } else if (arg == "--paths") {
+      dst.stress_paths = true;
+    } else if (arg == "--csv") {
+      dst.csv_path = value();
+    } else if (arg == "--resources") {
+      dst.resources_dir = value();
+    } else if (arg.rfind("--", 0U) == 0U) {
+      throw std::runtime_error(kUsage);
+    } else {
+      positional.push_back(arg);
+    }
+  }
+
+  if (dst.stress) {
+    // scaling curves compare steps, every one gets the same fixed timestep
+    dst.frames = dst.frames == 0U ? 300U : dst.frames;
+    dst.dt = dst.dt == 0.f ? 1.f / 60.f : dst.dt;
+    return dst;
+  }
+
+  if (positional.size() != 2U) {
+    throw std::runtime_error(kUsage);
+  }
+
+  dst.model_path = positional[0];
+  dst.spline_path = positional[1];
+
+  if (!dst.record_path.empty() && !dst.replay_path.empty()) {
+    throw std::runtime_error(kUsage);
+  }
+
+  // a headless run or a fly-through is a benchmark, make it reproducible by
+  // default
+  if (dst.headless || !dst.flythrough_path.empty()) {
+    dst.frames = dst.frames == 0U ? 600U : dst.frames;
+    dst.dt = dst.dt == 0.f ? 1.f / 60.f : dst.dt;
+  }
+
+  return dst;
+}
+
+auto PrintFrameTimes(std::vector<float> const& frame_times) -> void {
+  if (frame_times.empty()) {
+    return;
+  }
+
+  for (auto i = std::size_t(0U); i < frame_times.size(); ++i) {
+    std::cout << "frame " << i + 1U << ' ' << frame_times[i] << " ms\n";
+  }
+
+  auto const [min, max] =
+      std::minmax_element(frame_times.begin(), frame_times.end());
+  auto const total =
+      std::accumulate(frame_times.begin(), frame_times.end(), 0.0);
+
+  std::cout << "frames " << frame_times.size() << " mean "
+            << total / static_cast<double>(frame_times.size()) << " ms min "
+            << *min << " ms max " << *max << " ms" << std::endl;
+}
+
+// 1, 4, 16, ... below max and max itself
+auto SweepCounts(std::size_t const max) -> std::vector<std::size_t> {
+  auto dst = std::vector<std::size_t>();
+  for (auto count = std::size_t(1U); count < max; count *= 4U) {
+    dst.push_back(count);
+  }
+
+  dst.push_back(max);
+  return dst;
+}
+
+auto Percentile(std::vector<float> values, double const fraction) -> float {
+  if (values.empty()) {
+    return 0.f;
+  }
+
+  auto const idx = static_cast<std::size_t>(
+      fraction * static_cast<double>(values.size() - 1U));
+  auto const nth = values.begin() + static_cast<std::ptrdiff_t>(idx);
+  std::nth_element(values.begin(), nth, values.end());
+
+  return *nth;
+}
+
+auto PrintFramePercentiles(std::vector<float> const& frame_times) -> void {
+  if (frame_times.empty()) {
+    return;
+  }
+
+  std::cout << "frame time p50 " << Percentile(frame_times, 0.5)
+            << " ms p95 " << Percentile(frame_times, 0.95) << " ms p99 "
+            << Percentile(frame_times, 0.99) << " ms" << std::endl;
+}
+
+auto PrintInputLatencies(std::vector<float> const& latencies) -> void {
+  if (latencies.empty()) {
+    return;
+  }
+
+  std::cout << "input to present p50 " << Percentile(latencies, 0.5)
+            << " ms p95 " << Percentile(latencies, 0.95) << " ms p99 "
+            << Percentile(latencies, 0.99) << " ms" << std::endl;
+}
+
+// resident set size, 0 on platforms without /proc
+auto ResidentBytes() -> std::size_t {
+#ifdef __linux__
+  auto ifstrm = std::ifstream("/proc/self/statm");
+  auto total_pages = std::size_t(0U);
+  auto resident_pages = std::size_t(0U);
+  if (ifstrm >> total_pages >> resident_pages) {
+    return resident_pages * static_cast<std::size_t>(sysconf(_SC_PAGESIZE));
+  }
+#endif
+
+  return 0U;
+}
+
+auto LoadStressMeshes(std::string const& resources_dir)
+    -> std::vector<goya::MeshObjData> {
+  auto paths = std::vector<std::filesystem::path>();
+  for (auto const& entry :
+       std::filesystem::directory_iterator(resources_dir + "/mesh")) {
+    if (entry.path().extension() == ".obj") {
+      paths.push_back(entry.path());
+    }
+  }
+
+  // sorted, so the n-th model gets the same mesh in every run
+  std::sort(paths.begin(), paths.end());
+
+  auto dst = std::vector<goya::MeshObjData>();
+  for (auto const& path : paths) {
+    dst.push_back(goya::LoadMeshObjData(path.string()));
+  }
+
+  return dst;
+}
+
+// cpu zones reported per stress step, in csv column order
+using StressColumn = std::pair<char const*, char const*>;
+auto constexpr kStressZones = std::array<StressColumn, 8U>{{
+    {"simulate_ms", "Engine::Simulate"},
+    {"paths_ms", "StressScene::SimulatePaths"},
+    {"effects_ms", "StressScene::SimulateEffects"},
+    {"followers_ms", "SplineFollowers::Update"},
+    {"render_ms", "Engine::Render"},
+    {"scene_update_ms", "Scene::Update"},
+    {"scene_cull_ms", "Scene::Cull"},
+    {"render_queue_ms", "RenderQueue::Execute"},
+}};
+
+// Sweeps the model and effect counts of a procedural scene and writes one csv
+// row per step. Cpu times come from the profiler zones, gpu time is the sum
+// of all gpu zones.
+auto RunStress(Options const& options) -> void {
+  auto& profiler = goya::GlobalProfiler();
+  profiler.SetEnabled(true);
+
+  auto win = goya::Window(1080, 720, "Goya stress",
+                          options.headless ? goya::WindowMode::kHeadless
+                                           : goya::WindowMode::kWindowed);
+
+  auto shaders = goya::StressShaders();
+  shaders.model =
+      std::make_shared<goya::Shader>("shaders/model.vs", "shaders/model.fs");
+  shaders.particle = std::make_shared<goya::Shader>("shaders/particle.vs",
+                                                    "shaders/particle.fs");
+  shaders.instanced = std::make_shared<goya::Shader>("shaders/instanced.vs",
+                                                     "shaders/instanced.fs");
+
+  // paths are tessellated on the gpu, only their control points are uploaded
+  if (options.stress_paths) {
+    shaders.path = std::make_shared<goya::Shader>(
+        "shaders/spline.vs", "shaders/spline.tcs", "shaders/spline.tes",
+        "shaders/model.fs");
+  }
+
+  auto const meshes = LoadStressMeshes(options.resources_dir);
+
+  auto constexpr kFarPlane = 200.f;
+  auto const camera_pos = glm::vec3(0.f, 20.f, 60.f);
+  auto camera = goya::Camera(
+      camera_pos, glm::normalize(-camera_pos), glm::vec3(0.f, 1.f, 0.f),
+      glm::perspective(glm::radians(90.f), win.AspectRatio(), 0.1f,
+                       kFarPlane));
+  camera.AddShader(shaders.model);
+  camera.AddShader(shaders.particle);
+  camera.AddShader(shaders.instanced);
+  if (shaders.path) {
+    camera.AddShader(shaders.path);
+  }
+  camera.Refresh();
+
+  auto csv = std::ofstream(options.csv_path);
+  if (!csv.is_open()) {
+    throw std::runtime_error("[goya] failed to open " + options.csv_path);
+  }
+
+  csv << "models,effects,particles_per_effect,followers,props,frames,"
+         "frame_ms_mean,frame_ms_p50,frame_ms_p95,frame_ms_p99,frame_ms_max";
+  for (auto const& [column, zone] : kStressZones) {
+    csv << ',' << column;
+  }
+  csv << ",gpu_ms,allocs_per_frame,alloc_bytes_per_frame,rss_mb\n";
+
+  for (auto const n_models : SweepCounts(options.stress_models)) {
+    for (auto const n_effects : SweepCounts(options.stress_effects)) {
+      auto stress_config = goya::StressConfig();
+      stress_config.models = n_models;
+      stress_config.effects = n_effects;
+      stress_config.particles_per_effect = options.stress_particles;
+      stress_config.followers = options.stress_followers;
+      stress_config.props = options.stress_props;
+
+      auto stress = goya::StressScene(stress_config, meshes, shaders);
+
+      auto engine_config = goya::EngineConfig();
+      engine_config.simulation_mode = goya::SimulationMode::kInline;
+      engine_config.fixed_delta = options.dt;
+      engine_config.max_frames = kStressWarmUpFrames + options.frames;
+
+      auto engine = goya::Engine(win, engine_config);
+      stress.Attach(engine, camera, kFarPlane);
+
+      // measurement starts once the particle populations reached steady state
+      auto allocs_before = goya::AllocStats();
+      auto rendered = std::uint64_t(0U);
+      engine.AddRenderHandler([&](goya::FrameSnapshot const&) -> void {
+        if (++rendered == kStressWarmUpFrames) {
+          profiler.ResetSummary();
+          allocs_before = goya::GlobalAllocTracker().Totals();
+        }
+      });
+
+      engine.Run();
+
+      auto const allocs_after = goya::GlobalAllocTracker().Totals();
+      auto const totals = profiler.SummaryTotals();
+
+      auto const& all_frames = engine.FrameTimes();
+      auto const warm_up = std::min(
+          all_frames.size(), static_cast<std::size_t>(kStressWarmUpFrames));
+      auto const frames = std::vector<float>(
+          all_frames.begin() + static_cast<std::ptrdiff_t>(warm_up),
+          all_frames.end());
+      auto const n_frames =
+          static_cast<double>(std::max(frames.size(), std::size_t(1U)));
+
+      auto const zone_ms = [&](char const* name) -> double {
+        auto total_ns = std::uint64_t(0U);
+        for (auto const& zone : totals) {
+          if (zone.kind == goya::ProfileEventKind::kCpuZone &&
+              zone.name == name) {
+            total_ns += zone.total_ns;
+          }
+        }
+
+        return static_cast<double>(total_ns) * 1e-6 / n_frames;
+      };
+
+      auto gpu_ns = std::uint64_t(0U);
+      for (auto const& zone : totals) {
+        if (zone.kind == goya::ProfileEventKind::kGpuZone) {
+          gpu_ns += zone.total_ns;
+        }
+      }
+
+      auto const frame_total =
+          std::accumulate(frames.begin(), frames.end(), 0.0);
+
+      csv << n_models << ',' << n_effects << ','
+          << options.stress_particles << ',' << options.stress_followers
+          << ',' << options.stress_props << ',' << frames.size() << ','
+          << frame_total / n_frames << ',' << Percentile(frames, 0.5) << ','
+          << Percentile(frames, 0.95) << ',' << Percentile(frames, 0.99)
+          << ',' << Percentile(frames, 1.0);
+      for (auto const& [column, zone] : kStressZones) {
+        csv << ',' << zone_ms(zone);
+      }
+      csv << ',' << static_cast<double>(gpu_ns) * 1e-6 / n_frames << ','
+          << static_cast<double>(allocs_after.allocations -
+                                 allocs_before.allocations) /
+                 n_frames
+          << ','
+          << static_cast<double>(allocs_after.bytes - allocs_before.bytes) /
+                 n_frames
+          << ','
+          << static_cast<double>(ResidentBytes()) / (1024.0 * 1024.0)
+          << std::endl;
+
+      std::cout << "[goya] stress models " << n_models << " effects "
+                << n_effects << " mean " << frame_total / n_frames << " ms"
+                << std::endl;
+    }
+  }
+}
+
+}  // namespace detail
+
 int main(int argc, char** argv) {
   try {
-    if (argc != 3) {
-      throw std::runtime_error(
-          "[goya] please supply two command line arguments. Path to model, "
-          "path to spline control points");
+    auto const options = detail::ParseOptions(argc, argv);
+    if (options.stress) {
+      detail::RunStress(options);
+      return EXIT_SUCCESS;
     }
 
-    auto model_path = argv[1];
-    auto spline_path = argv[2];
+    auto& profiler = goya::GlobalProfiler();
+    profiler.SetEnabled(options.profile || !options.trace_path.empty());
+    profiler.SetCapture(!options.trace_path.empty());
+    if (options.profile) {
+      profiler.SetSummaryInterval(1.0);
+    }
 
-    auto win = goya::Window(1080, 720, "Goya");
+    auto const& model_path = options.model_path;
+    auto const& spline_path = options.spline_path;
+
+    auto win = goya::Window(1080, 720, "Goya",
+                            options.headless ? goya::WindowMode::kHeadless
+                                             : goya::WindowMode::kWindowed);
 
     auto model_shader =
         std::make_shared<goya::Shader>("shaders/model.vs", "shaders/model.fs");
     auto particle_shader = std::make_shared<goya::Shader>(
         "shaders/particle.vs", "shaders/particle.fs");
 
-    auto mesh =
-        std::make_shared<goya::MeshTriangle>(goya::LoadMeshObjData(model_path));
-    auto model = goya::Model(model_shader, std::move(mesh));
+    // static geometry comes from one arena, exact for a triangulated model
+    // and grown otherwise
+    auto const model_obj = goya::LoadMeshObjData(model_path);
+    auto arena =
+        std::make_shared<goya::GeometryArena>(model_obj.faces.size() * 3U);
+    auto mesh = std::make_shared<goya::ArenaMesh>(arena, model_obj);
+    auto model = std::make_shared<goya::Model>(model_shader, std::move(mesh));
+
+    auto scene = goya::Scene();
+    scene.Add(model);
+
+    // without --stream the whole trajectory stays resident
+    auto const trajectory =
+        std::make_shared<goya::TrajectorySource const>(spline_path);
+    auto const window = options.stream
+                            ? goya::SplineStream::kDefaultWindow
+                            : std::max(trajectory->Size(),
+                                       goya::SplineStream::kDefaultWindow);
+    auto stream = goya::SplineStream(trajectory, model_shader, window);
+    auto& spline = stream.Spline();
+    spline.SetSpeed(options.speed);
+
+    // a replay runs with the seed of its recording
+    auto replay = std::unique_ptr<goya::InputReplay>();
+    auto seed = options.seed;
+    if (!options.replay_path.empty()) {
+      replay = std::make_unique<goya::InputReplay>(options.replay_path);
+      seed = replay->Seeds().empty() ? seed : replay->Seeds()[0];
+    }
 
-    auto spline =
-        goya::CubeBSpline(goya::LoadControloPoints(spline_path), model_shader);
+    auto recorder = std::unique_ptr<goya::InputRecorder>();
+    if (!options.record_path.empty()) {
+      recorder = std::make_unique<goya::InputRecorder>(
+          options.record_path, std::vector<std::uint64_t>{seed});
+    }
 
-    auto rng_gen = std::ranlux24_base(42);
+    auto rng_gen =
+        std::ranlux24_base(static_cast<std::ranlux24_base::result_type>(seed));
     auto weak_dis = std::uniform_real_distribution<float>(0.33f, 3.14f);
     auto strog_dis = std::uniform_real_distribution<float>(2.24f, 4.2f);
 
@@ -70,8 +582,9 @@ int main(int argc, char** argv) {
     auto spline_center = spline.CenterCoord();
     auto camera_pos = goya::Vertex3d(10.f, 3.33f, 15.f);
 
-    auto projection =
-        glm::perspective(glm::radians(90.f), win.AspectRatio(), 0.1f, 200.f);
+    auto constexpr kFarPlane = 200.f;
+    auto projection = glm::perspective(glm::radians(90.f), win.AspectRatio(),
+                                       0.1f, kFarPlane);
 
     auto camera = goya::Camera(camera_pos, glm::normalize(-spline_center),
                                glm::vec3(0.f, 1.f, 0.f), projection);
@@ -84,45 +597,169 @@ int main(int argc, char** argv) {
                                static_cast<float>(e.height));
     });
 
-    win.AddKeyHandler([&](goya::KeyEvent e, goya::TimeType delta) -> void {
-      if (e.glfw_key_action) {
-        switch (e.glfw_key_code) {
-          case GLFW_KEY_W:
-            camera.MoveFront(delta);
-            break;
-          case GLFW_KEY_S:
-            camera.MoveBack(delta);
-            break;
-          case GLFW_KEY_A:
-            camera.MoveLeft(delta);
-            break;
-          case GLFW_KEY_D:
-            camera.MoveRight(delta);
-            break;
-        }
+    auto flythrough = std::unique_ptr<goya::CameraPath>();
+    if (!options.flythrough_path.empty()) {
+      flythrough = std::make_unique<goya::CameraPath>(
+          goya::LoadControloPoints(options.flythrough_path));
+    }
+
+    // held keys move the camera by the time between two polls, however many
+    // repeat events the os sent in between
+    auto const move_camera = [&]() -> void {
+      auto const& input = win.Input();
+      auto const delta = win.PollDelta();
+
+      if (input.IsDown(GLFW_KEY_W)) {
+        camera.MoveFront(delta);
+      }
+      if (input.IsDown(GLFW_KEY_S)) {
+        camera.MoveBack(delta);
+      }
+      if (input.IsDown(GLFW_KEY_A)) {
+        camera.MoveLeft(delta);
+      }
+      if (input.IsDown(GLFW_KEY_D)) {
+        camera.MoveRight(delta);
       }
-    });
 
-    win.AddCursorHandler(
-        [&camera, xy = win.CursorPosition()](
-            goya::CursorEvent e, goya::TimeType delta) mutable -> void {
-          camera.ShiftLook(static_cast<float>(e.x_pos - xy.first),
-                           static_cast<float>(e.y_pos - xy.second), delta);
+      auto const [dx, dy] = input.CursorDelta();
+      if (dx != 0.0 || dy != 0.0) {
+        camera.ShiftLook(static_cast<float>(dx), static_cast<float>(dy),
+                         delta);
+      }
+    };
 
-          xy = {e.x_pos, e.y_pos};
+    auto engine_config = goya::EngineConfig();
+    engine_config.max_frames = options.frames;
+    engine_config.fixed_delta = options.dt;
+    engine_config.input_sampling = options.input_sampling;
+    engine_config.frame_limit = options.frame_limit;
+    engine_config.max_queued_frames = options.max_queued;
+    if (options.dt > 0.f) {
+      // one fixed step per frame keeps runs deterministic
+      engine_config.simulation_mode = goya::SimulationMode::kInline;
+    }
+    if (options.fixed_step || recorder || replay) {
+      engine_config.simulation_mode = goya::SimulationMode::kFixedStep;
+    }
+    if (stream.IsStreaming() &&
+        engine_config.simulation_mode == goya::SimulationMode::kThreaded) {
+      // sliding the window edits the spline the render thread submits
+      engine_config.simulation_mode = goya::SimulationMode::kInline;
+    }
+
+    auto engine = goya::Engine(win, engine_config);
+    engine.SetRecorder(recorder.get());
+    engine.SetReplay(replay.get());
+
+    // simulation thread, only touches the spline and particle state. new
+    // particles are sourced from the spline, so they wait for it to advance
+    auto const spline_task = engine.AddSimulationHandler(
+        [&](goya::TimeType delta, goya::FrameSnapshot& snapshot) -> void {
+          stream.TimeUpdate(delta, engine.Jobs());
+
+          snapshot.transforms.resize(1U);
+          snapshot.transforms[0] = spline.ModelMatrix();
         });
 
-    win.AddAnimationHandler([&](goya::TimeType delta) -> void {
-      spline.TimeUpdate(delta);
-      model.SetModelMatrix(spline.ModelMatrix());
-      particle_effect->Update(delta);
+    engine.AddSimulationHandler(
+        [&](goya::TimeType delta, goya::FrameSnapshot& snapshot) -> void {
+          particle_effect->Update(delta, engine.Jobs());
+
+          snapshot.particles.resize(1U);
+          particle_effect->Capture(snapshot.particles[0]);
+        },
+        {spline_task});
+
+    auto render_queue = goya::RenderQueue();
+    engine.AddRenderHandler([&](goya::FrameSnapshot const& snapshot) -> void {
+      if (flythrough) {
+        // the view of frame i only depends on i, not on the frame times
+        auto const last = std::max(options.frames, std::uint64_t(2U)) - 1U;
+        flythrough->Apply(camera, static_cast<float>(engine.RenderFrames()) /
+                                      static_cast<float>(last));
+      } else {
+        // input was just polled, the view of this frame already shows it
+        move_camera();
+        camera.Refresh();
+      }
+      model->SetModelMatrix(goya::InterpolatedTransform(snapshot, 0U));
+
+      // culling is cpu only and overlaps with the particle upload
+      auto cull = goya::TaskGroup();
+      engine.Jobs().Spawn(cull, [&]() -> void {
+        scene.Update();
+        scene.Cull(camera);
+      });
+
+      particle_effect->Upload(snapshot.particles[0]);
+      engine.Jobs().Wait(cull);
+
+      render_queue.SetView(camera.Position(), camera.Front(), kFarPlane);
+      particle_effect->Submit(render_queue);
+      scene.Submit(render_queue);
+      spline.Submit(render_queue);
+
+      render_queue.Execute();
     });
 
-    while (win.Refresh()) {
-      particle_effect->Draw();
-      model.Draw();
-      spline.Draw();
-      camera.Refresh();
+    // encoders get their own workers, a simulation waiting on its jobs would
+    // otherwise help out with a whole frame's encode
+    auto capture_jobs = std::unique_ptr<goya::JobSystem>();
+    auto capture = std::unique_ptr<goya::FrameCapture>();
+    if (!options.capture_dir.empty()) {
+      auto capture_config = goya::CaptureConfig();
+      capture_config.directory = options.capture_dir;
+      capture_config.format = options.capture_format;
+      capture_config.lag = options.capture_lag;
+
+      capture_jobs = std::make_unique<goya::JobSystem>(
+          detail::kCaptureWorkers);
+      capture = std::make_unique<goya::FrameCapture>(
+          win.Width(), win.Height(), capture_config, *capture_jobs);
+      engine.AddRenderHandler(
+          [&](goya::FrameSnapshot const&) -> void { capture->Capture(); });
+    }
+
+    auto const run_start = std::chrono::steady_clock::now();
+    engine.Run();
+    if (capture) {
+      capture->Finish();
+    }
+    auto const run_seconds = std::chrono::duration<double>(
+                                 std::chrono::steady_clock::now() - run_start)
+                                 .count();
+
+    if (options.headless || options.frames != 0U) {
+      detail::PrintFrameTimes(engine.FrameTimes());
+      detail::PrintFramePercentiles(engine.FrameTimes());
+      detail::PrintInputLatencies(engine.InputLatencies());
+    }
+
+    if (capture) {
+      std::cout << "captured " << capture->Frames() << " frames to "
+                << options.capture_dir << ", " << capture->Stalls()
+                << " stalled" << std::endl;
+    }
+
+    if (replay) {
+      std::cout << "replayed " << replay->Frames() << " frames, "
+                << replay->Duration() << " s of session in " << run_seconds
+                << " s" << std::endl;
+    }
+
+    if (recorder || replay) {
+      // equal in a recording and its replays
+      auto const eye = camera.Position();
+      auto const point = spline.SplineCoord();
+      std::cout << std::setprecision(9) << "final camera " << eye.x << ' '
+                << eye.y << ' ' << eye.z << " spline " << point.x << ' '
+                << point.y << ' ' << point.z << " steps "
+                << engine.SimulationFrames() << std::endl;
+    }
+
+    if (!options.trace_path.empty()) {
+      profiler.WriteChromeTrace(options.trace_path);
     }
 
   } catch (std::exception const& e) {